@@ -0,0 +1,150 @@
+/******************************************************//**
+ * @file    fastGpio.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Compile-time pin to port GPIO access for the Arduino Uno
+ *          (ATmega328P). The pin number is a template argument, so
+ *          the port register and bit mask are resolved by the compiler
+ *          and each access is a single sbi/cbi/sbic instruction
+ *          instead of the pin table lookups of digitalRead/digitalWrite.
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __FAST_GPIO_H_INCLUDED
+#define __FAST_GPIO_H_INCLUDED
+
+#include <Arduino.h>
+
+/// Ports of the Uno digital pins: D = 0..7, B = 8..13, C = 14..19 (A0..A5)
+typedef enum {
+  FAST_GPIO_PORT_D = 0,
+  FAST_GPIO_PORT_B,
+  FAST_GPIO_PORT_C
+} fastGpioPort_t;
+
+/// FastGpio library class, one type per pin
+template <uint8_t pin>
+class FastGpio
+{
+  public:
+    static_assert(pin < 20, "FastGpio pin must be an Arduino Uno digital pin (0..19)");
+
+    static constexpr fastGpioPort_t Port()  //Port the pin belongs to
+    {
+      return pin < 8 ? FAST_GPIO_PORT_D : (pin < 14 ? FAST_GPIO_PORT_B : FAST_GPIO_PORT_C);
+    }
+
+    static constexpr uint8_t Mask()         //Bit mask of the pin within its port
+    {
+      return _BV(pin < 8 ? pin : (pin < 14 ? pin - 8 : pin - 14));
+    }
+
+    static inline uint8_t Read() __attribute__((always_inline));       //Return HIGH or LOW
+    static inline void Write(uint8_t level) __attribute__((always_inline)); //Drive HIGH or LOW
+    static inline void High() __attribute__((always_inline));          //Drive HIGH
+    static inline void Low() __attribute__((always_inline));           //Drive LOW
+
+  private:
+    static inline volatile uint8_t &PinReg()
+    {
+      return Port() == FAST_GPIO_PORT_D ? PIND : (Port() == FAST_GPIO_PORT_B ? PINB : PINC);
+    }
+
+    static inline volatile uint8_t &PortReg()
+    {
+      return Port() == FAST_GPIO_PORT_D ? PORTD : (Port() == FAST_GPIO_PORT_B ? PORTB : PORTC);
+    }
+};
+
+/* On the host the port registers are plain memory with no side effects, so
+ * go through the HAL to keep the pin levels and the device models in step. */
+#ifdef HOST_HAL
+
+template <uint8_t pin>
+uint8_t FastGpio<pin>::Read()
+{
+  return digitalRead(pin);
+}
+
+template <uint8_t pin>
+void FastGpio<pin>::Write(uint8_t level)
+{
+  digitalWrite(pin, level);
+}
+
+template <uint8_t pin>
+void FastGpio<pin>::High()
+{
+  digitalWrite(pin, HIGH);
+}
+
+template <uint8_t pin>
+void FastGpio<pin>::Low()
+{
+  digitalWrite(pin, LOW);
+}
+
+#else
+
+/******************************************************//**
+ * @brief  Reads the pin from its PINx register
+ * @param  None
+ * @retval HIGH or LOW
+ **********************************************************/
+template <uint8_t pin>
+uint8_t FastGpio<pin>::Read()
+{
+  return (PinReg() & Mask()) ? HIGH : LOW;
+}
+
+/******************************************************//**
+ * @brief  Drives the pin through its PORTx register. PORTB,
+ * PORTC and PORTD are in the bit addressable I/O space, so with
+ * a constant mask the read-modify-write is one sbi/cbi and
+ * cannot be torn by an interrupt.
+ * @param  level HIGH or LOW
+ * @retval None
+ **********************************************************/
+template <uint8_t pin>
+void FastGpio<pin>::Write(uint8_t level)
+{
+  if (level)
+  {
+    PortReg() |= Mask();
+  }
+  else
+  {
+    PortReg() &= (uint8_t)~Mask();
+  }
+}
+
+/******************************************************//**
+ * @brief  Drives the pin HIGH
+ * @param  None
+ * @retval None
+ **********************************************************/
+template <uint8_t pin>
+void FastGpio<pin>::High()
+{
+  PortReg() |= Mask();
+}
+
+/******************************************************//**
+ * @brief  Drives the pin LOW
+ * @param  None
+ * @retval None
+ **********************************************************/
+template <uint8_t pin>
+void FastGpio<pin>::Low()
+{
+  PortReg() &= (uint8_t)~Mask();
+}
+
+#endif /* #ifdef HOST_HAL */
+
+#endif /* #ifndef __FAST_GPIO_H_INCLUDED */
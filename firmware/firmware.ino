@@ -3,33 +3,190 @@
 #include "stepperMotor.h"
 #include "pendulum.h"
 
-#define ENCODER_CW_PIN 2  // Green wire
-#define ENCODER_CCW_PIN 3 // White wire
+/// Set to 1 to time the Pendulum getters on the board and print the cycles per call
+#define Bench_Pendulum_Getters  (0)
+#define Bench_Pendulum_Calls    (1000)
+
+/// sqrt(g/l) of the 30cm pendulum in rad/s, scales the energy estimate
+#define Pendulum_Natural_Frequency (5.72)
+
+/// Set to 1 to identify the pendulum from a free swing after a push at power up. The swing is
+/// printed as "seconds degrees-from-rest" lines, which host/simIdentify fits again from a file.
+#define Identify_Free_Swing     (0)
+#define Identify_Log_Ms         (20)
 
 StepperMotor stepperMotor(1.8f, STEP_QUARTER);
-Pendulum pendulum(360);
+Pendulum<360> pendulum;
 
 int32_t position = 0;
 int32_t velocity;
 int32_t acceleration;
 unsigned long tmp = millis();
+
+#if Bench_Pendulum_Getters
+volatile float floatSink;
+volatile int32_t fixedSink;
+
+/* Prints the cycles per call of a timed loop, less the loop itself */
+void PrintCycles(const char *name, unsigned long elapsedUs, unsigned long loopUs)
+{
+  Serial.print(name);
+  Serial.println((float)(elapsedUs - loopUs) * (F_CPU / 1000000L) / Bench_Pendulum_Calls);
+}
+
+/* Float getters against the Q16 ones, the control loop reads one of each pair */
+void BenchPendulumGetters()
+{
+  unsigned long start;
+  unsigned long loopUs;
+  int i;
+
+  start = micros();
+  for (i = 0; i < Bench_Pendulum_Calls; i++)
+  {
+    fixedSink = i;
+  }
+  loopUs = micros() - start;
+
+  start = micros();
+  for (i = 0; i < Bench_Pendulum_Calls; i++)
+  {
+    floatSink = pendulum.GetCurrentPositionRad() + pendulum.GetCurrentVelocityRad();
+  }
+  PrintCycles("position + velocity, float rad: ", micros() - start, loopUs);
+
+  start = micros();
+  for (i = 0; i < Bench_Pendulum_Calls; i++)
+  {
+    fixedSink = pendulum.GetCurrentPositionQ16().Raw() + pendulum.GetCurrentVelocityQ16().Raw();
+  }
+  PrintCycles("position + velocity, Q16 rad:   ", micros() - start, loopUs);
+
+  start = micros();
+  for (i = 0; i < Bench_Pendulum_Calls; i++)
+  {
+    pendulumState_t state = pendulum.GetStateRad();
+    floatSink = state.position + state.velocity;
+  }
+  PrintCycles("GetStateRad:                    ", micros() - start, loopUs);
+
+  start = micros();
+  for (i = 0; i < Bench_Pendulum_Calls; i++)
+  {
+    pendulumStateQ16_t state = pendulum.GetStateQ16();
+    fixedSink = state.position.Raw() + state.velocity.Raw();
+  }
+  PrintCycles("GetStateQ16:                    ", micros() - start, loopUs);
+
+  start = micros();
+  for (i = 0; i < Bench_Pendulum_Calls; i++)
+  {
+    floatSink = cos((float)(i % 360) * pendulum.RadiansPerCount());
+  }
+  PrintCycles("cos(), float:                   ", micros() - start, loopUs);
+
+  start = micros();
+  for (i = 0; i < Bench_Pendulum_Calls; i++)
+  {
+    fixedSink = pendulum.CosQ15(i % 360);
+  }
+  PrintCycles("CosQ15 table read:              ", micros() - start, loopUs);
+
+  start = micros();
+  for (i = 0; i < Bench_Pendulum_Calls; i++)
+  {
+    pendulumState_t state = pendulum.GetUprightStateRad();
+    floatSink = 0.5 * state.velocity * state.velocity +
+                Pendulum_Natural_Frequency * Pendulum_Natural_Frequency * (cos(state.position) - 1.0);
+  }
+  PrintCycles("energy, float and cos():        ", micros() - start, loopUs);
+
+  start = micros();
+  for (i = 0; i < Bench_Pendulum_Calls; i++)
+  {
+    fixedSink = pendulum.GetEnergyQ16().Raw();
+  }
+  PrintCycles("GetEnergyQ16:                   ", micros() - start, loopUs);
+}
+#endif
+
+#if Identify_Free_Swing
+/* Waits for a push, fits the free swing and prints it, then the fitted parameters */
+void IdentifyFreeSwing()
+{
+  Serial.print("# Push the pendulum more than ");
+  Serial.print(Pendulum_Free_Decay_Start_Deg);
+  Serial.println(" deg and let it swing");
+  pendulum.StartFreeDecay();
+
+  unsigned long logTime = millis();
+  unsigned long start = 0;
+  freeDecayStatus_t status = FREE_DECAY_WAITING;
+  while (status == FREE_DECAY_WAITING || status == FREE_DECAY_RECORDING)
+  {
+    status = pendulum.UpdateFreeDecay();
+    if (status == FREE_DECAY_RECORDING && millis() - logTime >= Identify_Log_Ms)
+    {
+      logTime += Identify_Log_Ms;
+      start = start == 0 ? logTime : start;
+      float degrees = pendulum.GetCurrentPositionDeg() - pendulum.GetRestPosition() * pendulum.DegreesPerCount();
+      degrees = degrees > 180.0 ? degrees - 360.0 : (degrees <= -180.0 ? degrees + 360.0 : degrees);
+      Serial.print((logTime - start) / 1000.0, 3);
+      Serial.print(' ');
+      Serial.println(degrees, 2);
+    }
+    else if (status == FREE_DECAY_WAITING)
+    {
+      logTime = millis();
+    }
+  }
+
+  freeDecayResult_t result;
+  if (pendulum.GetFreeDecayResult(result))
+  {
+    Serial.print("# wn rad/s ");
+    Serial.print(result.naturalFrequency, 3);
+    Serial.print(" zeta ");
+    Serial.print(result.dampingRatio, 5);
+    Serial.print(" length m ");
+    Serial.println(result.effectiveLength, 4);
+  }
+  else
+  {
+    Serial.println("# The swing died out before the fit had enough half swings");
+  }
+}
+#endif
   
 void setup()
 {
 
 // //----- Init
 
-//   // Must initialize this first as pendulum disables and takes over some interrupt pins
+  /* Start the motor driver. Driver faults are reported from the L6474 FLAG interrupt on pin 2,
+   * see StepperMotor::GetFaults. */
   stepperMotor.Begin();
 
-  /* Start the library to use the quadrature encoder. This library is configured to only support
-   * one encoder per application. The quadrature initialization step occupies the following pins
-   * on the Arduino Uno defined in quadratureEncoder.h: 2 and 3. */
+  /* Start the library to use the quadrature encoder. The pendulum encoder occupies the following
+   * pins on the Arduino Uno defined in quadratureEncoder.h: A2 and A3 (pin change interrupt). */
   pendulum.Begin();
+  pendulum.SetNaturalFrequency(Pendulum_Natural_Frequency);
   position = pendulum.GetCurrentPositionDeg();
   velocity = pendulum.GetCurrentVelocityDeg();
 
   Serial.begin(9600); 
+#if Bench_Pendulum_Getters
+  BenchPendulumGetters();
+#endif
+
+  /* Learn where the pendulum hangs, so the angle from upright does not depend on where it was at power up */
+  if (!pendulum.CalibrateRest())
+  {
+    Serial.println("Pendulum did not settle, angle from upright is relative to the power up position");
+  }
+#if Identify_Free_Swing
+  IdentifyFreeSwing();
+#endif
 
   // //TODO list:
   // // modify the shield code to have AndStop methods or toggle 
@@ -0,0 +1,213 @@
+/******************************************************//**
+ * @file    fixedPoint.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Fixed-point angle, angular velocity, angular
+ *          acceleration, time and energy in Q16.16 with saturating
+ *          arithmetic. Each quantity is its own type, so adding an
+ *          angle to a velocity or passing degrees where radians/s
+ *          are expected does not compile, and the control path
+ *          needs no soft-float on the AVR.
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __FIXED_POINT_H_INCLUDED
+#define __FIXED_POINT_H_INCLUDED
+
+#include <Arduino.h>
+
+/// One in Q16.16
+#define Fixed_Q16_One  (65536L)
+
+/// Scale factor applied as (value * mantissa) >> shift with a 64-bit product, see FixedScale()
+typedef struct {
+  int32_t mantissa;
+  uint8_t shift;
+} fixedScale_t;
+
+/// Unit tags, one type per quantity so quantities of different units do not mix
+typedef struct {} angleUnit_t;                //Radians
+typedef struct {} angularVelocityUnit_t;      //Radians/s
+typedef struct {} angularAccelerationUnit_t;  //Radians/s^2
+typedef struct {} timeUnit_t;                 //Seconds
+typedef struct {} energyUnit_t;               //Energy per moment of inertia, radians^2/s^2
+
+/******************************************************//**
+ * @brief  Limits a 64-bit intermediate to the int32_t range
+ * @param  value Result before saturation
+ * @retval value clamped to INT32_MIN..INT32_MAX
+ **********************************************************/
+inline int32_t SaturateQ16(int64_t value)
+{
+  return value > INT32_MAX ? INT32_MAX : (value < INT32_MIN ? INT32_MIN : (int32_t)value);
+}
+
+/******************************************************//**
+ * @brief  Adds two int32_t values, clamping instead of wrapping.
+ * The sum overflows only when both have the same sign and the
+ * wrapped sum has the other one.
+ * @param  a First value
+ * @param  b Second value
+ * @retval a + b clamped to INT32_MIN..INT32_MAX
+ **********************************************************/
+inline int32_t AddSaturated(int32_t a, int32_t b)
+{
+  int32_t sum = (int32_t)((uint32_t)a + (uint32_t)b);
+  if (((a ^ sum) & (b ^ sum)) < 0)
+  {
+    return a < 0 ? INT32_MIN : INT32_MAX;
+  }
+  return sum;
+}
+
+/******************************************************//**
+ * @brief  Applies a scale factor made by FixedScale
+ * @param  value Value to scale
+ * @param  scale Scale factor
+ * @retval value * factor, rounded to nearest and saturated
+ **********************************************************/
+inline int32_t ApplyScale(int32_t value, fixedScale_t scale)
+{
+  int64_t product = (int64_t)value * scale.mantissa;
+  return SaturateQ16(scale.shift == 0 ? product : (product + ((int64_t)1 << (scale.shift - 1))) >> scale.shift);
+}
+
+/******************************************************//**
+ * @brief  Turns a factor into a mantissa of 30 bits and a shift,
+ * so ApplyScale keeps the precision of the float factor at any
+ * magnitude. Done once when a driver is constructed; this is the
+ * only float in the conversion.
+ * @param  factor Scale factor, below 2^30 in magnitude
+ * @retval mantissa and shift
+ **********************************************************/
+inline fixedScale_t FixedScale(float factor)
+{
+  fixedScale_t scale;
+  float magnitude = factor < 0.0f ? -factor : factor;
+  scale.shift = 0;
+  while (scale.shift < 62 && magnitude * 2.0f < 1073741824.0f && magnitude != 0.0f)
+  {
+    magnitude *= 2.0f;
+    scale.shift++;
+  }
+  scale.mantissa = (int32_t)(magnitude + 0.5f) * (factor < 0.0f ? -1 : 1);
+  return scale;
+}
+
+/// Q16.16 quantity of one unit. Raw values only go in through FromRaw, so a bare integer is never taken for a quantity.
+template <class unit>
+class FixedQ16
+{
+  public:
+    constexpr FixedQ16() : raw(0) {}                        //Zero
+
+    static constexpr FixedQ16 FromRaw(int32_t value)        //Quantity from its Q16.16 value
+    {
+      return FixedQ16(value);
+    }
+
+    static constexpr FixedQ16 FromFloat(double value)       //Quantity in the base unit (rad, rad/s, rad/s^2, s), rounded and saturated
+    {
+      return FixedQ16(value * Fixed_Q16_One >= 2147483647.0 ? INT32_MAX :
+                      (value * Fixed_Q16_One <= -2147483648.0 ? INT32_MIN :
+                      (int32_t)(value * Fixed_Q16_One + (value < 0.0 ? -0.5 : 0.5))));
+    }
+
+    static constexpr FixedQ16 FromDegrees(double value)     //Angular quantity given in degrees
+    {
+      return FromFloat(value * DEG_TO_RAD);
+    }
+
+    constexpr int32_t Raw() const                           //Q16.16 value
+    {
+      return raw;
+    }
+
+    float ToFloat() const                                   //Value in the base unit, for display and host checks
+    {
+      return (float)raw * (1.0f / Fixed_Q16_One);
+    }
+
+    float ToDegrees() const                                 //Angular value in degrees
+    {
+      return (float)raw * (float)(RAD_TO_DEG / Fixed_Q16_One);
+    }
+
+    FixedQ16 operator+(FixedQ16 other) const                //Saturating sum
+    {
+      return FixedQ16(AddSaturated(raw, other.raw));
+    }
+
+    FixedQ16 operator-(FixedQ16 other) const                //Saturating difference
+    {
+      return FixedQ16(AddSaturated(raw, other.raw == INT32_MIN ? INT32_MAX : -other.raw));
+    }
+
+    FixedQ16 operator-() const                              //Saturating negation
+    {
+      return FixedQ16(raw == INT32_MIN ? INT32_MAX : -raw);
+    }
+
+    FixedQ16 &operator+=(FixedQ16 other)
+    {
+      raw = AddSaturated(raw, other.raw);
+      return *this;
+    }
+
+    FixedQ16 &operator-=(FixedQ16 other)
+    {
+      *this = *this - other;
+      return *this;
+    }
+
+    FixedQ16 Scale(int32_t factorQ16) const                 //Saturating product with a unitless Q16.16 factor
+    {
+      return FixedQ16(SaturateQ16(((int64_t)raw * factorQ16) >> 16));
+    }
+
+    bool operator==(FixedQ16 other) const { return raw == other.raw; }
+    bool operator!=(FixedQ16 other) const { return raw != other.raw; }
+    bool operator<(FixedQ16 other) const { return raw < other.raw; }
+    bool operator>(FixedQ16 other) const { return raw > other.raw; }
+    bool operator<=(FixedQ16 other) const { return raw <= other.raw; }
+    bool operator>=(FixedQ16 other) const { return raw >= other.raw; }
+
+  private:
+    explicit constexpr FixedQ16(int32_t value) : raw(value) {}
+    int32_t raw;
+};
+
+typedef FixedQ16<angleUnit_t> angleQ16_t;                             //Radians in Q16.16
+typedef FixedQ16<angularVelocityUnit_t> angularVelocityQ16_t;         //Radians/s in Q16.16
+typedef FixedQ16<angularAccelerationUnit_t> angularAccelerationQ16_t; //Radians/s^2 in Q16.16
+typedef FixedQ16<timeUnit_t> timeQ16_t;                               //Seconds in Q16.16
+typedef FixedQ16<energyUnit_t> energyQ16_t;                           //Radians^2/s^2 in Q16.16
+
+/******************************************************//**
+ * @brief  Angle covered at a velocity in a time
+ * @param  velocity Angular velocity
+ * @param  time Time
+ * @retval velocity * time, saturated
+ **********************************************************/
+inline angleQ16_t operator*(angularVelocityQ16_t velocity, timeQ16_t time)
+{
+  return angleQ16_t::FromRaw(SaturateQ16(((int64_t)velocity.Raw() * time.Raw()) >> 16));
+}
+
+/******************************************************//**
+ * @brief  Velocity gained at an acceleration in a time
+ * @param  acceleration Angular acceleration
+ * @param  time Time
+ * @retval acceleration * time, saturated
+ **********************************************************/
+inline angularVelocityQ16_t operator*(angularAccelerationQ16_t acceleration, timeQ16_t time)
+{
+  return angularVelocityQ16_t::FromRaw(SaturateQ16(((int64_t)acceleration.Raw() * time.Raw()) >> 16));
+}
+
+#endif /* #ifndef __FIXED_POINT_H_INCLUDED */
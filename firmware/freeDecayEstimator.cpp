@@ -0,0 +1,168 @@
+/******************************************************//**
+ * @file    freeDecayEstimator.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Online fit of the natural frequency, damping ratio and
+ *          effective length of a pendulum from a free decay
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "freeDecayEstimator.h"
+
+/******************************************************//**
+ * @brief  Constructor for the FreeDecayEstimator object
+ * @param  None
+ * @retval None
+ **********************************************************/
+FreeDecayEstimator::FreeDecayEstimator()
+{
+  Reset();
+}
+
+/******************************************************//**
+ * @brief  Forgets every sample and starts a new fit
+ * @param  resolution Angle of one step of the samples in radians,
+ * the angle of one encoder count, or 0 for unquantised samples.
+ * A half swing peaks on average half a step past the largest
+ * sample, so half of it is added to every peak.
+ * @retval None
+ **********************************************************/
+void FreeDecayEstimator::Reset(float resolution)
+{
+  this->resolution = resolution;
+  started = false;
+  lastSeconds = 0.0;
+  lastAngle = 0.0;
+  crossings = 0;
+  lastCrossing = 0.0;
+  correctedTime = 0.0;
+  peak = 0.0;
+  lastAmplitude = 0.0;
+  memset(&timeFit, 0, sizeof(timeFit));
+  memset(&decayFit, 0, sizeof(decayFit));
+}
+
+/******************************************************//**
+ * @brief  Adds one sample of the swing. Each zero crossing is
+ * timed by linear interpolation between the samples either side
+ * of it, and the largest angle between two crossings is the peak
+ * of that half swing. A half swing of peak A lasts 1 + A^2/16
+ * times longer than a small one, so its length is divided by that
+ * before it goes into the period fit, and the amplitudes of large
+ * and small swings give the same frequency.
+ * @param  seconds Time of the sample, increasing
+ * @param  angle Angle from the rest position in radians
+ * @retval None
+ **********************************************************/
+void FreeDecayEstimator::AddSample(float seconds, float angle)
+{
+  if (angle == 0.0f)
+  {
+    return;
+  }
+
+  if (started && (angle > 0.0f) != (lastAngle > 0.0f))
+  {
+    float crossing = lastSeconds + (seconds - lastSeconds) * lastAngle / (lastAngle - angle);
+    if (crossings > 0)
+    {
+      /* The half swing between the last two crossings is complete */
+      lastAmplitude = peak + 0.5f * resolution;
+      correctedTime += (crossing - lastCrossing) / (1.0f + lastAmplitude * lastAmplitude / 16.0f);
+      AddPoint(decayFit, crossings - 1, log(lastAmplitude));
+    }
+    AddPoint(timeFit, crossings, correctedTime);
+    if (crossings < 255)
+    {
+      crossings++;
+    }
+    lastCrossing = crossing;
+    peak = 0.0;
+  }
+
+  peak = fabs(angle) > peak ? fabs(angle) : peak;
+  lastSeconds = seconds;
+  lastAngle = angle;
+  started = true;
+}
+
+/******************************************************//**
+ * @brief  Returns the half swings between two crossings fitted
+ * so far
+ * @param  None
+ * @retval half swings
+ **********************************************************/
+uint8_t FreeDecayEstimator::GetHalfCycles()
+{
+  return crossings > 0 ? crossings - 1 : 0;
+}
+
+/******************************************************//**
+ * @brief  Returns the peak of the last complete half swing,
+ * so the caller can stop once the swing is too small to time
+ * @param  None
+ * @retval peak angle in radians, 0 before the first half swing
+ **********************************************************/
+float FreeDecayEstimator::GetLastAmplitude()
+{
+  return lastAmplitude;
+}
+
+/******************************************************//**
+ * @brief  Returns the pendulum parameters of the fit. The slope
+ * of the crossing times is half the damped period and the slope
+ * of the log peaks is the decay over half a period, which give
+ * the damped frequency wd and the decay rate s = zeta wn. Then
+ * wn = sqrt(wd^2 + s^2), zeta = s / wn and the effective length
+ * is g / wn^2.
+ * @param  result Fitted parameters
+ * @retval true if at least Free_Decay_Min_Half_Cycles half swings
+ * were fitted, else false and result is unchanged
+ **********************************************************/
+bool FreeDecayEstimator::GetResult(freeDecayResult_t &result)
+{
+  if (GetHalfCycles() < Free_Decay_Min_Half_Cycles)
+  {
+    return false;
+  }
+
+  float halfPeriod = Slope(timeFit);
+  float dampedFrequency = PI / halfPeriod;
+  float decayRate = -Slope(decayFit) / halfPeriod;
+  result.naturalFrequency = sqrt(dampedFrequency * dampedFrequency + decayRate * decayRate);
+  result.dampingRatio = decayRate / result.naturalFrequency;
+  result.effectiveLength = Free_Decay_Gravity_M_S2 / (result.naturalFrequency * result.naturalFrequency);
+  result.halfCycles = GetHalfCycles();
+  return true;
+}
+
+/******************************************************//**
+ * @brief  Adds one point to a running least squares line fit
+ * @param  fit Running sums
+ * @param  x Abscissa
+ * @param  y Ordinate
+ * @retval None
+ **********************************************************/
+void FreeDecayEstimator::AddPoint(freeDecayFit_t &fit, float x, float y)
+{
+  fit.count += 1.0f;
+  fit.x += x;
+  fit.y += y;
+  fit.xx += x * x;
+  fit.xy += x * y;
+}
+
+/******************************************************//**
+ * @brief  Returns the slope of a least squares line fit
+ * @param  fit Running sums of at least two points
+ * @retval slope
+ **********************************************************/
+float FreeDecayEstimator::Slope(const freeDecayFit_t &fit)
+{
+  return (fit.count * fit.xy - fit.x * fit.y) / (fit.count * fit.xx - fit.x * fit.x);
+}
@@ -0,0 +1,74 @@
+/******************************************************//**
+ * @file    freeDecayEstimator.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Online fit of the natural frequency, damping ratio and
+ *          effective length of a pendulum from a free decay. It
+ *          only needs the angle at known times, so the firmware
+ *          feeds it encoder edges and the host feeds it a log.
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __FREE_DECAY_ESTIMATOR_H_INCLUDED
+#define __FREE_DECAY_ESTIMATOR_H_INCLUDED
+
+#include <Arduino.h>
+
+/// Gravity used for the effective length
+#define Free_Decay_Gravity_M_S2     (9.81)
+
+/// Half swings the fit needs before it returns a result
+#define Free_Decay_Min_Half_Cycles  (4)
+
+/// Pendulum parameters fitted to a free decay
+typedef struct {
+  float naturalFrequency;  //Undamped natural frequency for small swings in rad/s
+  float dampingRatio;      //Viscous damping ratio
+  float effectiveLength;   //Length of the simple pendulum with the same frequency in meters
+  uint8_t halfCycles;      //Half swings in the fit
+} freeDecayResult_t;
+
+/// Running sums of a straight line least squares fit
+typedef struct {
+  float count;
+  float x;
+  float y;
+  float xx;
+  float xy;
+} freeDecayFit_t;
+
+/// FreeDecayEstimator library class
+class FreeDecayEstimator
+{
+  public:
+    FreeDecayEstimator();                       //Constructor, starts empty
+    void Reset(float resolution = 0.0);         //Start a new fit, resolution is the angle of one sample step in radians
+    void AddSample(float seconds, float angle); //Add the angle from rest in radians at a time in seconds
+    uint8_t GetHalfCycles();                    //Return the half swings fitted so far
+    float GetLastAmplitude();                   //Return the peak of the last complete half swing in radians
+    bool GetResult(freeDecayResult_t &result);  //Return the fit, false before Free_Decay_Min_Half_Cycles
+
+  private:
+    static void AddPoint(freeDecayFit_t &fit, float x, float y);
+    static float Slope(const freeDecayFit_t &fit);
+
+    // member variables
+    float resolution;          //Angle of one step, half of it is added to the peaks
+    bool started;              //A sample was added since Reset
+    float lastSeconds;         //Previous sample
+    float lastAngle;
+    uint8_t crossings;         //Zero crossings so far
+    float lastCrossing;        //Time of the last zero crossing in seconds
+    float correctedTime;       //Crossing time with each half swing scaled to its small swing length
+    float peak;                //Largest angle since the last crossing
+    float lastAmplitude;       //Peak of the last complete half swing
+    freeDecayFit_t timeFit;    //Corrected crossing time against crossing number, the slope is half a period
+    freeDecayFit_t decayFit;   //Log of the peak against half swing number, the slope is the decay per half swing
+};
+
+#endif /* #ifndef __FREE_DECAY_ESTIMATOR_H_INCLUDED */
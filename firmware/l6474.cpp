@@ -13,6 +13,7 @@
  **********************************************************/ 
 
 #include "l6474.h"
+#include "fastGpio.h"
 #include <SPI.h>
 
 #ifdef _DEBUG_L6474
@@ -24,6 +25,7 @@ const uint16_t L6474::prescalerArrayTimer0_1[PRESCALER_ARRAY_TIMER0_1_SIZE] = {
 const uint16_t L6474::prescalerArrayTimer2[PRESCALER_ARRAY_TIMER2_SIZE] = {0, 1, 8, 32, 64, 128, 256, 1024};
 volatile void (*L6474::flagInterruptCallback)(void);
 volatile uint8_t L6474::numberOfShields;
+volatile bool L6474::timer1Reserved = false;
 uint8_t L6474::spiTxBursts[L6474_CMD_ARG_MAX_NB_BYTES][MAX_NUMBER_OF_SHIELDS];
 uint8_t L6474::spiRxBursts[L6474_CMD_ARG_MAX_NB_BYTES][MAX_NUMBER_OF_SHIELDS];
 volatile bool L6474::spiPreemtionByIsr = false;
@@ -64,12 +66,18 @@ void L6474::AttachFlagInterrupt(void (*callback)(void))
 }
 
 /******************************************************//**
- * @brief Starts the L6474 library
+ * @brief Starts the L6474 library. Shield 0 steps from Timer 1,
+ * so nothing is started while another user reserved Timer 1, see
+ * ReserveTimer1.
  * @param[in] nbShields Number of L6474 shields to use (from 1 to 3)
- * @retval None
+ * @retval false if Timer 1 is reserved and the library did not start, else true
  **********************************************************/
-void L6474::Begin(uint8_t nbShields)
+bool L6474::Begin(uint8_t nbShields)
 {
+  if (timer1Reserved)
+  {
+    return false;
+  }
   numberOfShields = nbShields;
   
   // start the SPI library:
@@ -116,6 +124,7 @@ void L6474::Begin(uint8_t nbShields)
     /* Get Status to clear flags after start up */
     CmdGetStatus(i);
   }
+  return true;
 }
 
 /******************************************************//**
@@ -846,13 +855,13 @@ void L6474::SetDirection(uint8_t shieldId, dir_t dir)
     switch (shieldId)
     {
       case 2:
-        digitalWrite(L6474_DIR_3_Pin, dir);
+        FastGpio<L6474_DIR_3_Pin>::Write(dir);
         break;
       case 1:
-        digitalWrite(L6474_DIR_2_Pin, dir);
+        FastGpio<L6474_DIR_2_Pin>::Write(dir);
         break;
       case 0:
-        digitalWrite(L6474_DIR_1_Pin, dir);
+        FastGpio<L6474_DIR_1_Pin>::Write(dir);
         break;
       default:
         ;
@@ -888,6 +897,10 @@ void L6474::WaitMs(uint16_t msDelay)
  **********************************************************/
 void L6474::WaitUs(uint16_t usDelay)
 {
+#ifdef HOST_HAL
+	// no cycle-counted busy loop off target, the host HAL owns the time base
+	delayMicroseconds(usDelay);
+#else
 	// calling avrlib's delay_us() function with low values (e.g. 1 or
 	// 2 microseconds) gives delays longer than desired.
 	//delay_us(us);
@@ -951,8 +964,40 @@ void L6474::WaitUs(uint16_t usDelay)
 		"1: sbiw %0,1" "\n\t" // 2 cycles
 		"brne 1b" : "=w" (usDelay) : "0" (usDelay) // 2 cycles
 	);
+#endif
 }  
                   
+/******************************************************//**
+ * @brief  Returns whether the step clock of shield 0 owns Timer 1,
+ * so other users of the timer, such as the Timer 1 pulse counter of
+ * QuadratureEncoder, can refuse to start. Shield 0 is present
+ * whenever Begin has run.
+ * @param  None
+ * @retval true once Begin has run
+ **********************************************************/
+bool L6474::UsesTimer1(void)
+{
+  return numberOfShields != 0;
+}
+
+/******************************************************//**
+ * @brief  Reserves Timer 1 for another user, such as the Timer 1
+ * pulse counter of QuadratureEncoder, or releases it. While it is
+ * reserved Begin refuses to start and the PWM of shield 0 leaves
+ * the timer alone.
+ * @param  reserve true to reserve Timer 1, false to release it
+ * @retval false if Begin already gave Timer 1 to shield 0, else true
+ **********************************************************/
+bool L6474::ReserveTimer1(bool reserve)
+{
+  if (reserve && UsesTimer1())
+  {
+    return false;
+  }
+  timer1Reserved = reserve;
+  return true;
+}
+
 /******************************************************//**
  * @brief  Gets the pointer to the L6474 instance
  * @param  None
@@ -1103,7 +1148,11 @@ void L6474::StepClockHandler(uint8_t shieldId)
           while (shieldPrm[shieldId].accu >= (0X10000L))
           {
             shieldPrm[shieldId].accu -= (0X10000L);
-            shieldPrm[shieldId].speed -=1;
+            /* At low speed one step can remove more than the speed itself, never go below min speed */
+            if (shieldPrm[shieldId].speed > shieldPrm[shieldId].minSpeed)
+            {
+              shieldPrm[shieldId].speed -=1;
+            }
             speedUpdated = true;
           }
           if (speedUpdated)
@@ -1430,14 +1479,14 @@ void L6474::SetRegisterToPredefinedValues(uint8_t shieldId)
  **********************************************************/
 void L6474::WriteBytes(uint8_t *pByteToTransmit, uint8_t *pReceivedByte)
 {
-  digitalWrite(SS, LOW);
+  FastGpio<SS>::Low();
   for (uint32_t i = 0; i < numberOfShields; i++)
   {
     *pReceivedByte = SPI.transfer(*pByteToTransmit);
     pByteToTransmit++;
     pReceivedByte++;
   }
-  digitalWrite(SS, HIGH);
+  FastGpio<SS>::High();
   if (isrFlag)
   {
     spiPreemtionByIsr = true;
@@ -1517,13 +1566,19 @@ void L6474::PwmInit(uint8_t shieldId)
  * @brief  Sets the frequency of PWM1 used by shield 0
  * @param[in] newFreq in Hz
  * @retval None
- * @note The frequency is directly the current speed of the shield
+ * @note The frequency is directly the current speed of the shield.
+ * Nothing is changed while Timer 1 is reserved, see ReserveTimer1.
  **********************************************************/
 void L6474::Pwm1SetFreq(uint16_t newFreq)
 {
   uint8_t index = 0;
   uint32_t top;
   uint16_t TargetedPrescaler;
+
+  if (timer1Reserved)
+  {
+    return;
+  }
  
   TargetedPrescaler = (int16_t)(F_CPU / (2 * (uint32_t) newFreq * UINT16_MAX));
 
@@ -1644,7 +1699,11 @@ void L6474::PwmStop(uint8_t shieldId)
   switch (shieldId)
   {
     case 0:
-      /* PWM1 uses timer 1 */
+      /* PWM1 uses timer 1, unless another user reserved it */
+      if (timer1Reserved)
+      {
+        break;
+      }
     
       /* Stop timer1 by clearing CSS bits (keep  WGM13 and WGM12) */
       TCCR1B = 0x10;  
@@ -74,9 +74,13 @@ extern char l6474StrOut[DEBUG_BUFFER_SIZE];
 /// Maximum number of steps
 #define MAX_STEPS         (0x7FFFFFFF)
 /// uint8_t max value
+#ifndef UINT8_MAX
 #define UINT8_MAX         (uint8_t)(0XFF)
+#endif
 /// uint16_t max value
+#ifndef UINT16_MAX
 #define UINT16_MAX        (uint16_t)(0XFFFF)
+#endif
 
 /// Pwm prescaler array size for timer 0 & 1
 #define PRESCALER_ARRAY_TIMER0_1_SIZE   (6)
@@ -420,7 +424,7 @@ class L6474 {
     /// @defgroup group1 Shield control functions
     ///@{
     void AttachFlagInterrupt(void (*callback)(void));     //Attach a user callback to the flag Interrupt
-    void Begin(uint8_t nbShields);                        //Start the L6474 library
+    bool Begin(uint8_t nbShields);                        //Start the L6474 library, false while Timer 1 is reserved
     uint16_t GetAcceleration(uint8_t shieldId);           //Return the acceleration in pps^2
     uint16_t GetCurrentSpeed(uint8_t shieldId);           //Return the current speed in pps
     uint16_t GetDeceleration(uint8_t shieldId);           //Return the deceleration in pps^2
@@ -446,6 +450,8 @@ class L6474 {
     bool SetMaxSpeed(uint8_t shieldId,uint16_t newMaxSpeed); //Set the max speed in pps
     bool SetMinSpeed(uint8_t shieldId,uint16_t newMinSpeed); //Set the min speed in pps
     bool SoftStop(uint8_t shieldId);                         //Progressively stops the motor 
+    static bool UsesTimer1(void);                            //Return true once Begin started shield 0, stepped by Timer 1
+    static bool ReserveTimer1(bool reserve);                 //Keep Begin and shield 0 off Timer 1 for another user, or release it
     void WaitWhileActive(uint8_t shieldId);                  //Wait for the shield state becomes Inactive
     ///@}
     
@@ -517,6 +523,7 @@ class L6474 {
     static volatile bool isrFlag;
     static volatile bool spiPreemtionByIsr;
     static volatile uint8_t numberOfShields;
+    static volatile bool timer1Reserved;
     static const uint16_t prescalerArrayTimer0_1[PRESCALER_ARRAY_TIMER0_1_SIZE];
     static const uint16_t prescalerArrayTimer2[PRESCALER_ARRAY_TIMER2_SIZE];
     static uint8_t spiTxBursts[L6474_CMD_ARG_MAX_NB_BYTES][MAX_NUMBER_OF_SHIELDS];
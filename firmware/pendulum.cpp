@@ -15,81 +15,335 @@
 #include <Arduino.h>
 
 /******************************************************//**
- * @brief  Constructor for the Pendulum object. Sets the
- * pulse angle constants for converting from pulses to 
- * degrees and radians
+ * @brief  Constructor for the encoder side of the Pendulum object,
+ * called by Pendulum with its template arguments
  * @param  pulsesPerRotation the number of pulses in one
  * rotation of the position sensor
+ * @param  decodeMode counts per pulse the encoder decodes
+ * @param  timestampSource clock the encoder times its edges with
+ * @param  pinA Encoder A pin
+ * @param  pinB Encoder B pin on the same port as A
  * @retval None
  **********************************************************/
-Pendulum::Pendulum(unsigned int pulsesPerRotation) : pulsesPerRotation(pulsesPerRotation),
-pulseAngleRadian(TWO_PI / (float)pulsesPerRotation), pulseAngleDegree(360.0 / (float)pulsesPerRotation) {}
+PendulumBase::PendulumBase(uint16_t pulsesPerRotation, decodeMode_t decodeMode, timestampSource_t timestampSource,
+                           uint8_t pinA, uint8_t pinB) :
+encoder(pinA, pinB), observerUpdatesPerSecond(0.0), naturalFrequencySquared(0), pulsesPerRotation(pulsesPerRotation), decodeMode(decodeMode),
+timestampSource(timestampSource), secondsPerTimestamp(0.0), restPosition(0),
+freeDecayStatus(FREE_DECAY_IDLE), freeDecayStart(0), freeDecayEdgeTime(0) {}
 
+/******************************************************//**
+ * @brief  Initializes the quadrature encoder library and the
+ * time scales that depend on its timestamp clock
+ * @param  timerConfig Encoder speed sample rate, Begin<controlRateHz>()
+ * matches it to the control loop
+ * @retval None
+ **********************************************************/
+void PendulumBase::Begin(sampleTimerConfig_t timerConfig)
+{
+  encoder.Begin(pulsesPerRotation, decodeMode, timestampSource, timerConfig);
+  observerUpdatesPerSecond = (float)encoder.GetTimestampsPerSecond() / (float)encoder.GetObserverPeriod();
+  secondsPerTimestamp = 1.0 / (float)encoder.GetTimestampsPerSecond();
+}
 
 /******************************************************//**
- * @brief  Initializes the quadrature encoder library.
- * @param  None
+ * @brief  Starts the position, velocity and acceleration observer
+ * of the encoder. It updates every 1.024ms with Timer 2 timestamps
+ * and every speed sample (16.384ms by default) with micros(). See
+ * QuadratureEncoder::SetObserverBandwidth.
+ * @param  bandwidth Observer bandwidth in rad/s, 0 stops it
  * @retval None
  **********************************************************/
-void Pendulum::Begin()
+void PendulumBase::SetObserverBandwidth(uint16_t bandwidth)
+{
+  encoder.SetObserverBandwidth(bandwidth);
+}
+
+/******************************************************//**
+ * @brief  Selects where the encoder edges are decoded. Deferred
+ * processing keeps the pin change ISRs short and the control loop
+ * calls DecodeEdges before it reads the pendulum. See
+ * QuadratureEncoder::SetEdgeProcessing.
+ * @param  processing EDGE_PROCESS_ISR or EDGE_PROCESS_DEFERRED
+ * @param  ring Edge records for EDGE_PROCESS_DEFERRED
+ * @param  ringSize Records in ring
+ * @retval false if the processing was refused, see
+ * QuadratureEncoder::SetEdgeProcessing
+ **********************************************************/
+bool PendulumBase::SetEdgeProcessing(edgeProcessing_t processing, edgeRecord_t *ring, uint8_t ringSize)
+{
+  return encoder.SetEdgeProcessing(processing, ring, ringSize);
+}
+
+/******************************************************//**
+ * @brief  Decodes the edges queued in deferred processing
+ * @param  None
+ * @retval number of edges decoded
+ **********************************************************/
+uint8_t PendulumBase::DecodeEdges()
 {
-  encoder.Begin(pulsesPerRotation);
+  return encoder.DecodeEdges();
 }
 
 /******************************************************//**
  * @brief  Sets the home position of the pendulum to 0. The
  * home position is equal 0 in the same way as 2pi rad == 0
  * and 360 deg == 0 on a standard position coordinate plane.
+ * The rest position moves to home with it, so call it with the
+ * pendulum hanging or follow it with CalibrateRest.
  * @param  None
  * @retval None
  **********************************************************/
-void Pendulum::SetHome()
+void PendulumBase::SetHome()
 {
   encoder.SetHomePosition();
+  restPosition = 0;
 }
 
 /******************************************************//**
- * @brief  Returns the current position in pulses away from
- * 0 to 2pi radians where 0 == 2pi in a CCW rotation.
+ * @brief  Learns the position the pendulum hangs at, so the
+ * angle from upright does not depend on where the pendulum was
+ * when the encoder started counting. The position is averaged
+ * over Pendulum_Rest_Samples samples Pendulum_Rest_Interval_Ms
+ * apart, and a window is only taken once the pendulum moved less
+ * than Pendulum_Rest_Spread_Deg within it; a swinging pendulum
+ * starts a new window. Blocks in delay() until then, so call it
+ * at startup before the control loop runs.
+ * @param  timeoutMs Time to wait for the pendulum to settle, checked
+ * after each window so the call can last up to one window longer
+ * @retval true if the rest position was learned, false if the
+ * pendulum kept moving and the rest position is unchanged
+ **********************************************************/
+bool PendulumBase::CalibrateRest(uint16_t timeoutMs)
+{
+  int32_t counts = encoder.GetPulsesPerRotation();
+  int32_t spread = ((int32_t)Pendulum_Rest_Spread_Deg * counts + 180) / 360;
+  unsigned long start = millis();
+
+  do
+  {
+    int32_t sum = 0;
+    int32_t lowest = encoder.GetAbsolutePosition();
+    int32_t highest = lowest;
+    for (uint8_t i = 0; i < Pendulum_Rest_Samples; i++)
+    {
+      delay(Pendulum_Rest_Interval_Ms);
+      int32_t position = encoder.GetAbsolutePosition();
+      sum += position;
+      lowest = position < lowest ? position : lowest;
+      highest = position > highest ? position : highest;
+    }
+
+    if (highest - lowest <= spread)
+    {
+      /* Round the mean to the nearest count and wrap it into one turn */
+      int32_t mean = (sum + (sum < 0 ? -Pendulum_Rest_Samples / 2 : Pendulum_Rest_Samples / 2)) / Pendulum_Rest_Samples;
+      mean %= counts;
+      restPosition = (int16_t)(mean < 0 ? mean + counts : mean);
+      return true;
+    }
+  } while (millis() - start < timeoutMs);
+
+  return false;
+}
+
+/******************************************************//**
+ * @brief  Returns the position the pendulum hangs at
  * @param  None
- * @retval position in radians
+ * @retval rest position in counts from home between 0 and
+ * GetPulsesPerRotation()-1
  **********************************************************/
-float Pendulum::GetCurrentPositionRad()
+int16_t PendulumBase::GetRestPosition()
 {
-  return (float)encoder.GetCurrentPosition() * pulseAngleRadian;
+  return restPosition;
 }
 
 /******************************************************//**
- * @brief  Returns the current position in pulses away from
- * 0 to 360 degrees where 0 == 360 in a CCW rotation.
+ * @brief  Sets the position the pendulum hangs at, for a
+ * mechanical offset measured before, such as one CalibrateRest
+ * returned on an earlier run with the same home
+ * @param  counts rest position in counts from home, wrapped into one turn
+ * @retval None
+ **********************************************************/
+void PendulumBase::SetRestPosition(int16_t counts)
+{
+  int16_t rotation = (int16_t)encoder.GetPulsesPerRotation();
+  counts %= rotation;
+  restPosition = counts < 0 ? counts + rotation : counts;
+}
+
+/******************************************************//**
+ * @brief  Returns the whole turns away from home
  * @param  None
- * @retval position in degrees
+ * @retval turns (CCW is + / CW is -)
+ **********************************************************/
+int16_t PendulumBase::GetTurns()
+{
+  return encoder.GetTurns();
+}
+
+/******************************************************//**
+ * @brief  Sets the natural frequency of the pendulum, sqrt(g/l)
+ * for a simple pendulum or sqrt(m g d / I) for a rigid one, which
+ * scales the potential energy in GetEnergyQ16. The float math is
+ * done here once.
+ * @param  frequency Natural frequency in rad/s, below 16
+ * @retval None
  **********************************************************/
-float Pendulum::GetCurrentPositionDeg()
+void PendulumBase::SetNaturalFrequency(float frequency)
 {
-  return (float)encoder.GetCurrentPosition() * pulseAngleDegree;
+  float squaredQ8 = frequency * frequency * 256.0f + 0.5f;
+  naturalFrequencySquared = squaredQ8 >= 65535.0f ? 65535 : (uint16_t)squaredQ8;
 }
 
 /******************************************************//**
- * @brief  Returns the current rotational velocity of the
- * device in radians/s. Direction is indicated  by sign where
- * CCW is + and CW is -
+ * @brief  Starts identifying the pendulum from a free decay. With
+ * the pendulum hanging still, call this, push the pendulum by hand
+ * more than Pendulum_Free_Decay_Start_Deg and let it swing while
+ * the control loop calls UpdateFreeDecay with the motor stopped.
+ * Calibrate the rest position first, the swing is timed around it.
  * @param  None
- * @retval the current rotational velocity in radians
+ * @retval None
  **********************************************************/
-float Pendulum::GetCurrentVelocityRad()
+void PendulumBase::StartFreeDecay()
 {
-  return (float)encoder.GetCurrentVelocity() * pulseAngleRadian;
+  freeDecayStatus = FREE_DECAY_WAITING;
 }
 
 /******************************************************//**
- * @brief  Returns the current rotational velocity of the
- * device in degrees/s. Direction is indicated  by sign where
- * CCW is + and CW is -
+ * @brief  Feeds the latest encoder edge to the free decay fit.
+ * Only the edge timestamps are used: the angle of an edge is half
+ * a count behind the count in the direction it was counted, as in
+ * InterpolatedCounts, and the fit times the zero crossings and the
+ * peaks from those edges. Edges between two calls are skipped, which
+ * only matters near the crossings where the interpolation covers
+ * them. Once the swing peaks below Pendulum_Free_Decay_End_Deg, or
+ * after Pendulum_Free_Decay_Max_Half_Cycles half swings, the fit
+ * ends and the natural frequency is applied to GetEnergyQ16.
  * @param  None
- * @retval the current rotational velocity in degrees
+ * @retval progress of the identification
  **********************************************************/
-float Pendulum::GetCurrentVelocityDeg()
+freeDecayStatus_t PendulumBase::UpdateFreeDecay()
 {
-  return (float)encoder.GetCurrentVelocity() * pulseAngleDegree;
-}
\ No newline at end of file
+  if (freeDecayStatus != FREE_DECAY_WAITING && freeDecayStatus != FREE_DECAY_RECORDING)
+  {
+    return freeDecayStatus;
+  }
+
+  encoderSnapshot_t snapshot = encoder.GetPositionState();
+  if (freeDecayStatus == FREE_DECAY_RECORDING && snapshot.edgeTime == freeDecayEdgeTime)
+  {
+    return freeDecayStatus;
+  }
+
+  int32_t counts = encoder.GetPulsesPerRotation();
+  int32_t fromRest = (int32_t)snapshot.position - restPosition;
+  fromRest = fromRest > counts / 2 ? fromRest - counts : (fromRest <= -counts / 2 ? fromRest + counts : fromRest);
+  float radiansPerCount = TWO_PI / (float)counts;
+  float angle = ((float)fromRest - 0.5f * (float)snapshot.edgeDirection) * radiansPerCount;
+
+  if (freeDecayStatus == FREE_DECAY_WAITING)
+  {
+    if (fabs(angle) < Pendulum_Free_Decay_Start_Deg * DEG_TO_RAD)
+    {
+      return freeDecayStatus;
+    }
+    freeDecay.Reset(radiansPerCount);
+    freeDecayStart = snapshot.edgeTime;
+    freeDecayStatus = FREE_DECAY_RECORDING;
+  }
+
+  freeDecayEdgeTime = snapshot.edgeTime;
+  freeDecay.AddSample((float)(snapshot.edgeTime - freeDecayStart) * secondsPerTimestamp, angle);
+
+  uint8_t halfCycles = freeDecay.GetHalfCycles();
+  if (halfCycles >= Pendulum_Free_Decay_Max_Half_Cycles ||
+      (halfCycles > 0 && freeDecay.GetLastAmplitude() < Pendulum_Free_Decay_End_Deg * DEG_TO_RAD))
+  {
+    freeDecayResult_t result;
+    if (freeDecay.GetResult(result))
+    {
+      SetNaturalFrequency(result.naturalFrequency);
+      freeDecayStatus = FREE_DECAY_DONE;
+    }
+    else
+    {
+      freeDecayStatus = FREE_DECAY_FAILED;
+    }
+  }
+  return freeDecayStatus;
+}
+
+/******************************************************//**
+ * @brief  Returns the parameters of the free decay fit, for the
+ * controller gains. The fit can be read while it is recording.
+ * @param  result natural frequency in rad/s, damping ratio and
+ * effective length in meters
+ * @retval true once enough half swings were fitted, else false
+ **********************************************************/
+bool PendulumBase::GetFreeDecayResult(freeDecayResult_t &result)
+{
+  return freeDecayStatus != FREE_DECAY_IDLE && freeDecay.GetResult(result);
+}
+
+/******************************************************//**
+ * @brief  Returns a position in counts from upright, half a
+ * turn from the rest position, wrapped to (-counts/2, counts/2].
+ * For an odd number of counts per rotation upright falls between
+ * two counts, and the count CW of it is taken as upright.
+ * @param  position counts from home between 0 and GetPulsesPerRotation()-1
+ * @retval counts from upright
+ **********************************************************/
+int16_t PendulumBase::UprightCounts(int16_t position)
+{
+  int32_t counts = encoder.GetPulsesPerRotation();
+  int32_t fromUpright = (int32_t)position - restPosition - counts / 2;
+  return (int16_t)(fromUpright <= -(counts + 1) / 2 ? fromUpright + counts : fromUpright);
+}
+
+/******************************************************//**
+ * @brief  Returns a position between counts from upright,
+ * wrapped to (-counts/2, counts/2] with the same upright count
+ * as UprightCounts(int16_t)
+ * @param  position counts from home between 0 and GetPulsesPerRotation()
+ * @retval counts from upright
+ **********************************************************/
+float PendulumBase::UprightCounts(float position)
+{
+  int32_t counts = encoder.GetPulsesPerRotation();
+  float fromUpright = position - (float)(restPosition + counts / 2);
+  if (fromUpright <= -0.5f * counts)
+  {
+    fromUpright += (float)counts;
+  }
+  else if (fromUpright > 0.5f * counts)
+  {
+    fromUpright -= (float)counts;
+  }
+  return fromUpright;
+}
+
+/******************************************************//**
+ * @brief  Interpolates the position of a snapshot between edges.
+ * A count stands for the middle of its step, so the last edge was
+ * half a count behind it in the direction it was counted, as in the
+ * state observer. The velocity moves the position on from that edge
+ * and the result is clamped to half a count either side of the
+ * count, so it never leaves the step the lines are in. Once the
+ * speed estimate times out the position stays at the last edge.
+ * @param  snapshot Encoder state from GetState()
+ * @retval position in counts between 0 and GetPulsesPerRotation()
+ **********************************************************/
+float PendulumBase::InterpolatedCounts(const encoderSnapshot_t &snapshot)
+{
+  /* Read after the snapshot, so the time since the edge is never negative */
+  noInterrupts();
+  unsigned long now = encoder.GetTimestamp();
+  interrupts();
+
+  float fraction = (float)snapshot.velocity * (float)(now - snapshot.edgeTime) * secondsPerTimestamp -
+                   0.5f * (float)snapshot.edgeDirection;
+  fraction = fraction > 0.5f ? 0.5f : (fraction < -0.5f ? -0.5f : fraction);
+
+  float counts = (float)snapshot.position + fraction;
+  return counts < 0.0f ? counts + (float)encoder.GetPulsesPerRotation() : counts;
+}
@@ -1,5 +1,5 @@
 /******************************************************//**
- * @file    pendulum.h 
+ * @file    pendulum.h
  * @version V1.0
  * @date    June 3, 2024
  * @brief   pendulum driver abstraction layer library
@@ -15,26 +15,678 @@
 #define __PENDULUM_H_INCLUDED
 
 #include "quadratureEncoder.h"
+#include "fixedPoint.h"
+#include "trigTable.h"
+#include "freeDecayEstimator.h"
 
-class Pendulum
+/// Rest calibration: samples averaged per window, time between samples, the largest
+/// swing in a window still taken as at rest, and how long CalibrateRest waits for one.
+/// The window spans about one swing period of a 20-40cm pendulum, so a small swing averages out.
+#define Pendulum_Rest_Samples       (128)
+#define Pendulum_Rest_Interval_Ms   (10)
+#define Pendulum_Rest_Spread_Deg    (2)
+#define Pendulum_Rest_Timeout_Ms    (10000)
+
+/// Free decay identification: the push must swing the pendulum this far from rest, and
+/// the fit ends once a half swing peaks below the end angle or after the most half swings
+#define Pendulum_Free_Decay_Start_Deg       (10)
+#define Pendulum_Free_Decay_End_Deg         (3)
+#define Pendulum_Free_Decay_Max_Half_Cycles (40)
+
+/// Progress of the free decay identification
+typedef enum {
+  FREE_DECAY_IDLE = 0,   //StartFreeDecay was not called
+  FREE_DECAY_WAITING,    //Waiting for the push
+  FREE_DECAY_RECORDING,  //Fitting the swing
+  FREE_DECAY_DONE,       //Result ready, the natural frequency is applied
+  FREE_DECAY_FAILED      //The swing died out before Free_Decay_Min_Half_Cycles
+} freeDecayStatus_t;
+
+/// Pendulum angle and velocity from the same encoder update
+typedef struct {
+  float position;   //Between 0 and 2pi, or 0 and 360
+  float velocity;   //Per second (CCW is + / CW is -)
+} pendulumState_t;
+
+/// Pendulum angle and velocity in fixed point from the same encoder update
+typedef struct {
+  angleQ16_t position;            //Between 0 and 2pi
+  angularVelocityQ16_t velocity;  //CCW is + / CW is -
+} pendulumStateQ16_t;
+
+/// Encoder side of the Pendulum library, the same for every encoder resolution
+class PendulumBase
+{
+  public:
+    PendulumBase(uint16_t pulsesPerRotation, decodeMode_t decodeMode,   //Constructor, called by Pendulum
+                 timestampSource_t timestampSource, uint8_t pinA, uint8_t pinB);
+    void Begin(sampleTimerConfig_t timerConfig = SampleTimer<Sample_Timer_Default_Hz>::Config()); //Start the Pendulum library
+    template <uint16_t controlRateHz>
+    void Begin()                              //Start the Pendulum library with the speed sampled once per control loop
+    {
+      Begin(SampleTimer<controlRateHz>::Config());
+    }
+    void SetHome();                           //Set current position to be the home position
+    bool CalibrateRest(uint16_t timeoutMs = Pendulum_Rest_Timeout_Ms); //Learn where the pendulum hangs, false if it did not settle
+    int16_t GetRestPosition();                //Return the hanging rest position in counts from home
+    void SetRestPosition(int16_t counts);     //Set the hanging rest position in counts, from a stored calibration
+    void SetNaturalFrequency(float frequency); //Set sqrt(g/l) of the pendulum in rad/s for the energy estimate
+    void StartFreeDecay();                    //Start identifying the pendulum from a free swing after a push
+    freeDecayStatus_t UpdateFreeDecay();      //Fit the latest encoder edge, call once per control loop
+    bool GetFreeDecayResult(freeDecayResult_t &result); //Return the identified natural frequency, damping and length
+    void SetObserverBandwidth(uint16_t bandwidth); //Start the state observer at a bandwidth in rad/s, 0 stops it
+    bool SetEdgeProcessing(edgeProcessing_t processing, //Decode the edges in the ISRs or queue them into ring for DecodeEdges
+                           edgeRecord_t *ring = NULL, uint8_t ringSize = 0);
+    uint8_t DecodeEdges();                    //Decode the queued edges, call once per control loop
+    int16_t GetTurns();                       //Return the whole turns from home (CCW is + / CW is -)
+
+  protected:
+    int16_t UprightCounts(int16_t position);
+    float UprightCounts(float position);
+    float InterpolatedCounts(const encoderSnapshot_t &snapshot);
+    QuadratureEncoder encoder;
+    float observerUpdatesPerSecond;
+    uint16_t naturalFrequencySquared;         //g/l in 1/s^2 Q8, scales the potential energy
+
+  private:
+    uint16_t pulsesPerRotation;
+    decodeMode_t decodeMode;
+    timestampSource_t timestampSource;
+    float secondsPerTimestamp;
+    int16_t restPosition;                     //Counts from home the pendulum hangs at, upright is half a turn on
+    FreeDecayEstimator freeDecay;             //Free decay fit
+    freeDecayStatus_t freeDecayStatus;
+    unsigned long freeDecayStart;             //Timestamp of the first edge in the fit
+    unsigned long freeDecayEdgeTime;          //Timestamp of the last edge fitted
+};
+
+/// Pendulum library class, one type per encoder resolution so the unit scales are constants
+template <uint16_t ppr, decodeMode_t mode = DECODE_1X>
+class Pendulum : public PendulumBase
 {
   public:
-    Pendulum(unsigned int pulsesPerRotation); //Constructor for the Pendulum
-    void Begin();                             //Start the Pendulum library
-    void SetHome();                           //Set current position to be the home position 
+    static_assert((uint32_t)ppr * mode >= 16, "Pendulum encoder needs at least 16 counts per rotation for the Q16 scale");
+    static_assert((uint32_t)ppr * mode <= 32767, "Pendulum counts per rotation must fit the int16_t count position");
+
+    static constexpr uint16_t CountsPerRotation()      //Counts in one rotation in the decode mode
+    {
+      return ppr * mode;
+    }
+
+    static constexpr float RadiansPerCount()           //Angle of one count in radians
+    {
+      return (float)(TWO_PI / CountsPerRotation());
+    }
+
+    static constexpr float DegreesPerCount()           //Angle of one count in degrees
+    {
+      return (float)(360.0 / CountsPerRotation());
+    }
+
+    static constexpr uint8_t Q16Shift(uint8_t shift = 8) //Fraction bits that give RadiansQ16PerCount 17 significant bits
+    {
+      return (shift >= 15 || TWO_PI * 65536.0 * (double)(1UL << shift) / CountsPerRotation() >= 65536.0) ?
+             shift : Q16Shift(shift + 1);
+    }
+
+    static constexpr int32_t RadiansQ16PerCount()      //Angle of one count in radians, Q16.16 with Q16Shift() more fraction bits
+    {
+      return (int32_t)(TWO_PI * 65536.0 * (double)(1UL << Q16Shift()) / CountsPerRotation() + 0.5);
+    }
+
+    static constexpr int32_t TurnQ15PerCount()         //Angle of one count, 65536 per turn with 15 more fraction bits
+    {
+      return (int32_t)((65536.0 * 32768.0 + CountsPerRotation() / 2) / CountsPerRotation());
+    }
+
+    static int16_t CosQ15(uint16_t count)              //cos of an angle in counts from the flash table, Trig_Table_One is 1
+    {
+      return TrigTable<CountsPerRotation()>::Cos(count);
+    }
+
+    static int16_t SinQ15(uint16_t count)              //sin of an angle in counts from the flash table, Trig_Table_One is 1
+    {
+      return TrigTable<CountsPerRotation()>::Sin(count);
+    }
+
+    Pendulum(timestampSource_t timestampSource = TIMESTAMP_MICROS,    //Constructor for the Pendulum
+             uint8_t pinA = Quadrature_Pendulum_A_Pin, uint8_t pinB = Quadrature_Pendulum_B_Pin);
 
     float GetCurrentPositionRad();     //Return the current position in pulses between 0 and 2pi
     float GetCurrentPositionDeg();     //Return the current position in pulses between 0 and 360
+    float GetAbsolutePositionRad();    //Return the position in radians from home, counting whole turns
+    float GetAbsolutePositionDeg();    //Return the position in degrees from home, counting whole turns
+    float GetAngleFromUprightRad();    //Return the angle from upright between -pi (exclusive) and pi
+    float GetAngleFromUprightDeg();    //Return the angle from upright between -180 (exclusive) and 180
 
     float GetCurrentVelocityRad();     //Return the current velocity in radians/s (CCW is + / CW is -)
     float GetCurrentVelocityDeg();     //Return the current velocity in degrees/s (CCW is + / CW is -)
+    pendulumState_t GetStateRad();     //Return the position and velocity in radians from one encoder snapshot
+    pendulumState_t GetStateDeg();     //Return the position and velocity in degrees from one encoder snapshot
+    pendulumState_t GetInterpolatedStateRad(); //Return GetStateRad with the position interpolated between edges
+    pendulumState_t GetInterpolatedStateDeg(); //Return GetStateDeg with the position interpolated between edges
+    pendulumState_t GetUprightStateRad();      //Return the angle from upright and velocity in radians from one encoder snapshot
+    pendulumState_t GetUprightStateDeg();      //Return the angle from upright and velocity in degrees from one encoder snapshot
+    pendulumState_t GetInterpolatedUprightStateRad(); //Return GetUprightStateRad with the angle interpolated between edges
+    pendulumState_t GetInterpolatedUprightStateDeg(); //Return GetUprightStateDeg with the angle interpolated between edges
+
+    angleQ16_t GetCurrentPositionQ16();            //Return the current position between 0 and 2pi
+    angleQ16_t GetAngleFromUprightQ16();           //Return the angle from upright between -pi (exclusive) and pi
+    int16_t GetAngleFromUprightQ15();              //Return the angle from upright in Q15 half turns, -32768 is +-pi
+    angularVelocityQ16_t GetCurrentVelocityQ16();  //Return the current velocity (CCW is + / CW is -)
+    pendulumStateQ16_t GetStateQ16();              //Return the position and velocity from one encoder snapshot
+    pendulumStateQ16_t GetUprightStateQ16();       //Return the angle from upright and velocity from one encoder snapshot
+    energyQ16_t GetEnergyQ16();                    //Return the swing energy per moment of inertia, 0 at rest upright
+
+    float GetObservedPositionRad();     //Return the observer position between 0 and 2pi
+    float GetObservedPositionDeg();     //Return the observer position between 0 and 360
+    float GetObservedAngleFromUprightRad(); //Return the observer angle from upright between -pi and pi
+    float GetObservedAngleFromUprightDeg(); //Return the observer angle from upright between -180 and 180
+    float GetObservedVelocityRad();     //Return the observer velocity in radians/s (CCW is + / CW is -)
+    float GetObservedVelocityDeg();     //Return the observer velocity in degrees/s (CCW is + / CW is -)
+    float GetObservedAccelerationRad(); //Return the observer acceleration in radians/s^2
+    float GetObservedAccelerationDeg(); //Return the observer acceleration in degrees/s^2
 
   private:
-    QuadratureEncoder encoder;
-    unsigned int pulsesPerRotation;
-    float pulseAngleRadian;
-    float pulseAngleDegree;
+    static int32_t CountsToQ16(int32_t counts);
 };
 
+/******************************************************//**
+ * @brief  Constructor for the Pendulum object. The encoder
+ * resolution and decode mode are template arguments, so the
+ * angle of one count is a compile-time constant in every unit.
+ * @param  timestampSource clock the encoder times its edges with
+ * @param  pinA Encoder A pin, A2 by default
+ * @param  pinB Encoder B pin on the same port as A, A3 by default
+ * @retval None
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+Pendulum<ppr, mode>::Pendulum(timestampSource_t timestampSource, uint8_t pinA, uint8_t pinB) :
+PendulumBase(ppr, mode, timestampSource, pinA, pinB) {}
+
+/******************************************************//**
+ * @brief  Returns the current position in pulses away from
+ * 0 to 2pi radians where 0 == 2pi in a CCW rotation.
+ * @param  None
+ * @retval position in radians
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetCurrentPositionRad()
+{
+  return (float)encoder.GetCurrentPosition() * RadiansPerCount();
+}
+
+/******************************************************//**
+ * @brief  Returns the current position in pulses away from
+ * 0 to 360 degrees where 0 == 360 in a CCW rotation.
+ * @param  None
+ * @retval position in degrees
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetCurrentPositionDeg()
+{
+  return (float)encoder.GetCurrentPosition() * DegreesPerCount();
+}
+
+/******************************************************//**
+ * @brief  Returns the position away from home in radians
+ * without the rollover at 2pi, so every CCW turn adds 2pi and
+ * every CW turn takes it away.
+ * @param  None
+ * @retval absolute position in radians
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetAbsolutePositionRad()
+{
+  return (float)encoder.GetAbsolutePosition() * RadiansPerCount();
+}
+
+/******************************************************//**
+ * @brief  Returns the position away from home in degrees
+ * without the rollover at 360.
+ * @param  None
+ * @retval absolute position in degrees
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetAbsolutePositionDeg()
+{
+  return (float)encoder.GetAbsolutePosition() * DegreesPerCount();
+}
+
+/******************************************************//**
+ * @brief  Returns the angle from upright, half a turn away from
+ * the rest position the pendulum hangs at, wrapped to (-pi, pi].
+ * The rest position is home until CalibrateRest or
+ * SetRestPosition moves it. The wrap is done on the count, so it
+ * is exact at the ends.
+ * @param  None
+ * @retval angle from upright in radians (CCW is + / CW is -)
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetAngleFromUprightRad()
+{
+  return (float)UprightCounts(encoder.GetCurrentPosition()) * RadiansPerCount();
+}
+
+/******************************************************//**
+ * @brief  Returns the angle from upright wrapped to (-180, 180]
+ * @param  None
+ * @retval angle from upright in degrees (CCW is + / CW is -)
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetAngleFromUprightDeg()
+{
+  return (float)UprightCounts(encoder.GetCurrentPosition()) * DegreesPerCount();
+}
+
+/******************************************************//**
+ * @brief  Returns the current rotational velocity of the
+ * device in radians/s. Direction is indicated  by sign where
+ * CCW is + and CW is -
+ * @param  None
+ * @retval the current rotational velocity in radians
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetCurrentVelocityRad()
+{
+  return (float)encoder.GetCurrentVelocity() * RadiansPerCount();
+}
+
+/******************************************************//**
+ * @brief  Returns the current rotational velocity of the
+ * device in degrees/s. Direction is indicated  by sign where
+ * CCW is + and CW is -
+ * @param  None
+ * @retval the current rotational velocity in degrees
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetCurrentVelocityDeg()
+{
+  return (float)encoder.GetCurrentVelocity() * DegreesPerCount();
+}
+
+/******************************************************//**
+ * @brief  Returns the position and velocity in radians from a
+ * single encoder snapshot, so both describe the same moment
+ * without disabling interrupts. See QuadratureEncoder::GetState.
+ * @param  None
+ * @retval position between 0 and 2pi and velocity in radians/s
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+pendulumState_t Pendulum<ppr, mode>::GetStateRad()
+{
+  encoderSnapshot_t snapshot = encoder.GetState();
+  pendulumState_t state;
+  state.position = (float)snapshot.position * RadiansPerCount();
+  state.velocity = (float)snapshot.velocity * RadiansPerCount();
+  return state;
+}
+
+/******************************************************//**
+ * @brief  Returns the position and velocity in degrees from a
+ * single encoder snapshot. See GetStateRad.
+ * @param  None
+ * @retval position between 0 and 360 and velocity in degrees/s
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+pendulumState_t Pendulum<ppr, mode>::GetStateDeg()
+{
+  encoderSnapshot_t snapshot = encoder.GetState();
+  pendulumState_t state;
+  state.position = (float)snapshot.position * DegreesPerCount();
+  state.velocity = (float)snapshot.velocity * DegreesPerCount();
+  return state;
+}
+
+/******************************************************//**
+ * @brief  Returns the position and velocity in radians from a
+ * single encoder snapshot, with the position moved on from the
+ * last edge by velocity x time since that edge. It changes
+ * smoothly between edges instead of in steps of a count, which
+ * helps near upright where the pendulum can sit between two edges
+ * for tens of milliseconds. No ISR work is added; the interpolation
+ * is done here when the state is read.
+ * @param  None
+ * @retval position between 0 and 2pi and velocity in radians/s
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+pendulumState_t Pendulum<ppr, mode>::GetInterpolatedStateRad()
+{
+  encoderSnapshot_t snapshot = encoder.GetState();
+  pendulumState_t state;
+  state.position = InterpolatedCounts(snapshot) * RadiansPerCount();
+  state.velocity = (float)snapshot.velocity * RadiansPerCount();
+  return state;
+}
+
+/******************************************************//**
+ * @brief  Returns the position and velocity in degrees with the
+ * position interpolated between edges. See GetInterpolatedStateRad.
+ * @param  None
+ * @retval position between 0 and 360 and velocity in degrees/s
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+pendulumState_t Pendulum<ppr, mode>::GetInterpolatedStateDeg()
+{
+  encoderSnapshot_t snapshot = encoder.GetState();
+  pendulumState_t state;
+  state.position = InterpolatedCounts(snapshot) * DegreesPerCount();
+  state.velocity = (float)snapshot.velocity * DegreesPerCount();
+  return state;
+}
+
+/******************************************************//**
+ * @brief  Returns the angle from upright and the velocity in
+ * radians from a single encoder snapshot. The angle is offset by
+ * the rest position and wrapped to (-pi, pi] on the count as
+ * GetAngleFromUprightRad, so a balance loop can use it as its
+ * angle error directly.
+ * @param  None
+ * @retval angle from upright in radians and velocity in radians/s
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+pendulumState_t Pendulum<ppr, mode>::GetUprightStateRad()
+{
+  encoderSnapshot_t snapshot = encoder.GetState();
+  pendulumState_t state;
+  state.position = (float)UprightCounts(snapshot.position) * RadiansPerCount();
+  state.velocity = (float)snapshot.velocity * RadiansPerCount();
+  return state;
+}
+
+/******************************************************//**
+ * @brief  Returns the angle from upright and the velocity in
+ * degrees from a single encoder snapshot. See GetUprightStateRad.
+ * @param  None
+ * @retval angle from upright in degrees and velocity in degrees/s
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+pendulumState_t Pendulum<ppr, mode>::GetUprightStateDeg()
+{
+  encoderSnapshot_t snapshot = encoder.GetState();
+  pendulumState_t state;
+  state.position = (float)UprightCounts(snapshot.position) * DegreesPerCount();
+  state.velocity = (float)snapshot.velocity * DegreesPerCount();
+  return state;
+}
+
+/******************************************************//**
+ * @brief  Returns the angle from upright and the velocity in
+ * radians with the angle interpolated between edges. See
+ * GetInterpolatedStateRad and GetUprightStateRad.
+ * @param  None
+ * @retval angle from upright in radians and velocity in radians/s
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+pendulumState_t Pendulum<ppr, mode>::GetInterpolatedUprightStateRad()
+{
+  encoderSnapshot_t snapshot = encoder.GetState();
+  pendulumState_t state;
+  state.position = UprightCounts(InterpolatedCounts(snapshot)) * RadiansPerCount();
+  state.velocity = (float)snapshot.velocity * RadiansPerCount();
+  return state;
+}
+
+/******************************************************//**
+ * @brief  Returns the angle from upright and the velocity in
+ * degrees with the angle interpolated between edges. See
+ * GetInterpolatedUprightStateRad.
+ * @param  None
+ * @retval angle from upright in degrees and velocity in degrees/s
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+pendulumState_t Pendulum<ppr, mode>::GetInterpolatedUprightStateDeg()
+{
+  encoderSnapshot_t snapshot = encoder.GetState();
+  pendulumState_t state;
+  state.position = UprightCounts(InterpolatedCounts(snapshot)) * DegreesPerCount();
+  state.velocity = (float)snapshot.velocity * DegreesPerCount();
+  return state;
+}
+
+/******************************************************//**
+ * @brief  Returns the current position away from 0 to 2pi
+ * radians where 0 == 2pi in a CCW rotation, in fixed point.
+ * Integer only, no soft-float on the AVR.
+ * @param  None
+ * @retval position in radians Q16.16
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+angleQ16_t Pendulum<ppr, mode>::GetCurrentPositionQ16()
+{
+  return angleQ16_t::FromRaw(CountsToQ16(encoder.GetCurrentPosition()));
+}
+
+/******************************************************//**
+ * @brief  Returns the angle from upright in radians Q16.16,
+ * wrapped to (-pi, pi] on the count as GetAngleFromUprightRad
+ * @param  None
+ * @retval angle from upright in radians Q16.16 (CCW is + / CW is -)
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+angleQ16_t Pendulum<ppr, mode>::GetAngleFromUprightQ16()
+{
+  return angleQ16_t::FromRaw(CountsToQ16(UprightCounts(encoder.GetCurrentPosition())));
+}
+
+/******************************************************//**
+ * @brief  Returns the angle from upright as a Q15 fraction of
+ * half a turn, 32768 per pi. The 16-bit angle wraps with the
+ * rotation, so upright +-pi reads -32768, and differences of two
+ * angles wrap the same way without a check.
+ * @param  None
+ * @retval angle from upright in Q15 half turns (CCW is + / CW is -)
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+int16_t Pendulum<ppr, mode>::GetAngleFromUprightQ15()
+{
+  return (int16_t)(((int32_t)UprightCounts(encoder.GetCurrentPosition()) * TurnQ15PerCount() + (1L << 14)) >> 15);
+}
+
+/******************************************************//**
+ * @brief  Returns the current rotational velocity in radians/s
+ * Q16.16. Direction is indicated by sign where CCW is + and CW is -
+ * @param  None
+ * @retval the current rotational velocity in radians/s Q16.16
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+angularVelocityQ16_t Pendulum<ppr, mode>::GetCurrentVelocityQ16()
+{
+  return angularVelocityQ16_t::FromRaw(CountsToQ16(encoder.GetCurrentVelocity()));
+}
+
+/******************************************************//**
+ * @brief  Returns the position and velocity in radians Q16.16
+ * from a single encoder snapshot. See GetStateRad.
+ * @param  None
+ * @retval position between 0 and 2pi and velocity in radians/s, Q16.16
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+pendulumStateQ16_t Pendulum<ppr, mode>::GetStateQ16()
+{
+  encoderSnapshot_t snapshot = encoder.GetState();
+  pendulumStateQ16_t state;
+  state.position = angleQ16_t::FromRaw(CountsToQ16(snapshot.position));
+  state.velocity = angularVelocityQ16_t::FromRaw(CountsToQ16(snapshot.velocity));
+  return state;
+}
+
+/******************************************************//**
+ * @brief  Returns the angle from upright and the velocity in
+ * radians Q16.16 from a single encoder snapshot. See
+ * GetUprightStateRad.
+ * @param  None
+ * @retval angle from upright in (-pi, pi] and velocity in radians/s, Q16.16
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+pendulumStateQ16_t Pendulum<ppr, mode>::GetUprightStateQ16()
+{
+  encoderSnapshot_t snapshot = encoder.GetState();
+  pendulumStateQ16_t state;
+  state.position = angleQ16_t::FromRaw(CountsToQ16(UprightCounts(snapshot.position)));
+  state.velocity = angularVelocityQ16_t::FromRaw(CountsToQ16(snapshot.velocity));
+  return state;
+}
+
+/******************************************************//**
+ * @brief  Returns the energy of the swing per moment of inertia
+ * from a single encoder snapshot,
+ *
+ *   E = theta'^2 / 2 + (g/l) (cos(theta) - 1)
+ *
+ * with theta from upright, so E is 0 balanced at rest upright and
+ * -2g/l hanging at rest. An energy swing-up drives it to 0. The
+ * cosine is one read of the flash table at the count from upright
+ * and the products are 32-bit, so nothing here is floating point.
+ * Set the natural frequency with SetNaturalFrequency first.
+ * @param  None
+ * @retval energy in radians^2/s^2 Q16.16
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+energyQ16_t Pendulum<ppr, mode>::GetEnergyQ16()
+{
+  encoderSnapshot_t snapshot = encoder.GetState();
+  int16_t fromUpright = UprightCounts(snapshot.position);
+  uint16_t index = fromUpright < 0 ? fromUpright + CountsPerRotation() : fromUpright;
+
+  /* theta' in Q8 squares to Q16 in 32 bits up to 181 rad/s */
+  int32_t velocity = CountsToQ16(snapshot.velocity) >> 8;
+  velocity = velocity > 46340 ? 46340 : (velocity < -46340 ? -46340 : velocity);
+  int32_t kinetic = (velocity * velocity) >> 1;
+
+  /* g/l in Q8 times 1 - cos in Q15 is Q23, at most 32 bits unsigned */
+  int32_t potential = (int32_t)(((uint32_t)naturalFrequencySquared * (uint32_t)(Trig_Table_One - CosQ15(index))) >> 7);
+  return energyQ16_t::FromRaw(kinetic - potential);
+}
+
+/******************************************************//**
+ * @brief  Returns the observer position away from 0 to 2pi
+ * radians where 0 == 2pi in a CCW rotation. Unlike the count it
+ * places the pendulum within a count.
+ * @param  None
+ * @retval position in radians
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetObservedPositionRad()
+{
+  observerState_t state;
+  encoder.GetObserverState(state);
+  return (float)state.position * (RadiansPerCount() / 65536.0f);
+}
+
+/******************************************************//**
+ * @brief  Returns the observer position away from 0 to 360
+ * degrees where 0 == 360 in a CCW rotation.
+ * @param  None
+ * @retval position in degrees
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetObservedPositionDeg()
+{
+  observerState_t state;
+  encoder.GetObserverState(state);
+  return (float)state.position * (DegreesPerCount() / 65536.0f);
+}
+
+/******************************************************//**
+ * @brief  Returns the observer angle from upright, offset by the
+ * rest position and wrapped to (-pi, pi]
+ * @param  None
+ * @retval angle from upright in radians (CCW is + / CW is -)
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetObservedAngleFromUprightRad()
+{
+  observerState_t state;
+  encoder.GetObserverState(state);
+  return UprightCounts((float)state.position * (1.0f / 65536.0f)) * RadiansPerCount();
+}
+
+/******************************************************//**
+ * @brief  Returns the observer angle from upright wrapped to
+ * (-180, 180]
+ * @param  None
+ * @retval angle from upright in degrees (CCW is + / CW is -)
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetObservedAngleFromUprightDeg()
+{
+  observerState_t state;
+  encoder.GetObserverState(state);
+  return UprightCounts((float)state.position * (1.0f / 65536.0f)) * DegreesPerCount();
+}
+
+/******************************************************//**
+ * @brief  Returns the observer rotational velocity in radians/s.
+ * Direction is indicated by sign where CCW is + and CW is -
+ * @param  None
+ * @retval the observed rotational velocity in radians/s
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetObservedVelocityRad()
+{
+  observerState_t state;
+  encoder.GetObserverState(state);
+  return (float)state.velocity * (RadiansPerCount() / 65536.0f * observerUpdatesPerSecond);
+}
+
+/******************************************************//**
+ * @brief  Returns the observer rotational velocity in degrees/s.
+ * Direction is indicated by sign where CCW is + and CW is -
+ * @param  None
+ * @retval the observed rotational velocity in degrees/s
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetObservedVelocityDeg()
+{
+  observerState_t state;
+  encoder.GetObserverState(state);
+  return (float)state.velocity * (DegreesPerCount() / 65536.0f * observerUpdatesPerSecond);
+}
+
+/******************************************************//**
+ * @brief  Returns the observer rotational acceleration in
+ * radians/s^2, CCW is +
+ * @param  None
+ * @retval the observed rotational acceleration in radians/s^2
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetObservedAccelerationRad()
+{
+  observerState_t state;
+  encoder.GetObserverState(state);
+  return (float)state.acceleration *
+         (RadiansPerCount() / 65536.0f * observerUpdatesPerSecond * observerUpdatesPerSecond);
+}
+
+/******************************************************//**
+ * @brief  Returns the observer rotational acceleration in
+ * degrees/s^2, CCW is +
+ * @param  None
+ * @retval the observed rotational acceleration in degrees/s^2
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+float Pendulum<ppr, mode>::GetObservedAccelerationDeg()
+{
+  observerState_t state;
+  encoder.GetObserverState(state);
+  return (float)state.acceleration *
+         (DegreesPerCount() / 65536.0f * observerUpdatesPerSecond * observerUpdatesPerSecond);
+}
+
+/******************************************************//**
+ * @brief  Scales counts to radians Q16.16 with the constant
+ * RadiansQ16PerCount. The counts are split at 8 bits so both
+ * products stay in 32 bits with a 17-bit scale, up to 2^22 counts/s
+ * at 1440 counts per rotation, far above what the decoder follows.
+ * @param  counts Counts or counts/s
+ * @retval radians or radians/s in Q16.16
+ **********************************************************/
+template <uint16_t ppr, decodeMode_t mode>
+int32_t Pendulum<ppr, mode>::CountsToQ16(int32_t counts)
+{
+  return ((counts >> 8) * RadiansQ16PerCount() >> (Q16Shift() - 8)) +
+         ((counts & 0xFF) * RadiansQ16PerCount() >> Q16Shift());
+}
 
-#endif /* #ifndef __PENDULUM_H_INCLUDED */
\ No newline at end of file
+#endif /* #ifndef __PENDULUM_H_INCLUDED */
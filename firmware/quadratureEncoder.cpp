@@ -12,29 +12,159 @@
  **********************************************************/
 
 #include "quadratureEncoder.h"
+#ifdef QUADRATURE_TIMER1_COUNTER
+#include "l6474.h"
+#endif
 #include <Arduino.h>
 
 #define Fast_Calc_Threshold   130
-#define Isr_Sample_Period_Us  16225
+
+/// Pulse counting needs this many counts in a sample window, so at faster sample
+/// rates the switch to it moves up from Fast_Calc_Threshold
+#define Fast_Calc_Window_Counts  (4)
+
+/// A pulse timing speed times out once the time since the last edge is this many
+/// eighths of the pulse period it was measured at, leaving room for jitter
+#define Speed_Timeout_Eighths  (10)
+
+/// Timer 2 as a timestamp clock: clk/8 counting 0 to 255, so a compare match
+/// every 128us and the step clock runs on every timestampCycles-th of them
+#define Timer2_Timestamps_Per_Second  (F_CPU / 8)
+#define Timer2_Timestamp_Top          (0xFF)
+
+/// State observer: updates on every 8th Timer 2 compare match (1.024ms) with Timer 2
+/// timestamps and on every step clock with micros(). Half a count in Q16.16, and the
+/// largest residual one update corrects, the range of a Q8 int16_t.
+#define Observer_Timer2_Cycles        (8)
+#define Observer_Half_Count           (0x8000L)
+#define Observer_Max_Residual         (127L << 16)
+
+/// Largest observer gain exponent, so the ISR shifts the 32-bit product by at most 31 bits
+#define Observer_Max_Gain_Exponent    (24)
+
+/// Edge record bit set when pin B raised the record
+#define Edge_Record_Pin_B             (0x04)
+
+/// Edges closer than this can come faster than the ISRs run, the step clock sample alone holds
+/// them off for about 50us. A decode that loses counts in a run of this many edges in a row,
+/// each this close and in one direction, is an overrun. A glitch right after an edge is no run.
+#define Overrun_Edge_Us               (80)
+#define Overrun_Run_Edges             (3)
+
+/// heldState when the glitch filter holds no read
+#define No_Held_State                 (0xFF)
 
 /// static member definitions
-class QuadratureEncoder* QuadratureEncoder::instancePtr = NULL;
+class QuadratureEncoder* QuadratureEncoder::instances[Encoder_Max_Instances] = {NULL};
+class QuadratureEncoder* QuadratureEncoder::timer2Owner = NULL;
+volatile uint32_t QuadratureEncoder::timer2Cycles = 0;
+
+/* Count for each transition of the BA state, indexed by [n-1][n]. BA follows
+ * 11, 01, 00, 10 while turning CCW. No change and both lines changing (an edge
+ * was missed, the direction is unknown) do not count. */
+static const int8_t Decode_4x_Table[16] = {
+   0, -1,  1,  0,
+   1,  0,  0, -1,
+  -1,  0,  0,  1,
+   0,  1, -1,  0
+};
 
 /******************************************************//**
- * @brief  Constructor for the encoder object. Sets the pulses per
- * rotation of the device and initializes necessary member variables
- * to their appropriate starting values.
- * @param  None
+ * @brief  Constructor for the encoder object. Takes the first free
+ * of the Encoder_Max_Instances slots, which selects the ISR
+ * trampolines of the encoder, and initializes necessary member
+ * variables to their appropriate starting values. Lines on pins 2
+ * and 3 are decoded through INT0/INT1, lines on any other pins
+ * through the pin change interrupt of their port, which is why both
+ * must be on the same port. An encoder on the pins of one already
+ * constructed takes over its slot, as the single instance used to,
+ * and one constructed with every slot taken gets no interrupts.
+ * @param  pinA Digital pin of the A line, Quadrature_Pulse_A_Pin by default
+ * @param  pinB Digital pin of the B line, Quadrature_Pulse_B_Pin by default
  * @retval None
  **********************************************************/
-QuadratureEncoder::QuadratureEncoder()
+QuadratureEncoder::QuadratureEncoder(uint8_t pinA, uint8_t pinB)
 {
+  pulsePinA = pinA;
+  pulsePinB = pinB;
+  pinInput = portInputRegister(digitalPinToPort(pinA));
+  maskA = digitalPinToBitMask(pinA);
+  maskB = digitalPinToBitMask(pinB);
+  pinChange = digitalPinToInterrupt(pinA) == NOT_AN_INTERRUPT || digitalPinToInterrupt(pinB) == NOT_AN_INTERRUPT;
+  pinChangePort = digitalPinToPCICRbit(pinA);
+  pinLevels = 0;
+  pulsesPerRotation = 0;
   pulsesPerSample = 0;
   directionVector = 0;
   speed[0] = 0;
   speed[1] = 0;
   doFastPulseCalc = false;
-  instancePtr = this;
+  fastCalcThreshold = Fast_Calc_Threshold;
+  decodeMode = DECODE_1X;
+  timestampSource = TIMESTAMP_MICROS;
+  timestampsPerSecond = 1000000L;
+  sampleTimer = SampleTimer<Sample_Timer_Default_Hz>::Config();
+  samplePeriod = sampleTimer.periodUs;
+  sampleCycles = 0;
+  velocityEstimator = VELOCITY_IIR;
+  windowEdgeTime = 0;
+  windowStartTime = 0;
+  lastPositionTime = 0;
+  stateSequence = 0;
+  edgeCount = 0;
+  homeCount = 0;
+  edgeDirection = 0;
+  priorPositionTime = 0;
+  priorDirection = 0;
+  glitchFilterUs = 0;
+  glitchFilter = 0;
+  overrunInterval = 0;
+  heldState = No_Held_State;
+  heldTime = 0;
+  heldCharge = 0;
+  lateRead = false;
+  fastEdges = 0;
+  illegalTransitions = 0;
+  overruns = 0;
+  suspectedMissedCounts = 0;
+  glitches = 0;
+  minEdgeInterval = ~0UL;
+  windowTime = NULL;
+  windowSize = 0;
+  windowFill = 0;
+  windowIndex = 0;
+  windowDirection = 0;
+  windowSum[0] = 0;
+  windowSum[1] = 0;
+  sampleTime = 0;
+  observerBandwidth = 0;
+  observerPeriod = sampleTimer.periodUs;
+  observerPosition = 0;
+  observerVelocity = 0;
+  observerAcceleration = 0;
+  observerEdgeTime = 0;
+  observerUpdateTime = 0;
+  edgeProcessing = EDGE_PROCESS_ISR;
+  edgeRing = NULL;
+  edgeRingSize = 0;
+  edgeHead = 0;
+  edgeTail = 0;
+  droppedEdges = 0;
+#ifdef QUADRATURE_TIMER1_COUNTER
+  counterLast = 0;
+  counterDirection = INCRIMENT_CCW;
+#endif
+
+  for (instanceIndex = 0; instanceIndex < Encoder_Max_Instances; instanceIndex++)
+  {
+    class QuadratureEncoder* instancePtr = instances[instanceIndex];
+    if (instancePtr == NULL || (instancePtr->pulsePinA == pinA && instancePtr->pulsePinB == pinB))
+    {
+      timer2Owner = timer2Owner == instancePtr ? NULL : timer2Owner;
+      instances[instanceIndex] = this;
+      break;
+    }
+  }
 }
 
 /******************************************************//**
@@ -42,44 +172,112 @@ QuadratureEncoder::QuadratureEncoder()
  * encoder and starts the library. Cannot be done in constructor
  * as ISR must be setup in an init function call.
  * @param  ppr Pulses per full rotation of the quadrature encoder
+ * @param  mode DECODE_1X counts falling edges only, DECODE_4X counts
+ * every edge for four times the resolution
+ * @param  source TIMESTAMP_MICROS times the pulses with micros(),
+ * TIMESTAMP_TIMER2 with the Timer 2 counter at 0.5us resolution
+ * @param  timerConfig Speed sample rate from SampleTimer<rateHz>::Config(),
+ * 61Hz by default. Begin<rateHz>() fills it in, match it to the control
+ * loop so each reading covers one loop period.
  * @retval None
+ * @note   All encoders share Timer 2. The first one begun sets it up,
+ * and an encoder begun while another one runs it takes the timestamp
+ * source and sample rate of that encoder instead of its own.
  **********************************************************/
-void QuadratureEncoder::Begin(uint16_t ppr)
+void QuadratureEncoder::Begin(uint16_t ppr, decodeMode_t mode, timestampSource_t source,
+                              sampleTimerConfig_t timerConfig)
 {
-  pulsesPerRotation = ppr;
+  if (timer2Owner == NULL)
+  {
+    timer2Owner = this;
+  }
+  else if (timer2Owner != this)
+  {
+    source = timer2Owner->timestampSource;
+    timerConfig = timer2Owner->sampleTimer;
+  }
+
+  decodeMode = mode;
+  pulsesPerRotation = ppr * mode;
+  timestampSource = source;
+  sampleTimer = timerConfig;
+  if (timestampSource == TIMESTAMP_TIMER2)
+  {
+    timestampsPerSecond = Timer2_Timestamps_Per_Second;
+    samplePeriod = (unsigned long)sampleTimer.timestampCycles * (Timer2_Timestamp_Top + 1);
+    observerPeriod = (unsigned long)Observer_Timer2_Cycles * (Timer2_Timestamp_Top + 1);
+  }
+  else
+  {
+    timestampsPerSecond = 1000000L;
+    samplePeriod = sampleTimer.periodUs;
+    observerPeriod = sampleTimer.periodUs;
+  }
+  unsigned long windowThreshold = Fast_Calc_Window_Counts * timestampsPerSecond / samplePeriod;
+  fastCalcThreshold = windowThreshold > Fast_Calc_Threshold ? windowThreshold : Fast_Calc_Threshold;
 
   //LDP3806 encoder uses an open-collector output. Enable internal input pullup resistors as they are required.
-  pinMode(Quadrature_Pulse_A_Pin, INPUT_PULLUP);
-  pinMode(Quadrature_Pulse_B_Pin, INPUT_PULLUP);
+  pinMode(pulsePinA, INPUT_PULLUP);
+  pinMode(pulsePinB, INPUT_PULLUP);
 
   /* Initialize state history to in-between state history of so next pulse will be counted.
    * Falling edge state 0b11 never exists, but can be masked for leading pulse state */
   encoderState = 255;
+  heldState = No_Held_State;
+  lateRead = false;
+  fastEdges = 0;
 
   // setup interrupts
-  attachInterrupt(digitalPinToInterrupt(Quadrature_Pulse_A_Pin), LeadPulseA, FALLING);
-  attachInterrupt(digitalPinToInterrupt(Quadrature_Pulse_B_Pin), LeadPulseB, FALLING);
-  InitIsrIntervalForTimer2();
+  edgeHead = 0;
+  edgeTail = 0;
+  AttachEdgeInterrupts();
+  if (timer2Owner == this)
+  {
+    InitIsrIntervalForTimer2();
+  }
+  else
+  {
+    sampleCycles = 0;
+  }
 
   SetHomePosition();
-  lastPositionTime = micros();
+  noInterrupts();
+  lastPositionTime = GetTimestamp();
+  windowEdgeTime = lastPositionTime;
+  windowStartTime = lastPositionTime;
+  priorPositionTime = lastPositionTime;
+  interrupts();
+
+  /* The filter time depends on the rate of the timestamp clock, and the overrun interval
+   * also on the edges per count */
+  SetGlitchFilter(glitchFilterUs);
+  overrunInterval = (unsigned long)Overrun_Edge_Us * (timestampsPerSecond / 1000L) / 1000L * (DECODE_4X / mode);
+  ResetDiagnostics();
+
+  /* The gains depend on the update period of the timestamp clock */
+  SetObserverBandwidth(observerBandwidth);
 }
 
 /******************************************************//**
  * @brief  Sets the home position of the encoder to 0. The
  * home position is equal to the ppr in the same way 360 == 0
- * on a standard position coordinate plane.
+ * on a standard position coordinate plane. The absolute
+ * position restarts from 0 turns.
  * @param  None
  * @retval None
  **********************************************************/
 void QuadratureEncoder::SetHomePosition()
 {
+  noInterrupts();
   position = 0;
+  homeCount = edgeCount;
+  stateSequence++;
+  interrupts();
 }
 
 /******************************************************//**
- * @brief  Return the number of pulses in one rotation of 
- * the quadrature
+ * @brief  Return the number of counts in one rotation of 
+ * the quadrature, the encoder ppr times the decode mode
  * @param  None
  * @retval pulses per rotation member variable
  **********************************************************/
@@ -89,113 +287,1367 @@ uint16_t QuadratureEncoder::GetPulsesPerRotation()
 }
 
 /******************************************************//**
- * @brief  Returns the current position in pulses away from
- * 0 to ppr-1 in a CCW rotation.
+ * @brief  Return the decoding mode given to Begin
+ * @param  None
+ * @retval decode mode member variable
+ **********************************************************/
+decodeMode_t QuadratureEncoder::GetDecodeMode()
+{
+  return decodeMode;
+}
+
+/******************************************************//**
+ * @brief  Selects the velocity estimation method. VELOCITY_IIR
+ * switches between pulse timing and pulse counting at the
+ * GetFastCalcThreshold() speed. VELOCITY_MT counts the pulses of each step
+ * clock window and divides them by the exact time between the last
+ * edge of the previous window and the last edge of this one, so one
+ * estimate covers the whole speed range. VELOCITY_LSQ fits a line
+ * to the timestamps of the last GetVelocityWindow() edges when the
+ * velocity is read, see FitWindow. It needs the timestamp buffer
+ * given to SetVelocityWindow first.
+ * @param  estimator VELOCITY_IIR, VELOCITY_MT or VELOCITY_LSQ
+ * @retval false if VELOCITY_LSQ was refused for want of a window, else true
+ **********************************************************/
+bool QuadratureEncoder::SetVelocityEstimator(velocityEstimator_t estimator)
+{
+  if (estimator == VELOCITY_LSQ && windowTime == NULL)
+  {
+    return false;
+  }
+
+  noInterrupts();
+  velocityEstimator = estimator;
+  pulsesPerSample = 0;
+  doFastPulseCalc = false;
+  windowEdgeTime = lastPositionTime;
+  windowDirection = 0;
+  interrupts();
+  return true;
+}
+
+/******************************************************//**
+ * @brief  Returns the velocity estimation method
+ * @param  None
+ * @retval velocity estimator member variable
+ **********************************************************/
+velocityEstimator_t QuadratureEncoder::GetVelocityEstimator()
+{
+  return velocityEstimator;
+}
+
+/******************************************************//**
+ * @brief  Selects where the edges are decoded. EDGE_PROCESS_ISR
+ * decodes every edge in its pin change ISR. EDGE_PROCESS_DEFERRED
+ * keeps the pin change ISRs to a pin read and a timestamp pushed
+ * into the ring given here, which holds one edge less than its
+ * size (Edge_Ring_Size suits a 1kHz loop), and DecodeEdges() decodes the queued edges from the
+ * main loop and estimates the speed over them with the M/T method,
+ * or feeds them to the VELOCITY_LSQ fit when that is selected. The step clock then only runs
+ * the observer. EDGE_PROCESS_COUNTER, built with QUADRATURE_TIMER1_COUNTER, takes no
+ * interrupt per edge at all: A also drives T1 (Quadrature_Counter_Pin) and Timer 1
+ * counts its falling edges, while a D flip-flop clocked by the falling edge of A latches
+ * B onto the B pin, so INT1 only fires on a reversal. The position is one count per pulse
+ * times the decode mode, the velocity is the M/T estimate whatever estimator is selected
+ * and saturates at 65535 counts/s, 16383 pulses/s in 4x, and a vibration across one edge
+ * of A counts each time in the latched direction. The counter keeps no edge times, so
+ * below a few pulses per sample the velocity is a coarse pulse count. Timer 1 is the step
+ * clock of L6474 shield 0: the counter reserves it, is refused once the L6474 library has
+ * begun, and L6474::Begin is refused while the counter holds it. Call after Begin; Begin
+ * keeps the selection.
+ * @param  processing EDGE_PROCESS_ISR, EDGE_PROCESS_DEFERRED or EDGE_PROCESS_COUNTER
+ * @param  ring Edge records for EDGE_PROCESS_DEFERRED, kept until another processing is set
+ * @param  ringSize Records in ring, 2 to 255
+ * @retval false if the processing was refused and is unchanged, else true
+ **********************************************************/
+bool QuadratureEncoder::SetEdgeProcessing(edgeProcessing_t processing, edgeRecord_t *ring, uint8_t ringSize)
+{
+  if (processing == EDGE_PROCESS_DEFERRED && (ring == NULL || ringSize < 2))
+  {
+    return false;
+  }
+#ifdef QUADRATURE_TIMER1_COUNTER
+  if (processing == EDGE_PROCESS_COUNTER && !L6474::ReserveTimer1(true))
+  {
+    return false;
+  }
+#endif
+
+  /* Count what is still queued before the ISRs change */
+  DecodeEdges();
+
+  noInterrupts();
+#ifdef QUADRATURE_TIMER1_COUNTER
+  if (edgeProcessing == EDGE_PROCESS_COUNTER && processing != EDGE_PROCESS_COUNTER)
+  {
+    /* Count what Timer 1 holds, then stop it and give it back */
+    UpdateCounter();
+    TCCR1B = 0;
+    L6474::ReserveTimer1(false);
+  }
+#endif
+  edgeProcessing = processing;
+  edgeRing = processing == EDGE_PROCESS_DEFERRED ? ring : NULL;
+  edgeRingSize = processing == EDGE_PROCESS_DEFERRED ? ringSize : 0;
+  edgeHead = 0;
+  edgeTail = 0;
+  pulsesPerSample = 0;
+  doFastPulseCalc = false;
+  windowEdgeTime = lastPositionTime;
+  windowStartTime = lastPositionTime;
+  heldState = No_Held_State;
+  lateRead = false;
+  AttachEdgeInterrupts();
+  interrupts();
+  return true;
+}
+
+/******************************************************//**
+ * @brief  Returns where the edges are decoded
+ * @param  None
+ * @retval edge processing member variable
+ **********************************************************/
+edgeProcessing_t QuadratureEncoder::GetEdgeProcessing()
+{
+  return edgeProcessing;
+}
+
+/******************************************************//**
+ * @brief  Decodes the edges the pin change ISRs queued since the
+ * last call with the same 1x or 4x rules the ISRs use, then
+ * publishes the position in one short critical section. The M/T
+ * speed is updated once the calls span a step clock sample period,
+ * or at once when the batch reverses the window's direction. The records keep 16 bits of timestamp, so
+ * call at least every 32ms with Timer 2 timestamps and every 65ms
+ * with micros(), and once per observer update for the observer to
+ * see each edge in its own update. Does nothing when the edges are
+ * decoded in the ISRs.
+ * @param  None
+ * @retval number of edges decoded
+ **********************************************************/
+uint8_t QuadratureEncoder::DecodeEdges()
+{
+  if (edgeProcessing != EDGE_PROCESS_DEFERRED)
+  {
+    return 0;
+  }
+
+  /* Every record before the head is older than now */
+  uint8_t head = edgeHead;
+  noInterrupts();
+  unsigned long now = GetTimestamp();
+  interrupts();
+
+  uint8_t tail = edgeTail;
+  uint8_t state = encoderState;
+  uint8_t decoded = 0;
+  int16_t counts = 0;
+  int8_t direction = edgeDirection;
+  unsigned long edgeTime = lastPositionTime;
+  int8_t priorEdgeDirection = priorDirection;
+  unsigned long priorEdgeTime = priorPositionTime;
+  while (tail != head)
+  {
+    edgeRecord_t record = edgeRing[tail];
+    tail = tail + 1 < edgeRingSize ? tail + 1 : 0;
+    decoded++;
+    unsigned long recordTime = now - (uint16_t)((uint16_t)now - record.time);
+    uint8_t lines = record.state & MASK_GET_STATE_0;
+
+    /* The glitch filter hold as in DecodeChange */
+    if (heldState != No_Held_State && lines != (state & MASK_GET_STATE_0))
+    {
+      if (recordTime - heldTime < glitchFilter)
+      {
+        state = (state & ~MASK_GET_STATE_0) | heldState;
+        CountHeldGlitch();
+      }
+      heldState = No_Held_State;
+    }
+    state = (state << 2) | lines;
+
+    /* The late reads as in DecodeChange, DecodePulseA and DecodePulseB */
+    int8_t step;
+    if (decodeMode == DECODE_4X)
+    {
+      step = Decode_4x_Table[state & (MASK_GET_STATE_1 | MASK_GET_STATE_0)];
+      if (step != 0)
+      {
+        lateRead = step != direction && InFastRun(recordTime, edgeTime);
+        if (lateRead)
+        {
+          CountOverrun(4);
+        }
+      }
+      else if ((((state >> 2) ^ state) & MASK_GET_STATE_0) == MASK_GET_STATE_0)
+      {
+        /* The glitch hidden behind an edge of the other line as in DecodeChange */
+        step = Decode_4x_Table[((state >> 2) & MASK_GET_STATE_1) | (state & MASK_GET_STATE_0)];
+        if (step != 0 && direction != 0 && recordTime - edgeTime < glitchFilter)
+        {
+          counts -= direction;
+          glitches++;
+          direction = priorEdgeDirection;
+          edgeTime = priorEdgeTime;
+          lateRead = false;
+        }
+        else
+        {
+          step = 0;
+          CountIllegal(2);
+          lateRead = true;
+          if (glitchFilter != 0)
+          {
+            heldState = (state >> 2) & MASK_GET_STATE_0;
+            heldTime = recordTime;
+            heldCharge = 2;
+          }
+        }
+      }
+      else if (lateRead)
+      {
+        lateRead = false;
+      }
+      else
+      {
+        if (InFastRun(recordTime, edgeTime))
+        {
+          CountOverrun(4);
+        }
+        else
+        {
+          CountIllegal(0);
+        }
+        lateRead = true;
+      }
+    }
+    else
+    {
+      bool pinB = record.state & Edge_Record_Pin_B;
+      if (state & MASK_GET_STATE_0)
+      {
+        step = 0;
+      }
+      else if (pinB)
+      {
+        step = (state & MASK_A_TRANSITION_TO_B_COUNT) ? INCRIMENT_CW : 0;
+      }
+      else
+      {
+        step = (state & MASK_B_TRANSITION_TO_A_COUNT) ? INCRIMENT_CCW : 0;
+      }
+
+      if (step != 0)
+      {
+        if (step != direction && InFastRun(recordTime, edgeTime))
+        {
+          CountOverrun(2);
+        }
+      }
+      else if (direction == (pinB ? INCRIMENT_CW : INCRIMENT_CCW) &&
+               InFastRun(recordTime, edgeTime))
+      {
+        CountOverrun(1);
+      }
+      /* The line of the record is high again, the falling edge was gone before the ISR read it */
+      else if (lines & (pinB ? 0x02 : 0x01))
+      {
+        CountIllegal(0);
+      }
+    }
+
+    if (step != 0)
+    {
+      unsigned long interval = recordTime - edgeTime;
+      counts += step;
+      if (interval < minEdgeInterval)
+      {
+        minEdgeInterval = interval;
+      }
+      fastEdges = (interval < overrunInterval && step == direction) ? fastEdges + (fastEdges < 255) : 0;
+
+      /* The glitch filter as in UpdatePosition */
+      if (interval < glitchFilter && step != direction)
+      {
+        glitches++;
+        direction = priorEdgeDirection;
+        edgeTime = priorEdgeTime;
+        continue;
+      }
+
+      priorEdgeDirection = direction;
+      priorEdgeTime = edgeTime;
+      direction = step;
+      edgeTime = recordTime;
+      if (velocityEstimator == VELOCITY_LSQ)
+      {
+        UpdateWindow(step, edgeTime);
+      }
+    }
+  }
+  encoderState = state;
+  edgeTail = tail;
+
+  int16_t newPosition = (position + counts) % (int16_t)pulsesPerRotation;
+  newPosition += newPosition < 0 ? (int16_t)pulsesPerRotation : 0;
+
+  /* The ISRs no longer touch the speed, only the observer reads the edges. The M/T window
+   * spans the calls of one step clock sample period, as in ISR decoding: over a single call
+   * of a fast control loop it holds one or two edges and the speed is mostly edge jitter.
+   * A reversal closes the window early, so the speed does not lag a swing through zero. */
+  if (velocityEstimator != VELOCITY_LSQ)
+  {
+    bool reversed = (counts > 0 && pulsesPerSample < 0) || (counts < 0 && pulsesPerSample > 0);
+    pulsesPerSample += counts;
+    if (reversed || now - windowStartTime >= samplePeriod)
+    {
+      UpdateSpeedMT(pulsesPerSample, edgeTime, now);
+      pulsesPerSample = 0;
+      windowStartTime = now;
+    }
+  }
+  noInterrupts();
+  position = newPosition;
+  edgeCount += counts;
+  edgeDirection = direction;
+  lastPositionTime = edgeTime;
+  priorDirection = priorEdgeDirection;
+  priorPositionTime = priorEdgeTime;
+  stateSequence++;
+  interrupts();
+  return decoded;
+}
+
+/******************************************************//**
+ * @brief  Returns the edges the pin change ISRs could not queue
+ * because DecodeEdges() had not emptied the ring in time. In 4x
+ * decoding a lost edge also loses the transition after it.
+ * @param  None
+ * @retval dropped edges since Begin, wraps at 65535
+ **********************************************************/
+uint16_t QuadratureEncoder::GetDroppedEdges()
+{
+  noInterrupts();
+  uint16_t dropped = droppedEdges;
+  interrupts();
+  return dropped;
+}
+
+/******************************************************//**
+ * @brief  Sets the glitch filter of 4x decoding. Glitches and
+ * bounces shorter than filterUs are kept out of the position and
+ * the edge timing and counted in the glitches of GetDiagnostics().
+ * Keep the time below the shortest real edge interval. 1x decoding
+ * is not filtered.
+ * @param  filterUs filter time in microseconds, 0 turns the filter off
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::SetGlitchFilter(uint16_t filterUs)
+{
+  unsigned long ticks = ((unsigned long)filterUs * (timestampsPerSecond / 1000L) + 999L) / 1000L;
+  noInterrupts();
+  glitchFilterUs = filterUs;
+  glitchFilter = ticks;
+  interrupts();
+}
+
+/******************************************************//**
+ * @brief  Returns the glitch filter time
+ * @param  None
+ * @retval filter time in microseconds, 0 when off
+ **********************************************************/
+uint16_t QuadratureEncoder::GetGlitchFilter()
+{
+  return glitchFilterUs;
+}
+
+/******************************************************//**
+ * @brief  Returns the signal integrity counters since Begin or the
+ * last ResetDiagnostics(). An illegal transition is an edge whose
+ * state the decoder cannot count: both lines changed since the
+ * previous edge (an edge was missed and the direction is unknown,
+ * two counts lost in 4x decoding), or the line already back when
+ * its ISR read it (a glitch shorter than the ISR latency). In a run
+ * of Overrun_Run_Edges edges closer than Overrun_Edge_Us, an ISR
+ * may read several edges late and find a legal state, so there a
+ * read that loses counts is an overrun: in 4x decoding a reversal
+ * (three edges read as one back, four counts) or no change (four
+ * edges), in 1x decoding a falling edge of the counting line that
+ * does not count (one count) or counts the other way (two). Five or
+ * more edges in one late read look like one and are not seen. In
+ * hardware counting no edge is seen and the counters stay at 0.
+ * @param  diagnostics Receives the counters
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::GetDiagnostics(encoderDiagnostics_t &diagnostics)
+{
+  noInterrupts();
+  diagnostics.illegalTransitions = illegalTransitions;
+  diagnostics.overruns = overruns;
+  diagnostics.suspectedMissedCounts = suspectedMissedCounts;
+  diagnostics.glitches = glitches;
+  diagnostics.droppedEdges = droppedEdges;
+  diagnostics.minEdgeInterval = minEdgeInterval;
+  interrupts();
+}
+
+/******************************************************//**
+ * @brief  Clears the signal integrity counters, including the
+ * edges dropped from the deferred queue
+ * @param  None
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::ResetDiagnostics()
+{
+  noInterrupts();
+  illegalTransitions = 0;
+  overruns = 0;
+  suspectedMissedCounts = 0;
+  glitches = 0;
+  droppedEdges = 0;
+  minEdgeInterval = ~0UL;
+  heldCharge = 0;
+  interrupts();
+}
+
+/******************************************************//**
+ * @brief  Sets the number of edges the VELOCITY_LSQ fit runs
+ * over. The velocity is the slope of the fit at the middle of the
+ * window, so it lags by half the window, (edges - 1) / 2 edge
+ * periods, and its timestamp noise falls with edges^1.5. The
+ * timestamps of the window are kept in times, so only an encoder
+ * that fits pays for them.
+ * @param  edges 2 to Velocity_Max_Window
+ * @param  times Buffer of at least edges timestamps, kept while the encoder runs
+ * @retval false if times is NULL and the window is unchanged, else true
+ **********************************************************/
+bool QuadratureEncoder::SetVelocityWindow(uint8_t edges, unsigned long *times)
+{
+  if (times == NULL)
+  {
+    return false;
+  }
+
+  edges = edges < 2 ? 2 : (edges > Velocity_Max_Window ? Velocity_Max_Window : edges);
+  noInterrupts();
+  windowTime = times;
+  windowSize = edges;
+  windowDirection = 0;
+  stateSequence++;
+  interrupts();
+  return true;
+}
+
+/******************************************************//**
+ * @brief  Returns the number of edges the VELOCITY_LSQ fit runs over
+ * @param  None
+ * @retval window size member variable, 0 before SetVelocityWindow
+ **********************************************************/
+uint8_t QuadratureEncoder::GetVelocityWindow()
+{
+  return windowSize;
+}
+
+/******************************************************//**
+ * @brief  Returns the current position in counts away from
+ * 0 to GetPulsesPerRotation()-1 in a CCW rotation.
  * @param  None
  * @retval position member variable
  **********************************************************/
 int16_t QuadratureEncoder::GetCurrentPosition()
 {
-  return position;
+  return GetPositionState().position;
 }
 
 /******************************************************//**
  * @brief  Returns the current rotational velocity of the
- * device in pulses per second (pps). Direction is indicated
- * by sign where CCW is + and CW is -
+ * device in counts per second, pulses per second (pps) in 1x
+ * decoding. Direction is indicated by sign where CCW is + and CW is -
  * @param  None
- * @retval the current rotational velocity in pps
+ * @retval the current rotational velocity in counts/s
  **********************************************************/
 int32_t QuadratureEncoder::GetCurrentVelocity()
 {
-  return (int32_t)speed[0] * directionVector;
+  return GetState().velocity;
+}
+
+/******************************************************//**
+ * @brief  Returns the position in counts away from home without
+ * the rollover, so whole turns add GetPulsesPerRotation() each.
+ * The 32-bit count covers over a million turns at 1440 counts.
+ * @param  None
+ * @retval absolute position in counts (CCW is + / CW is -)
+ **********************************************************/
+int32_t QuadratureEncoder::GetAbsolutePosition()
+{
+  return GetPositionState().absolutePosition;
+}
+
+/******************************************************//**
+ * @brief  Returns the whole turns away from home, rounded towards
+ * minus infinity so GetCurrentPosition() is the rest
+ * @param  None
+ * @retval turns (CCW is + / CW is -)
+ **********************************************************/
+int16_t QuadratureEncoder::GetTurns()
+{
+  int32_t absolute = GetPositionState().absolutePosition;
+  int32_t turns = absolute / (int32_t)pulsesPerRotation;
+  return (int16_t)(absolute < turns * (int32_t)pulsesPerRotation ? turns - 1 : turns);
+}
+
+/******************************************************//**
+ * @brief  Returns the position, absolute position, velocity,
+ * directions and last edge timestamp as the ISRs left them after
+ * one update. With VELOCITY_LSQ the fit runs on a copy of its sums
+ * after the copy is taken, see CopyState.
+ * @param  None
+ * @retval the encoder state
+ **********************************************************/
+encoderSnapshot_t QuadratureEncoder::GetState()
+{
+  velocityWindow_t window;
+  if (!FitsWindow())
+  {
+    return CopyState(NULL);
+  }
+
+  encoderSnapshot_t state = CopyState(&window);
+  FitWindow(state, window);
+  return state;
+}
+
+/******************************************************//**
+ * @brief  Returns GetState() without the VELOCITY_LSQ fit, for
+ * readers of the position only. The velocity is 0 with VELOCITY_LSQ.
+ * @param  None
+ * @retval the encoder state
+ **********************************************************/
+encoderSnapshot_t QuadratureEncoder::GetPositionState()
+{
+  encoderSnapshot_t state = CopyState(NULL);
+
+  if (FitsWindow())
+  {
+    state.velocity = 0;
+  }
+  return state;
+}
+
+/******************************************************//**
+ * @brief  Returns whether the velocity comes from the VELOCITY_LSQ
+ * fit. Hardware counting estimates it with the M/T method whatever
+ * estimator is selected.
+ * @param  None
+ * @retval true if GetState fits the window
+ **********************************************************/
+bool QuadratureEncoder::FitsWindow()
+{
+#ifdef QUADRATURE_TIMER1_COUNTER
+  if (edgeProcessing == EDGE_PROCESS_COUNTER)
+  {
+    return false;
+  }
+#endif
+  return velocityEstimator == VELOCITY_LSQ;
+}
+
+/******************************************************//**
+ * @brief  Copies the state the ISRs left after one update. The
+ * multi-byte fields take several loads on the AVR, so an ISR can
+ * run between them. Each ISR update increments stateSequence when
+ * it is done, and the copy is taken again until the sequence is the
+ * same before and after it. An ISR runs to completion before the
+ * main loop resumes, so an odd in-progress sequence is never seen
+ * and one increment per update is enough. Interrupts stay enabled,
+ * and a retry costs one more copy of a few bytes.
+ * @param  window Receives the least-squares window, NULL to skip it
+ * @retval the encoder state
+ **********************************************************/
+encoderSnapshot_t QuadratureEncoder::CopyState(velocityWindow_t *window)
+{
+  encoderSnapshot_t state;
+  uint8_t sequence;
+#ifdef QUADRATURE_TIMER1_COUNTER
+  int16_t pending = 0;
+#endif
+
+  do
+  {
+    sequence = stateSequence;
+    state.position = position;
+    state.absolutePosition = edgeCount - homeCount;
+    state.direction = directionVector;
+    state.edgeDirection = edgeDirection;
+    state.velocity = (int32_t)speed[0] * state.direction;
+    state.edgeTime = lastPositionTime;
+    if (window)
+    {
+      state.direction = windowDirection;
+      window->fill = windowFill;
+      window->sums[0] = windowSum[0];
+      window->sums[1] = windowSum[1];
+      window->sampleTime = sampleTime;
+    }
+#ifdef QUADRATURE_TIMER1_COUNTER
+    if (edgeProcessing == EDGE_PROCESS_COUNTER)
+    {
+      /* An ISR that reads TCNT1 between the two bytes of this read leaves its own high byte
+       * in TEMP. It either finds no new pulses, so TCNT1 still equals counterLast and the high
+       * byte is the same, or it adds them and changes the sequence. */
+      pending = (int16_t)(uint16_t)(TCNT1 - counterLast) * (int16_t)decodeMode * counterDirection;
+    }
+#endif
+  } while (sequence != stateSequence);
+
+  state.sequence = sequence;
+#ifdef QUADRATURE_TIMER1_COUNTER
+  if (pending != 0)
+  {
+    /* Add the pulses Timer 1 counted since the ISRs last took them */
+    int16_t newPosition = (state.position + pending) % (int16_t)pulsesPerRotation;
+    state.position = newPosition < 0 ? newPosition + (int16_t)pulsesPerRotation : newPosition;
+    state.absolutePosition += pending;
+    state.edgeDirection = pending > 0 ? INCRIMENT_CCW : INCRIMENT_CW;
+  }
+#endif
+  return state;
+}
+
+/******************************************************//**
+ * @brief  Starts the state observer, an alpha-beta-gamma tracking
+ * filter of position, velocity and acceleration run by the step
+ * clock. The three closed loop poles are placed together at
+ * exp(-bandwidth * T) for the update period T, which gives the
+ * fading memory gains alpha = 1 - p^3, beta = 1.5 (1 - p)^2 (1 + p)
+ * and gamma = (1 - p)^3 in the units of one update. Higher bandwidth
+ * follows faster with more count noise in the velocity. Call after
+ * Begin; Begin restarts the observer at the bandwidth it had.
+ * @param  bandwidth Bandwidth in rad/s, 0 stops the observer
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::SetObserverBandwidth(uint16_t bandwidth)
+{
+  float pole = exp(-(float)bandwidth * (float)observerPeriod / (float)timestampsPerSecond);
+  observerGain_t alpha = ObserverGain(1.0f - pole * pole * pole);
+  observerGain_t beta = ObserverGain(1.5f * (1.0f - pole) * (1.0f - pole) * (1.0f + pole));
+  observerGain_t gamma = ObserverGain((1.0f - pole) * (1.0f - pole) * (1.0f - pole));
+
+  noInterrupts();
+  observerBandwidth = 0;
+  observerGain[0] = alpha;
+  observerGain[1] = beta;
+  observerGain[2] = gamma;
+  observerReciprocal = (4096UL << 16) / observerPeriod;
+  observerPosition = (uint32_t)edgeCount << 16;
+  observerVelocity = 0;
+  observerAcceleration = 0;
+  observerEdgeTime = lastPositionTime;
+  observerUpdateTime = lastPositionTime;
+  observerBandwidth = bandwidth;
+  interrupts();
+}
+
+/******************************************************//**
+ * @brief  Returns the state observer bandwidth
+ * @param  None
+ * @retval bandwidth in rad/s, 0 when the observer is stopped
+ **********************************************************/
+uint16_t QuadratureEncoder::GetObserverBandwidth()
+{
+  return observerBandwidth;
+}
+
+/******************************************************//**
+ * @brief  Returns the state observer estimate carried forward from
+ * its last update to now, so it does not lag by up to one update
+ * period. The position follows the home position and the rollover
+ * of GetCurrentPosition, with the fraction of a count the observer
+ * places the disc at.
+ * @param  state Receives the estimate
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::GetObserverState(observerState_t &state)
+{
+  int32_t counts = (int32_t)pulsesPerRotation << 16;
+
+  noInterrupts();
+  unsigned long age = GetTimestamp() - observerUpdateTime;
+  int32_t offset = (int32_t)(observerPosition - ((uint32_t)edgeCount << 16));
+  int32_t estimate = ((int32_t)position << 16) + offset;
+  state.velocity = observerVelocity;
+  state.acceleration = observerAcceleration;
+  interrupts();
+
+  /* Q12 fraction of an update since the last one */
+  age = age < observerPeriod ? age : observerPeriod;
+  int32_t fraction = (int32_t)((age * observerReciprocal) >> 16);
+  estimate += ((state.velocity >> 8) * fraction) >> 4;
+  state.velocity += ((state.acceleration >> 8) * fraction) >> 4;
+
+  estimate %= counts;
+  state.position = estimate < 0 ? estimate + counts : estimate;
+}
+
+/******************************************************//**
+ * @brief  Returns the time between observer updates, the unit of
+ * time of the observer state
+ * @param  None
+ * @retval update period in timestamp clock ticks
+ **********************************************************/
+unsigned long QuadratureEncoder::GetObserverPeriod()
+{
+  return observerPeriod;
+}
+
+/******************************************************//**
+ * @brief  Returns the time between speed samples of the step
+ * clock, the window of pulse counting and of the M/T method
+ * @param  None
+ * @retval sample period in timestamp clock ticks
+ **********************************************************/
+unsigned long QuadratureEncoder::GetSamplePeriod()
+{
+  return samplePeriod;
+}
+
+/******************************************************//**
+ * @brief  Returns the speed above which VELOCITY_IIR counts the
+ * pulses of each sample window instead of timing each pulse. It is
+ * Fast_Calc_Threshold, or Fast_Calc_Window_Counts per window when
+ * the sample rate makes that the higher of the two.
+ * @param  None
+ * @retval Speed in counts per second
+ **********************************************************/
+uint16_t QuadratureEncoder::GetFastCalcThreshold()
+{
+  return fastCalcThreshold;
+}
+
+/******************************************************//**
+ * @brief  Returns the digital pin of the A line
+ * @param  None
+ * @retval pin given to the constructor
+ **********************************************************/
+uint8_t QuadratureEncoder::GetPulsePinA()
+{
+  return pulsePinA;
+}
+
+/******************************************************//**
+ * @brief  Returns the digital pin of the B line
+ * @param  None
+ * @retval pin given to the constructor
+ **********************************************************/
+uint8_t QuadratureEncoder::GetPulsePinB()
+{
+  return pulsePinB;
+}
+
+/******************************************************//**
+ * @brief  Returns whether the lines are decoded through the pin
+ * change interrupt of their port rather than INT0/INT1
+ * @param  None
+ * @retval true unless both lines are on pins 2 and 3
+ **********************************************************/
+bool QuadratureEncoder::UsesPinChangeInterrupt()
+{
+  return pinChange;
+}
+
+/******************************************************//**
+ * @brief  Splits an observer gain below 1 into a Q15 mantissa and
+ * the shift that applies it to a Q8 residual. The small velocity and
+ * acceleration gains keep 15 significant bits this way with a single
+ * 16x16 bit multiply per gain in the ISR. The scaling is done with
+ * ldexp, since 1UL << 40 is undefined for the 32-bit unsigned long of
+ * the AVR, and the exponent stops at Observer_Max_Gain_Exponent so the
+ * ISR shift stays below 32. A gain too small to reach a mantissa of 1
+ * there is clamped to 1, and a gain of 1 or more to 32767, so the loop
+ * never silently loses a gain.
+ * @param  gain Gain between 0 and 1
+ * @retval mantissa and shift
+ **********************************************************/
+observerGain_t QuadratureEncoder::ObserverGain(float gain)
+{
+  observerGain_t result;
+  uint8_t exponent = 0;
+
+  while (exponent < Observer_Max_Gain_Exponent && ldexp(gain, 16 + exponent) < 32767.0f)
+  {
+    exponent++;
+  }
+  float mantissa = ldexp(gain, 15 + exponent) + 0.5f;
+  if (mantissa > 32767.0f)
+  {
+    mantissa = 32767.0f;
+  }
+  else if (mantissa < 1.0f && gain > 0.0f)
+  {
+    mantissa = 1.0f;
+  }
+  result.mantissa = (int16_t)mantissa;
+  result.shift = 7 + exponent;
+  return result;
+}
+
+/******************************************************//**
+ * @brief Initialize Timer 2 of the AtMega328P for asynchronous
+ * operation by following the steps layed out in section 17.9 
+ * (page 126) of the datasheet. It should be noted that Timer 1
+ * is being used by l6474 shield 0, and since we are using only
+ * one shield there should be no conflict.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::InitIsrIntervalForTimer2()
+{
+  /* Disable Timer2 interrupt by setting the special function register
+   * for the Timer/Counter2 Interrupt Enable to 0 with the appropriate mask */
+  _SFR_BYTE(TIMSK2) &= ~(_BV(OCIE2B) | _BV(OCIE2A) | _BV(TOIE2)); // 1111 1000
+
+  /* Skip settiing AS2 clock select. Use Arduino default -> I/O clock. */
+
+  /* Turn on CTC mode so that OCR2A defines the TOP value for TCNT2. Leave OC2A disconnected. */
+  TCCR2A = 0x02; //sets bit WGM21
+
+  /* Set the prescalar mode chosen by SampleTimer and don't force OC2B pin or use waveform generation mode.
+   * As a timestamp clock use clk/8 instead, the step clock then runs on every timestampCycles-th compare match. */
+  if (timestampSource == TIMESTAMP_TIMER2)
+  {
+    timer2Cycles = 0;
+    sampleCycles = 0;
+    TCCR2B = 0x02; //set bit CS21
+  }
+  else
+  {
+    TCCR2B = sampleTimer.clockSelect; //CS22:CS20
+  }
+
+  /* Set the timer TOP value for CTC mode. SampleTimer picks the fastest prescalar for which
+   * F_CPU / (prescalar * desired frequency) - 1 fits the 8-bit timer, so clk/1024 and 255 reach
+   * down to ~61 Hz. As a timestamp clock the timer counts the full 0 to 255. */
+  OCR2A = timestampSource == TIMESTAMP_TIMER2 ? Timer2_Timestamp_Top : sampleTimer.top;
+
+  /* Set the Timer/Counter register to start at 0 */
+  TCNT2 = 0;
+
+  /* Clear the Timer/Counter2 interrupt flags */
+  TIFR2 = 0;
+
+  /* Enable Timer2 Interrupt Mask Register with the appropriate mask for TIMER2_COMPA_vect*/
+  _SFR_BYTE(TIMSK2) |= _BV(OCIE2A);
+}
+
+/******************************************************//**
+ * @brief  Decodes a falling edge of the A line in 1x decoding
+ * @param  lines BA levels read in the ISR
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::DecodePulseA(uint8_t lines)
+{
+  UpdateState(lines);
+
+  /* if both pins A and B are LOW AND the previous state comes from 
+   * the opposite encoder falling edge (to prevent counting when encoder
+   * is at rest on falling edge between states), complete a step */
+  if (!(encoderState & MASK_GET_STATE_0) && (encoderState & MASK_B_TRANSITION_TO_A_COUNT))
+  {
+    /* A CCW count in a fast CW run is B read two edges late */
+    if (edgeDirection == INCRIMENT_CW && InFastRun(GetTimestamp(), lastPositionTime))
+    {
+      CountOverrun(2);
+    }
+    UpdatePosition(INCRIMENT_CCW);
+  }
+  /* Every A edge counts in a fast CCW run, this one or the B edge before it was read late */
+  else if (edgeDirection == INCRIMENT_CCW && InFastRun(GetTimestamp(), lastPositionTime))
+  {
+    CountOverrun(1);
+  }
+  /* A is high again, the falling edge was gone before the ISR read it */
+  else if (lines & 0x01)
+  {
+    CountIllegal(0);
+  }
+}
+
+/******************************************************//**
+ * @brief  Decodes a falling edge of the B line in 1x decoding
+ * @param  lines BA levels read in the ISR
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::DecodePulseB(uint8_t lines)
+{
+  UpdateState(lines);
+
+  /* if both pins A and B are LOW AND the previous state comes from 
+   * the opposite encoder falling edge (to prevent counting when encoder
+   * is at rest on falling edge between states), complete a step */
+  if ((!(encoderState & MASK_GET_STATE_0)) && (encoderState & MASK_A_TRANSITION_TO_B_COUNT))
+  {
+    /* A CW count in a fast CCW run is A read two edges late */
+    if (edgeDirection == INCRIMENT_CCW && InFastRun(GetTimestamp(), lastPositionTime))
+    {
+      CountOverrun(2);
+    }
+    UpdatePosition(INCRIMENT_CW);
+  }
+  /* Every B edge counts in a fast CW run, this one or the A edge before it was read late */
+  else if (edgeDirection == INCRIMENT_CW && InFastRun(GetTimestamp(), lastPositionTime))
+  {
+    CountOverrun(1);
+  }
+  /* B is high again, the falling edge was gone before the ISR read it */
+  else if (lines & 0x02)
+  {
+    CountIllegal(0);
+  }
+}
+
+/******************************************************//**
+ * @brief  Decodes an edge of either line in 4x decoding. The
+ * previous and new BA states index the transition table, so
+ * every edge counts in its direction. A read that took more than
+ * one edge is counted in the diagnostics: both lines changed, a
+ * reversal in a fast run (three edges, counted as one back) or no
+ * change (four edges in a fast run, else a glitch shorter than the
+ * ISR latency). The ISR of the next edge then finds no change. With
+ * the glitch filter on, a read of both lines changed within the
+ * filter time of the last edge ends a glitch on that edge, else it
+ * is held and an edge within the filter time decodes from the state
+ * before it, see SetGlitchFilter().
+ * @param  lines BA levels read in the ISR
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::DecodeChange(uint8_t lines)
+{
+  /* A glitch on one line over an edge of the other: the edge after it is still in the filter time */
+  if (heldState != No_Held_State && lines != (encoderState & MASK_GET_STATE_0))
+  {
+    if (GetTimestamp() - heldTime < glitchFilter)
+    {
+      encoderState = (encoderState & ~MASK_GET_STATE_0) | heldState;
+      CountHeldGlitch();
+    }
+    heldState = No_Held_State;
+  }
+
+  UpdateState(lines);
+  int8_t direction = Decode_4x_Table[encoderState & (MASK_GET_STATE_1 | MASK_GET_STATE_0)];
+  if (direction != 0)
+  {
+    lateRead = direction != edgeDirection && InFastRun(GetTimestamp(), lastPositionTime);
+    if (lateRead)
+    {
+      CountOverrun(4);
+    }
+    UpdatePosition((incrementPosition_t)direction);
+  }
+  else if ((((encoderState >> 2) ^ encoderState) & MASK_GET_STATE_0) == MASK_GET_STATE_0)
+  {
+    /* Within the filter time of the last edge, that edge was a glitch and its return hid behind
+     * an edge of the other line: the return cancels it and the lines decode from the state before */
+    unsigned long now = GetTimestamp();
+    direction = Decode_4x_Table[((encoderState >> 2) & MASK_GET_STATE_1) | (encoderState & MASK_GET_STATE_0)];
+    if (direction != 0 && edgeDirection != 0 && now - lastPositionTime < glitchFilter)
+    {
+      UpdatePosition((incrementPosition_t)-edgeDirection);
+      UpdatePosition((incrementPosition_t)direction);
+      lateRead = false;
+      return;
+    }
+
+    CountIllegal(2);
+    lateRead = true;
+    if (glitchFilter != 0)
+    {
+      heldState = (encoderState >> 2) & MASK_GET_STATE_0;
+      heldTime = now;
+      heldCharge = 2;
+    }
+  }
+  else if (lateRead)
+  {
+    lateRead = false;
+  }
+  else
+  {
+    if (InFastRun(GetTimestamp(), lastPositionTime))
+    {
+      CountOverrun(4);
+    }
+    else
+    {
+      CountIllegal(0);
+    }
+    lateRead = true;
+  }
+}
+
+/******************************************************//**
+ * @brief  The ISR tied to the A pin of the encoder in slot index
+ * used to incriment or decrement the position. One trampoline is
+ * compiled per slot, so the dispatch is a load of the instance from
+ * a fixed address, the same as with a single encoder.
+ * @param  None
+ * @retval None
+ **********************************************************/
+template <uint8_t index>
+void QuadratureEncoder::LeadPulseA()
+{
+  class QuadratureEncoder* instancePtr = instances[index];
+  if (instancePtr)
+  {
+    instancePtr->DecodePulseA(instancePtr->ReadLines());
+  }
+}
+
+/******************************************************//**
+ * @brief  The ISR tied to the B pin of the encoder in slot index
+ * used to incriment or decrement the position.
+ * @param  None
+ * @retval None
+ **********************************************************/
+template <uint8_t index>
+void QuadratureEncoder::LeadPulseB()
+{
+  class QuadratureEncoder* instancePtr = instances[index];
+  if (instancePtr)
+  {
+    instancePtr->DecodePulseB(instancePtr->ReadLines());
+  }
+} 
+
+/******************************************************//**
+ * @brief  The ISR tied to both pins of the encoder in slot index
+ * on CHANGE in 4x decoding
+ * @param  None
+ * @retval None
+ **********************************************************/
+template <uint8_t index>
+void QuadratureEncoder::EdgeChange()
+{
+  class QuadratureEncoder* instancePtr = instances[index];
+  if (instancePtr)
+  {
+    instancePtr->DecodeChange(instancePtr->ReadLines());
+  }
+}
+
+/******************************************************//**
+ * @brief  The ISRs tied to the pins of the encoder in slot index in
+ * deferred processing, on FALLING in 1x decoding and on CHANGE in 4x
+ * @param  None
+ * @retval None
+ **********************************************************/
+template <uint8_t index>
+void QuadratureEncoder::QueueEdgeA()
+{
+  class QuadratureEncoder* instancePtr = instances[index];
+  if (instancePtr)
+  {
+    instancePtr->QueueEdge(instancePtr->ReadLines());
+  }
+}
+
+template <uint8_t index>
+void QuadratureEncoder::QueueEdgeB()
+{
+  class QuadratureEncoder* instancePtr = instances[index];
+  if (instancePtr)
+  {
+    instancePtr->QueueEdge(instancePtr->ReadLines() | Edge_Record_Pin_B);
+  }
+}
+
+#ifdef QUADRATURE_TIMER1_COUNTER
+/******************************************************//**
+ * @brief  The ISR tied to the direction latch of the encoder in
+ * slot index on CHANGE in hardware counting, so it only runs when
+ * the encoder reverses
+ * @param  None
+ * @retval None
+ **********************************************************/
+template <uint8_t index>
+void QuadratureEncoder::DirectionChange()
+{
+  class QuadratureEncoder* instancePtr = instances[index];
+  if (instancePtr)
+  {
+    instancePtr->ReverseCounter();
+  }
+}
+#endif
+
+/* ISR trampolines of each slot, one row per Encoder_Max_Instances */
+static_assert(Encoder_Max_Instances == 2, "Add a row of trampolines to isrTable for each encoder slot");
+const encoderIsrTable_t QuadratureEncoder::isrTable[Encoder_Max_Instances] = {
+#ifdef QUADRATURE_TIMER1_COUNTER
+  {LeadPulseA<0>, LeadPulseB<0>, EdgeChange<0>, QueueEdgeA<0>, QueueEdgeB<0>, DirectionChange<0>},
+  {LeadPulseA<1>, LeadPulseB<1>, EdgeChange<1>, QueueEdgeA<1>, QueueEdgeB<1>, DirectionChange<1>}
+#else
+  {LeadPulseA<0>, LeadPulseB<0>, EdgeChange<0>, QueueEdgeA<0>, QueueEdgeB<0>},
+  {LeadPulseA<1>, LeadPulseB<1>, EdgeChange<1>, QueueEdgeA<1>, QueueEdgeB<1>}
+#endif
+};
+
+/******************************************************//**
+ * @brief  Decodes a pin change interrupt of the port the lines are
+ * on. The port is read once in the ISR and compared with its levels
+ * at the last interrupt, so a change of the other pins on the port
+ * costs a compare. The changed lines then take the same decoding the
+ * INT0/INT1 ISRs do, falling edges only in 1x decoding. Both lines
+ * changing in one interrupt is a missed edge in 4x decoding, as it
+ * is when INT0 and INT1 are late.
+ * @param  levels PINx of the port read in the ISR
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::PinChange(uint8_t levels)
+{
+  uint8_t changed = (levels ^ pinLevels) & (maskA | maskB);
+  if (changed == 0)
+  {
+    return;
+  }
+  pinLevels = levels;
+
+#ifdef QUADRATURE_TIMER1_COUNTER
+  if (edgeProcessing == EDGE_PROCESS_COUNTER)
+  {
+    if (changed & maskB)
+    {
+      ReverseCounter();
+    }
+    return;
+  }
+#endif
+
+  uint8_t lines = ((levels & maskB) ? 0x02 : 0) | ((levels & maskA) ? 0x01 : 0);
+  if (decodeMode == DECODE_1X)
+  {
+    /* 1x only looks at the falling lines, a count lost to both changing shows as an overrun */
+    changed &= ~levels;
+  }
+
+  if (edgeProcessing == EDGE_PROCESS_DEFERRED)
+  {
+    if (changed & maskA)
+    {
+      QueueEdge(lines);
+    }
+    if (changed & maskB)
+    {
+      QueueEdge(lines | Edge_Record_Pin_B);
+    }
+  }
+  else if (decodeMode == DECODE_4X)
+  {
+    DecodeChange(lines);
+  }
+  else
+  {
+    if (changed & maskA)
+    {
+      DecodePulseA(lines);
+    }
+    if (changed & maskB)
+    {
+      DecodePulseB(lines);
+    }
+  }
+}
+
+/******************************************************//**
+ * @brief  Pushes the BA state and the low 16 bits of the timestamp
+ * into the edge ring. Only the ISRs write the head and only
+ * DecodeEdges writes the tail, so the single byte indexes need no
+ * lock. A full ring drops the edge and counts it.
+ * @param  record BA levels read in the ISR, with Edge_Record_Pin_B
+ * set for an edge of pin B
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::QueueEdge(uint8_t record)
+{
+  uint8_t head = edgeHead;
+  uint8_t next = head + 1 < edgeRingSize ? head + 1 : 0;
+  if (next == edgeTail)
+  {
+    droppedEdges++;
+    return;
+  }
+
+  edgeRing[head].state = record;
+  edgeRing[head].time = (uint16_t)GetTimestamp();
+  edgeHead = next;
+}
+
+#ifdef QUADRATURE_TIMER1_COUNTER
+/******************************************************//**
+ * @brief  Adds the pulses Timer 1 counted since the last call to
+ * the position in the latched direction, as one update of the
+ * state. The counter keeps no edge times, so the time of the call
+ * stands in for the last edge. Runs with interrupts disabled, from
+ * the step clock, before each observer update and on reversals,
+ * often enough that far fewer than 8000 pulses wait at a time.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::UpdateCounter()
+{
+  if (edgeProcessing != EDGE_PROCESS_COUNTER)
+  {
+    return;
+  }
+
+  uint16_t count = TCNT1;
+  uint16_t pulses = count - counterLast;
+  if (pulses == 0)
+  {
+    return;
+  }
+  counterLast = count;
+
+  int16_t counts = (int16_t)pulses * (int16_t)decodeMode * counterDirection;
+  int16_t newPosition = (position + counts) % (int16_t)pulsesPerRotation;
+  newPosition += newPosition < 0 ? (int16_t)pulsesPerRotation : 0;
+  position = newPosition;
+  edgeCount += counts;
+  pulsesPerSample += counts;
+  edgeDirection = counterDirection;
+  lastPositionTime = GetTimestamp();
+  stateSequence++;
 }
 
 /******************************************************//**
- * @brief Initialize Timer 2 of the AtMega328P for asynchronous
- * operation by following the steps layed out in section 17.9 
- * (page 126) of the datasheet. It should be noted that Timer 1
- * is being used by l6474 shield 0, and since we are using only
- * one shield there should be no conflict.
+ * @brief  Follows a change of the direction latch. The pulses
+ * before the reversal count in the old direction, and the falling
+ * edge of A that clocked the latch, which Timer 1 has counted
+ * unless it is still in the input synchronizer, counts in the
+ * new one. A latch that changed back before the ISR ran is no
+ * reversal.
  * @param  None
  * @retval None
  **********************************************************/
-void QuadratureEncoder::InitIsrIntervalForTimer2()
+void QuadratureEncoder::ReverseCounter()
 {
-  /* Disable Timer2 interrupt by setting the special function register
-   * for the Timer/Counter2 Interrupt Enable to 0 with the appropriate mask */
-  _SFR_BYTE(TIMSK2) &= ~(_BV(OCIE2B) | _BV(OCIE2A) | _BV(TOIE2)); // 1111 1000
-
-  /* Skip settiing AS2 clock select. Use Arduino default -> I/O clock. */
-
-  /* Turn on CTC mode so that OCR2A defines the TOP value for TCNT2. Leave OC2A disconnected. */
-  TCCR2A = 0x02; //sets bit WGM21
-
-  /* Set the prescalar mode to use clk/1024 and don't force OC2B pin or use waveform generation mode. */
-  TCCR2B = 0x07; //set bits CS22, CS21, and CS20
-
-  /* Set the timer TOP value for CTC mode based on the prescalar used. Using an 8-bit timer, the prescalar
-   * and desired frequency must adhere to this rule: (F_CPU / (prescalar * desired frequency)) - 1 < 255.
-   * Solving for 254, the slowest frequency we can achieve is ~61.52 Hz or a poling rate of ~16 ms*/
-  OCR2A = 0xFF;
-
-  /* Set the Timer/Counter register to start at 0 */
-  TCNT2 = 0;
-
-  /* Clear the Timer/Counter2 interrupt flags */
-  TIFR2 = 0;
+  int8_t direction = (*pinInput & maskB) ? INCRIMENT_CW : INCRIMENT_CCW;
+  if (direction == counterDirection)
+  {
+    return;
+  }
 
-  /* Enable Timer2 Interrupt Mask Register with the appropriate mask for TIMER2_COMPA_vect*/
-  _SFR_BYTE(TIMSK2) |= _BV(OCIE2A);
+  /* Hold the reversing pulse back while the others are added */
+  if ((uint16_t)(TCNT1 - counterLast) != 0)
+  {
+    counterLast++;
+    UpdateCounter();
+    counterLast--;
+  }
+  counterDirection = direction;
+  UpdateCounter();
 }
+#endif
 
 /******************************************************//**
- * @brief  The ISR tied to the Quadrature_Pulse_A_Pin 
- * encoder pin used to incriment or decrement the position.
+ * @brief  Attaches the pin change ISRs of the decode mode and the
+ * edge processing, the trampolines of the slot of the encoder on
+ * INT0/INT1 or the port handler through PCINTn. Every 4x transition
+ * is decoded from the previous state, so the state history starts
+ * from the lines as they are. In hardware counting Timer 1 takes the
+ * edges of A and only the direction latch on B interrupts.
  * @param  None
  * @retval None
  **********************************************************/
-void QuadratureEncoder::LeadPulseA()
+void QuadratureEncoder::AttachEdgeInterrupts()
 {
-  class QuadratureEncoder* instancePtr = QuadratureEncoder::GetInstancePtr();
-  if (instancePtr)
+  if (instanceIndex >= Encoder_Max_Instances)
   {
-    instancePtr->UpdateState();
-    uint8_t state = instancePtr->GetEncoderState();
+    return;
+  }
+
+  const encoderIsrTable_t &isr = isrTable[instanceIndex];
+  int mode = decodeMode == DECODE_4X ? CHANGE : FALLING;
+  if (decodeMode == DECODE_4X)
+  {
+    UpdateState(ReadLines());
+  }
 
-    /* if both pins A and B are LOW AND the previous state comes from 
-     * the opposite encoder falling edge (to prevent counting when encoder
-     * is at rest on falling edge between states), complete a step */
-    if (!(state & MASK_GET_STATE_0) && (state & MASK_B_TRANSITION_TO_A_COUNT))
+#ifdef QUADRATURE_TIMER1_COUNTER
+  if (edgeProcessing == EDGE_PROCESS_COUNTER)
+  {
+    /* Timer 1 in normal mode clocked by the falling edges on T1, with its interrupts off */
+    pinMode(Quadrature_Counter_Pin, INPUT_PULLUP);
+    TIMSK1 = 0;
+    TCCR1A = 0;
+    TCCR1B = _BV(CS12) | _BV(CS11);
+    counterLast = TCNT1;
+    counterDirection = (*pinInput & maskB) ? INCRIMENT_CW : INCRIMENT_CCW;
+    if (!pinChange)
     {
-      instancePtr->UpdatePosition(INCRIMENT_CCW);
+      detachInterrupt(digitalPinToInterrupt(pulsePinA));
+      attachInterrupt(digitalPinToInterrupt(pulsePinB), isr.directionChange, CHANGE);
+      return;
     }
   }
+#endif
+
+  if (pinChange)
+  {
+    AttachPinChange();
+  }
+  else if (edgeProcessing == EDGE_PROCESS_DEFERRED)
+  {
+    attachInterrupt(digitalPinToInterrupt(pulsePinA), isr.queueEdgeA, mode);
+    attachInterrupt(digitalPinToInterrupt(pulsePinB), isr.queueEdgeB, mode);
+  }
+  else if (decodeMode == DECODE_4X)
+  {
+    attachInterrupt(digitalPinToInterrupt(pulsePinA), isr.edgeChange, mode);
+    attachInterrupt(digitalPinToInterrupt(pulsePinB), isr.edgeChange, mode);
+  }
+  else
+  {
+    attachInterrupt(digitalPinToInterrupt(pulsePinA), isr.leadPulseA, mode);
+    attachInterrupt(digitalPinToInterrupt(pulsePinB), isr.leadPulseB, mode);
+  }
 }
 
 /******************************************************//**
- * @brief  The ISR tied to the Quadrature_Pulse_B_Pin 
- * encoder pin used to incriment or decrement the position.
+ * @brief  Unmasks the lines in the PCMSKn register of their port
+ * and enables its pin change interrupt. The ISR of the port hands
+ * every change to IsrPinChangeHandler, which PinChange decodes for
+ * the lines of this encoder. In hardware counting only the
+ * direction latch on B is unmasked. A port whose ISR is not built,
+ * see QUADRATURE_PCINT_PORT_C, stays disabled and the encoder gets
+ * no interrupts, since a vector without an ISR resets the AVR.
  * @param  None
  * @retval None
  **********************************************************/
-void QuadratureEncoder::LeadPulseB()
+void QuadratureEncoder::AttachPinChange()
 {
-  class QuadratureEncoder* instancePtr = QuadratureEncoder::GetInstancePtr();
-  if (instancePtr)
+  if (!(Quadrature_Pin_Change_Ports & _BV(pinChangePort)))
   {
-    instancePtr->UpdateState();
-    uint8_t state = instancePtr->GetEncoderState();
+    return;
+  }
 
-    /* if both pins A and B are LOW AND the previous state comes from 
-     * the opposite encoder falling edge (to prevent counting when encoder
-     * is at rest on falling edge between states), complete a step */
-    if ((!(state & MASK_GET_STATE_0)) && (state & MASK_A_TRANSITION_TO_B_COUNT))
-    {
-        instancePtr->UpdatePosition(INCRIMENT_CW);
-    }
+  uint8_t bitA = _BV(digitalPinToPCMSKbit(pulsePinA));
+  uint8_t bitB = _BV(digitalPinToPCMSKbit(pulsePinB));
+  volatile uint8_t *pcmsk = digitalPinToPCMSK(pulsePinA);
+  uint8_t unmasked = bitA | bitB;
+#ifdef QUADRATURE_TIMER1_COUNTER
+  if (edgeProcessing == EDGE_PROCESS_COUNTER)
+  {
+    unmasked = bitB;
   }
-} 
+#endif
+
+  /* A change after the flag is cleared either sets it again or is already in the levels */
+  *pcmsk = (*pcmsk & ~(bitA | bitB)) | unmasked;
+  PCIFR = _BV(pinChangePort);
+  pinLevels = *pinInput;
+  PCICR |= _BV(pinChangePort);
+}
 
 /******************************************************//**
  * @brief  Incriment the position of the encoder by one pulse
@@ -206,40 +1658,64 @@ void QuadratureEncoder::LeadPulseB()
  **********************************************************/
 void QuadratureEncoder::UpdatePosition(incrementPosition_t direction)
 {
+  unsigned long now = GetTimestamp();
+  unsigned long interval = now - lastPositionTime;
+  if (interval < minEdgeInterval)
+  {
+    minEdgeInterval = interval;
+  }
+  fastEdges = (interval < overrunInterval && direction == edgeDirection) ? fastEdges + (fastEdges < 255) : 0;
+
   /* update the position based on the most recent pulse direction 
    * and account for rollover of the number of pulses from the home
-   * position of 0 to ppr - 1 */
+   * position of 0 to ppr - 1. The comparisons are 0 or 1 and negate
+   * into all-clear or all-set masks of ppr, so the rollover takes no
+   * branches. The accumulated count keeps the turns. */
   int16_t newPosition = position + direction;
-  if (newPosition < 0)
-  {
-    position = pulsesPerRotation - 1;
-  }
-  else if (newPosition >= pulsesPerRotation)
-  {
-    position = 0;
-  }
-  else
+  newPosition += (int16_t)pulsesPerRotation & -(int16_t)(newPosition < 0);
+  newPosition -= (int16_t)pulsesPerRotation & -(int16_t)(newPosition >= (int16_t)pulsesPerRotation);
+  position = newPosition;
+  edgeCount += direction;
+
+  /* The second edge of a glitch pair cancels the count of the first, and the timing
+   * goes back to the edge before the pair. glitchFilter is 0 when the filter is off. */
+  if (interval < glitchFilter && direction != edgeDirection)
   {
-    position = newPosition;
+    if (velocityEstimator == VELOCITY_MT || (velocityEstimator == VELOCITY_IIR && doFastPulseCalc))
+    {
+      pulsesPerSample += direction;
+    }
+    glitches++;
+    edgeDirection = priorDirection;
+    lastPositionTime = priorPositionTime;
+    stateSequence++;
+    return;
   }
 
-  /* If pulse rate is below 125 pps, calculate the speed based on the time between pulses
+  /* If pulse rate is below fastCalcThreshold, calculate the speed based on the time between pulses
    * as counting the pulses in a fixed period becomes less accurate as slower speeds. See
-   * CheckFastCalcStatus comment for more detail */
-  if (!doFastPulseCalc)
+   * CheckFastCalcStatus comment for more detail. The M/T method only counts here. */
+  if (velocityEstimator == VELOCITY_IIR && !doFastPulseCalc)
   {
     UpdateDirection(direction);
 
-    /* since only 1 pulse is counted, accounting for the computation time of the LPF which aids 
-     * in accuracy of the speed calculation*/
-    lastPositionTime = micros() - UpdateSpeed(1L, micros() - lastPositionTime);
-    
+    /* the edge is timestamped once before the LPF runs, so its computation time does not
+     * end up in the next period */
+    UpdateSpeed(1L, now - lastPositionTime);
+  }
+  else if (velocityEstimator == VELOCITY_LSQ)
+  {
+    UpdateWindow(direction, now);
   }
   else
   {
     pulsesPerSample += direction;
-    lastPositionTime = micros();
   }
+  priorDirection = edgeDirection;
+  priorPositionTime = lastPositionTime;
+  edgeDirection = direction;
+  lastPositionTime = now;
+  stateSequence++;
 }
 
 /******************************************************//**
@@ -255,64 +1731,181 @@ void QuadratureEncoder::UpdateDirection(int8_t newDirection)
   directionVector = newDirection;
 }
 
+/******************************************************//**
+ * @brief  Counts an edge the decoder could not count
+ * @param  missedCounts Counts the edge is suspected to have lost
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::CountIllegal(uint8_t missedCounts)
+{
+  illegalTransitions++;
+  suspectedMissedCounts += missedCounts;
+}
+
+/******************************************************//**
+ * @brief  Moves a held read that the glitch filter found to be a
+ * glitch from the illegal transitions to the glitches. Only what
+ * was charged since the last ResetDiagnostics() is taken back.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::CountHeldGlitch()
+{
+  if (heldCharge != 0)
+  {
+    if (illegalTransitions != 0)
+    {
+      illegalTransitions--;
+    }
+    suspectedMissedCounts -= suspectedMissedCounts < heldCharge ? suspectedMissedCounts : heldCharge;
+    heldCharge = 0;
+  }
+  glitches++;
+}
+
+/******************************************************//**
+ * @brief  Counts an edge read too late in a fast run
+ * @param  missedCounts Counts the late read is suspected to have lost
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::CountOverrun(uint8_t missedCounts)
+{
+  overruns++;
+  suspectedMissedCounts += missedCounts;
+}
+
+/******************************************************//**
+ * @brief  Checks if the encoder is in a run of edges close enough
+ * to come before their ISRs run. The run ends once its edges stop
+ * for Overrun_Run_Edges + 1 of its intervals.
+ * @param  now Timestamp of the read
+ * @param  lastEdge Timestamp of the last counted edge
+ * @retval true if a read that loses counts now is an overrun
+ **********************************************************/
+bool QuadratureEncoder::InFastRun(unsigned long now, unsigned long lastEdge)
+{
+  return fastEdges >= Overrun_Run_Edges && now - lastEdge < overrunInterval * (Overrun_Run_Edges + 1);
+}
+
+/******************************************************//**
+ * @brief  Reads both lines from one read of their PINx register
+ * @param  None
+ * @retval BA levels, B in bit 1 and A in bit 0
+ **********************************************************/
+uint8_t QuadratureEncoder::ReadLines()
+{
+  uint8_t levels = *pinInput;
+  return ((levels & maskB) ? 0x02 : 0) | ((levels & maskA) ? 0x01 : 0);
+}
+
 /******************************************************//**
  * @brief  Updates the encoder state and stores the value in a bit
  * shifted, 8-bit value. Each state occupies 2 bits in the order
  * [n-3][n-2][n-1][n] with the [n-3] pair containing the MSB. The
  * bit pairs are stored as signal BA where B leads A.
- * @param  None
+ * @param  lines BA levels read in the ISR, see ReadLines
  * @retval None
  **********************************************************/
-void QuadratureEncoder::UpdateState()
+void QuadratureEncoder::UpdateState(uint8_t lines)
 {
   encoderState <<= 2;
-  encoderState |= ((digitalRead(Quadrature_Pulse_B_Pin) << 1) | digitalRead(Quadrature_Pulse_A_Pin));
+  encoderState |= lines;
+}
+
+/******************************************************//**
+ * @brief  Gets the pointer to a Quadrature instance
+ * @param  index Slot of the instance, 0 for the first one constructed
+ * @retval Pointer to the instance of Quadrature, NULL if the slot is empty
+ **********************************************************/
+class QuadratureEncoder* QuadratureEncoder::GetInstancePtr(uint8_t index)
+{
+  return index < Encoder_Max_Instances ? instances[index] : NULL;
 }
 
 /******************************************************//**
- * @brief  Gets the pointer to the Quadrature instance
+ * @brief  Runs the step clock of every begun encoder on a Timer 2
+ * compare match. The compare matches are counted once here for the
+ * Timer 2 timestamps all encoders share.
  * @param  None
- * @retval Pointer to the instance of Quadrature
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::IsrTimer2Handler()
+{
+  timer2Cycles++;
+  for (uint8_t i = 0; i < Encoder_Max_Instances; i++)
+  {
+    class QuadratureEncoder* instancePtr = instances[i];
+    if (instancePtr && instancePtr->pulsesPerRotation != 0)
+    {
+      instancePtr->IsrStepClockHandler();
+    }
+  }
+}
+
+/******************************************************//**
+ * @brief  Hands a pin change interrupt to the encoders on the
+ * port. The dispatch is a fixed loop over the slots, about 10
+ * cycles per slot on top of the interrupt entry, whether or not
+ * the encoder in it has a line that changed.
+ * @param  port PCICR bit of the port, the n of PCINTn_vect
+ * @param  levels PINx of the port, read first thing in the ISR
+ * @retval None
  **********************************************************/
-class QuadratureEncoder* QuadratureEncoder::GetInstancePtr(void)
+void QuadratureEncoder::IsrPinChangeHandler(uint8_t port, uint8_t levels)
 {
-  return (class QuadratureEncoder*)instancePtr;
+  for (uint8_t i = 0; i < Encoder_Max_Instances; i++)
+  {
+    class QuadratureEncoder* instancePtr = instances[i];
+    if (instancePtr && instancePtr->pinChange && instancePtr->pinChangePort == port)
+    {
+      instancePtr->PinChange(levels);
+    }
+  }
 }
 
 /******************************************************//**
  * @brief Checks and updates the flag which determines whether or not 
  * to use pulse counting or pulse timing to determine the rate of rotation.
  * Pulse counting is used for speeds exceeding 125pps and pulse timing is
- * used for speeds lower or equal to 125pps. This was based on the ISR clock
- * period of 16.25ms. If the pulse timing, which has a period of ~50us when
+ * used for speeds lower or equal to 125pps. This was based on the default
+ * ISR clock period of ~16.4ms. If the pulse timing, which has a period of ~50us when
  * including filter calculations, exceeds 40% of the ISR clock period.
- * So, 16.25ms * 40% = 6.5ms. 6.5ms / 50us = 130 pulses.
+ * So, 16.4ms * 40% = 6.5ms. 6.5ms / 50us = 130 pulses. Faster sample rates
+ * leave too few counts in a window, so Begin raises the threshold to
+ * Fast_Calc_Window_Counts per window: 244pps at 61Hz, 4000pps or 20% of
+ * the CPU at 1kHz.
  * @param  None
  * @retval None
   **********************************************************/
 void QuadratureEncoder::CheckFastCalcStatus()
 {
-  doFastPulseCalc = speed[0] > Fast_Calc_Threshold;
+  doFastPulseCalc = speed[0] > fastCalcThreshold;
 }
 
 /******************************************************//**
  * @brief Calculates the current rotational speed of the device
- * in pulses per second (pps) using a range of samples over a microsecond
- * sampling period. The output of this calculation is smoothed with
- * a low pass filter to reduce jitter between pulses.
+ * in counts per second using a range of samples over a sampling
+ * period in timestamp clock ticks. The output of this calculation is
+ * smoothed with a low pass filter to reduce jitter between pulses.
  * @param samples The number of samples, or pulses, in the sample period.
- * @param periodMicros The sample period in microseconds.
- * @retval The total computation time of the method in microseconds (us).
+ * @param period The sample period in timestamp clock ticks.
+ * @retval None
   **********************************************************/
-unsigned long QuadratureEncoder::UpdateSpeed(uint32_t samples, unsigned long periodMicros)
+void QuadratureEncoder::UpdateSpeed(uint32_t samples, unsigned long period)
 {
-  unsigned long startComputationTime = micros();
-
-  /* Using a sample period of microseconds for relatively slow pulse speed, the resolution
-   * remains high enough to use integer math instead of floating point operations to reduce
-   * calculation time. Since speed is measured pps, it is necessary to scale the number of
-   * samples in the same way we scale microseconds to get an integer. So samples * 1^6. */
-  uint16_t speedSample = 1000000L * samples / periodMicros;
+  /* Using a sample period of microseconds (or half microseconds) for relatively slow pulse speed, the
+   * resolution remains high enough to use integer math instead of floating point operations to reduce
+   * calculation time. Since speed is measured pps, it is necessary to scale the number of samples in
+   * the same way we scale the period to get an integer. So samples * the timestamp clock rate.
+   * Two pulses can land inside the same timestamp tick, so never divide by a zero period.
+   * 4x decoding passes 65535 counts/s near 16k pps, so the sample saturates like UpdateSpeedMT
+   * and the filter runs in 32 bits, where 3 * 65535 does not wrap the 16-bit int of the AVR. */
+  if (period == 0)
+  {
+    period = 1;
+  }
+  unsigned long speedSample = timestampsPerSecond * samples / period;
+  speedSample = speedSample > UINT16_MAX ? UINT16_MAX : speedSample;
   speed[1] = speed[0];
 
   /* The formula used for the filter is basic a formula for a discrete Infinite Impulse Response (IIR)
@@ -322,19 +1915,212 @@ unsigned long QuadratureEncoder::UpdateSpeed(uint32_t samples, unsigned long per
    * This reduced computation time from ~82us to ~48us from the floating point solution */
   if (!reverseLpfBias)
   {
-    speed[0] = (3 * speedSample + 5 * speed[1]) / 8;
+    speed[0] = (3 * speedSample + 5 * (unsigned long)speed[1]) / 8;
   }
   /* On direction changes, reverse the LPF bias to favor the new sample so the speed change is more accurate @ B=3/4 */
   else
   {
-    speed[0] = (3 * speedSample + speed[1]) / 4;
+    speed[0] = (3 * speedSample + (unsigned long)speed[1]) / 4;
   }
 
   /* Note: Tried a slightly improved low pass that averages the last two inputs instead of using only
    * the current input: y[i]=B(x[i]+x[i−1])/2 + (1−B)y[i−1], but this proved to smooth the results
    * more than desired, even when adjusting B to weight the samples more. */
+}
+
+/******************************************************//**
+ * @brief  M/T method speed estimate, run by the step clock at the
+ * end of each sample window. The pulses counted in the window are
+ * divided by the time from the last edge of the previous window to
+ * the last edge of this one, so the period is measured edge to edge
+ * at any speed and no filter or threshold is needed. A window with
+ * no edge bounds the speed to one pulse over the time since the
+ * last edge, which brings it to zero once the encoder stops.
+ * DecodeEdges() runs the same estimate over each batch of edges.
+ * @param  pulses Net pulses counted in the window
+ * @param  edgeTime Timestamp of the last edge counted
+ * @param  now Timestamp of the end of the window
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::UpdateSpeedMT(int32_t pulses, unsigned long edgeTime, unsigned long now)
+{
+  unsigned long speedSample;
+  speed[1] = speed[0];
+
+  if (edgeTime != windowEdgeTime)
+  {
+    /* Edges in this window: M pulses over the time T between the last edges of the windows.
+     * A window that comes back to where it started has no net speed. */
+    unsigned long period = edgeTime - windowEdgeTime;
+    windowEdgeTime = edgeTime;
+    if (pulses != 0)
+    {
+      UpdateDirection(pulses > 0 ? 1 : -1);
+    }
+    speedSample = timestampsPerSecond * (uint32_t)abs(pulses) / period;
+  }
+  else
+  {
+    /* No edge: the next one is at least the time since the last edge away */
+    unsigned long sinceEdge = now - edgeTime;
+    unsigned long bound = timestampsPerSecond / (sinceEdge != 0 ? sinceEdge : 1);
+    speedSample = bound < speed[0] ? bound : speed[0];
+  }
+
+  speed[0] = speedSample > UINT16_MAX ? UINT16_MAX : speedSample;
+}
+
+/******************************************************//**
+ * @brief  Adds an edge to the least-squares window. The edges of a
+ * window all count the same way, so edge i of the window sits i
+ * counts from the oldest and only the timestamps t need keeping.
+ * The running sums of t and i*t take a few additions per edge:
+ * dropping the oldest edge moves the others down one place, which
+ * takes the sum of t from the sum of i*t. A direction change starts
+ * a new window. The sums wrap at 32 bits with the timestamps, which the
+ * fit cancels.
+ * @param  direction Direction of the edge
+ * @param  now Timestamp of the edge
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::UpdateWindow(int8_t direction, unsigned long now)
+{
+  uint8_t last = windowSize - 1;
+  if (direction != windowDirection)
+  {
+    windowDirection = direction;
+    windowFill = 0;
+    windowIndex = 0;
+    windowSum[0] = 0;
+    windowSum[1] = 0;
+  }
+
+  if (windowFill <= last)
+  {
+    uint8_t i = windowFill;
+    windowSum[0] += now;
+    windowSum[1] += (uint32_t)i * now;
+    windowFill = i + 1;
+  }
+  else
+  {
+    uint32_t rest = windowSum[0] - windowTime[windowIndex];
+    windowSum[1] += (uint32_t)last * now - rest;
+    windowSum[0] = rest + now;
+  }
+  windowTime[windowIndex] = now;
+  windowIndex = windowIndex < last ? windowIndex + 1 : 0;
+}
+
+/******************************************************//**
+ * @brief  Fits t(i) = t0 + b (i - m) to the window by least
+ * squares, with m the middle of the window. b is the edge period
+ * at the middle of the window and the velocity is its inverse. The
+ * slope sum weighs the timestamps by terms that add up to zero, so
+ * the wrapped running sums give it exactly. Once the last step
+ * clock sample is over twice the fitted period past the last edge,
+ * the velocity is one count over that time, as with the M/T method,
+ * so it falls to zero when the encoder stops without waiting on
+ * edges that do not come.
+ * @param  state Snapshot to fill, with the window direction
+ * @param  window Copy of the window taken with the snapshot
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::FitWindow(encoderSnapshot_t &state, const velocityWindow_t &window)
+{
+  uint32_t n = window.fill;
+  state.velocity = 0;
+  if (window.fill < 2)
+  {
+    return;
+  }
+
+  /* 2 sum (i - m) t = b n (n^2 - 1) / 6 */
+  uint32_t periodScale = n * (n * n - 1) / 6;
+  int32_t periodSum = (int32_t)(2 * window.sums[1] - (n - 1) * window.sums[0]);
+  if (periodSum <= 0)
+  {
+    return;
+  }
+  uint32_t speedSample = timestampsPerSecond * periodScale / (uint32_t)periodSum;
+
+  /* The sample can be older than the last edge */
+  long sinceEdge = (long)(window.sampleTime - state.edgeTime);
+  if (sinceEdge > 0)
+  {
+    unsigned long bound = timestampsPerSecond / (unsigned long)sinceEdge;
+    speedSample = bound < speedSample / 2 ? bound : speedSample;
+  }
+  speedSample = speedSample > UINT16_MAX ? UINT16_MAX : speedSample;
+  state.velocity = (int32_t)speedSample * state.direction;
+}
+
+/******************************************************//**
+ * @brief  One state observer update, run by the step clock. The
+ * state is predicted one update ahead and corrected by a residual
+ * in Q8 counts. After an edge the disc was on the boundary into the
+ * current count at the edge timestamp, so the residual compares that
+ * boundary with the prediction taken back to the edge time, and the
+ * count quantization does not reach the velocity. Without an edge the
+ * disc is still within half a count of the current count, and only
+ * a prediction past that band is pulled back, which slows the
+ * estimate down when the encoder stops.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void QuadratureEncoder::UpdateObserver()
+{
+  unsigned long now = GetTimestamp();
+  uint32_t measured = (uint32_t)edgeCount << 16;
+  int32_t residual;
+  observerUpdateTime = now;
+
+  observerPosition += observerVelocity + (observerAcceleration >> 1);
+  observerVelocity += observerAcceleration;
+
+  if (lastPositionTime != observerEdgeTime)
+  {
+    /* Take the prediction back by the edge age, a Q12 fraction of an update. The
+     * acceleration term is below a count at any speed the decoder follows. */
+    unsigned long age = now - lastPositionTime;
+    age = age < observerPeriod ? age : observerPeriod;
+    observerEdgeTime = lastPositionTime;
+    int32_t fraction = (int32_t)((age * observerReciprocal) >> 16);
+    int32_t back = ((observerVelocity >> 8) * fraction) >> 4;
+    uint32_t boundary = measured - ((int32_t)edgeDirection * Observer_Half_Count);
+    residual = (int32_t)(boundary - (observerPosition - back));
+  }
+  else
+  {
+    residual = (int32_t)(measured - observerPosition);
+    if (residual > Observer_Half_Count)
+    {
+      residual -= Observer_Half_Count;
+    }
+    else if (residual < -Observer_Half_Count)
+    {
+      residual += Observer_Half_Count;
+    }
+    else
+    {
+      residual = 0;
+    }
+  }
+
+  /* Saturate what one update corrects to the range of the Q8 residual */
+  if (residual > Observer_Max_Residual)
+  {
+    residual = Observer_Max_Residual;
+  }
+  else if (residual < -Observer_Max_Residual)
+  {
+    residual = -Observer_Max_Residual;
+  }
 
-   return micros() - startComputationTime;
+  int16_t correction = (int16_t)(residual >> 8);
+  observerPosition += ((int32_t)correction * observerGain[0].mantissa) >> observerGain[0].shift;
+  observerVelocity += ((int32_t)correction * observerGain[1].mantissa) >> observerGain[1].shift;
+  observerAcceleration += ((int32_t)correction * observerGain[2].mantissa) >> observerGain[2].shift;
 }
 
 /******************************************************//**
@@ -343,15 +2129,19 @@ unsigned long QuadratureEncoder::UpdateSpeed(uint32_t samples, unsigned long per
  * moving and sets the current speed to zero. The timeout period
  * threshold scales to the next longest smaple period assuming
  * negative acceleration. This gives ample time for the pendulum
- * to move before a timeout would occur unexpectedly.
+ * to move before a timeout would occur unexpectedly. Fast sample
+ * rates check many times per pulse and time pulses up to thousands
+ * of pps, where one pps is no margin, so the threshold is stretched
+ * to Speed_Timeout_Eighths eighths of the pulse period.
  * @param  None
  * @retval None
  **********************************************************/
 void QuadratureEncoder::CheckSpeedTimeout()
 {
-  unsigned long timeoutThreshold = speed[0] > 1 ? 1000000L / (speed[0] - 1) : 1000000L;
+  unsigned long timeoutThreshold = speed[0] > 1 ? timestampsPerSecond / (speed[0] - 1) : timestampsPerSecond;
+  timeoutThreshold = timeoutThreshold / 8 * Speed_Timeout_Eighths;
 
-  if (micros() - lastPositionTime > timeoutThreshold)
+  if (GetTimestamp() - lastPositionTime > timeoutThreshold)
   {
     speed[1] = speed[0];
     speed[0] = 0;
@@ -360,21 +2150,83 @@ void QuadratureEncoder::CheckSpeedTimeout()
 
 /******************************************************//**
  * @brief  The ISR handling function. When the pulse rate exceeds
- * the Fast_Calc_Threshold in pps, this method is used to calculate
+ * the fastCalcThreshold in pps, this method is used to calculate
  * the rotational velocity of the quadrature. The sample rate is
  * set in InitIsrIntervalForTimer2. This handler also periodically
  * checks the timeout for setting the velocity to zero if the velocity
- * is below the Fast_Calc_Threshold. It also controls switching between
+ * is below the fastCalcThreshold. It also controls switching between
  * pulse counting and pulse timing to determine the current speed.
  * @param  None
  * @retval None
  **********************************************************/
 void QuadratureEncoder::IsrStepClockHandler()
 {
+    /* As a timestamp clock Timer 2 runs faster than the sample rate, count the
+     * compare matches and only sample on every timestampCycles-th */
+    if (timestampSource == TIMESTAMP_TIMER2)
+    {
+      if (observerBandwidth != 0 && !((uint8_t)timer2Cycles & (Observer_Timer2_Cycles - 1)))
+      {
+#ifdef QUADRATURE_TIMER1_COUNTER
+        UpdateCounter();
+#endif
+        UpdateObserver();
+      }
+      if (++sampleCycles < sampleTimer.timestampCycles)
+      {
+        return;
+      }
+      sampleCycles = 0;
+    }
+    else if (observerBandwidth != 0)
+    {
+#ifdef QUADRATURE_TIMER1_COUNTER
+      UpdateCounter();
+#endif
+      UpdateObserver();
+    }
+
+#ifdef QUADRATURE_TIMER1_COUNTER
+    /* Timer 1 keeps no edge times, the M/T method runs over the pulses of each sample */
+    if (edgeProcessing == EDGE_PROCESS_COUNTER)
+    {
+      UpdateCounter();
+      UpdateSpeedMT(pulsesPerSample, lastPositionTime, GetTimestamp());
+      pulsesPerSample = 0;
+      stateSequence++;
+      return;
+    }
+#endif
+
+    /* The least-squares fit runs when the velocity is read, the sample time stops it */
+    if (velocityEstimator == VELOCITY_LSQ)
+    {
+      sampleTime = GetTimestamp();
+      stateSequence++;
+      return;
+    }
+
+    /* Deferred edges get their speed from DecodeEdges */
+    if (edgeProcessing == EDGE_PROCESS_DEFERRED)
+    {
+      return;
+    }
+
+    if (velocityEstimator == VELOCITY_MT)
+    {
+      UpdateSpeedMT(pulsesPerSample, lastPositionTime, GetTimestamp());
+      pulsesPerSample = 0;
+      stateSequence++;
+      return;
+    }
+
     if (doFastPulseCalc)
     {
-      UpdateDirection(pulsesPerSample > 0 ? 1 : -1);
-      UpdateSpeed((uint32_t) abs(pulsesPerSample), Isr_Sample_Period_Us); // 16255us is the timer frequency set for TIMER2_COMPA_vect in InitIsrIntervalForTimer2
+      if (pulsesPerSample != 0)
+      {
+        UpdateDirection(pulsesPerSample > 0 ? 1 : -1);
+      }
+      UpdateSpeed((uint32_t) abs(pulsesPerSample), samplePeriod); // sampleTimer.periodUs or timestampCycles Timer 2 cycles, the period of the step clock set in InitIsrIntervalForTimer2
     }
     else
     {
@@ -383,6 +2235,7 @@ void QuadratureEncoder::IsrStepClockHandler()
 
     pulsesPerSample = 0;
     CheckFastCalcStatus();
+    stateSequence++;
 }
 
 /******************************************************//**
@@ -396,6 +2249,51 @@ uint8_t QuadratureEncoder::GetEncoderState()
   return encoderState;
 }
 
+/******************************************************//**
+ * @brief  Returns the timestamp clock the edges are timed with.
+ * With Timer 2 the counter is extended by the compare match count,
+ * and a compare match still waiting for its interrupt is counted,
+ * so the clock never steps back. Must be called with interrupts
+ * disabled, as it is in the ISRs.
+ * @param  None
+ * @retval timestamp in ticks of GetTimestampsPerSecond()
+ **********************************************************/
+unsigned long QuadratureEncoder::GetTimestamp()
+{
+  if (timestampSource != TIMESTAMP_TIMER2)
+  {
+    return micros();
+  }
+
+  uint8_t count = TCNT2;
+  uint32_t cycles = timer2Cycles;
+  if ((TIFR2 & _BV(OCF2A)) && count < Timer2_Timestamp_Top)
+  {
+    cycles++;
+  }
+  return (cycles << 8) | count;
+}
+
+/******************************************************//**
+ * @brief  Returns the rate of the timestamp clock
+ * @param  None
+ * @retval timestamp clock ticks per second
+ **********************************************************/
+unsigned long QuadratureEncoder::GetTimestampsPerSecond()
+{
+  return timestampsPerSecond;
+}
+
+/******************************************************//**
+ * @brief  Returns the clock the edges are timestamped with
+ * @param  None
+ * @retval timestamp source given to Begin
+ **********************************************************/
+timestampSource_t QuadratureEncoder::GetTimestampSource()
+{
+  return timestampSource;
+}
+
 /******************************************************//**
  * @brief  The Interrupt Service Routine (ISR) which occurs periodically
  * based on the configuration of Timer 2 of the AtMega328P if the
@@ -408,10 +2306,35 @@ uint8_t QuadratureEncoder::GetEncoderState()
  **********************************************************/
 ISR(TIMER2_COMPA_vect)
 {
-  class QuadratureEncoder* instancePtr = QuadratureEncoder::GetInstancePtr();
-  if (instancePtr)
-  {
-    instancePtr->IsrStepClockHandler();
-  }
+  QuadratureEncoder::IsrTimer2Handler();
+}
+
+/******************************************************//**
+ * @brief  The pin change ISRs of ports B (pins 8..13), C (A0..A5)
+ * and D (pins 0..7), each built when its QUADRATURE_PCINT_PORT_x
+ * is set. The port is read before anything else, so the levels are
+ * as close to the edge as INT0/INT1 read them.
+ * @param  PCINTn_vect interrupt handler which is called when a pin
+ * unmasked in PCMSKn changes
+ * @retval None
+ **********************************************************/
+#if QUADRATURE_PCINT_PORT_B
+ISR(PCINT0_vect)
+{
+  QuadratureEncoder::IsrPinChangeHandler(0, PINB);
+}
+#endif
+
+#if QUADRATURE_PCINT_PORT_C
+ISR(PCINT1_vect)
+{
+  QuadratureEncoder::IsrPinChangeHandler(1, PINC);
 }
+#endif
 
+#if QUADRATURE_PCINT_PORT_D
+ISR(PCINT2_vect)
+{
+  QuadratureEncoder::IsrPinChangeHandler(2, PIND);
+}
+#endif
@@ -15,10 +15,54 @@
 #define __QUADRATURE_ENCODER_H_INCLUDED
 
 #include <inttypes.h>
+#include "sampleTimer.h"
 
-/// Digital pins used for the quadrature pulse signals
-#define Quadrature_Pulse_A_Pin  (2) // Green wire
-#define Quadrature_Pulse_B_Pin  (3) // White wire
+/// Digital pins of INT0 and INT1, the default encoder pins. Pin 2 is also the L6474 FLAG.
+#define Quadrature_Pulse_A_Pin  (2)
+#define Quadrature_Pulse_B_Pin  (3)
+
+/// Digital pins of the pendulum encoder, A2 and A3, decoded through the pin change interrupt
+/// of port C so INT0 stays with the L6474 FLAG
+#define Quadrature_Pendulum_A_Pin (16) // Green wire
+#define Quadrature_Pendulum_B_Pin (17) // White wire
+
+/// Digital pins of the cart encoder, A0 and A1, decoded through the pin change interrupt of port C
+#define Quadrature_Cart_A_Pin   (14)
+#define Quadrature_Cart_B_Pin   (15)
+
+/// Pin change ISRs the library defines, 1 for each port it decodes through PCINTn_vect.
+/// Only port C, holding the pendulum and cart encoders, is on by default. A port left
+/// out keeps its vector for another library; SoftwareSerial defines all three.
+#ifndef QUADRATURE_PCINT_PORT_B
+#define QUADRATURE_PCINT_PORT_B  (0) // PCINT0_vect, pins 8..13
+#endif
+#ifndef QUADRATURE_PCINT_PORT_C
+#define QUADRATURE_PCINT_PORT_C  (1) // PCINT1_vect, A0..A5
+#endif
+#ifndef QUADRATURE_PCINT_PORT_D
+#define QUADRATURE_PCINT_PORT_D  (0) // PCINT2_vect, pins 0..7
+#endif
+
+/// PCICR bits of the ports whose pin change ISR the library defines
+#define Quadrature_Pin_Change_Ports  ((QUADRATURE_PCINT_PORT_B ? 0x01 : 0) | \
+                                      (QUADRATURE_PCINT_PORT_C ? 0x02 : 0) | \
+                                      (QUADRATURE_PCINT_PORT_D ? 0x04 : 0))
+
+/// Most encoders decoded at once, each gets its own ISR trampolines
+#define Encoder_Max_Instances   (2)
+
+/// Define to count the pulses with Timer 1, see EDGE_PROCESS_COUNTER. Timer 1 is the
+/// step clock of L6474 shield 0, which cannot begin while the counter holds it.
+#ifndef QUADRATURE_TIMER1_COUNTER
+//#define QUADRATURE_TIMER1_COUNTER
+#endif
+
+#ifdef QUADRATURE_TIMER1_COUNTER
+/// Hardware counting, see EDGE_PROCESS_COUNTER: A also drives the Timer 1 clock input,
+/// and a D flip-flop clocked by the falling edge of A latches B onto the B pin
+#define Quadrature_Counter_Pin    (5) // T1
+#define Quadrature_Direction_Pin  Quadrature_Pulse_B_Pin
+#endif
 
 /// Value to increment based on direction
 typedef enum {
@@ -36,21 +80,156 @@ typedef enum {
   MASK_B_TRANSITION_TO_A_COUNT = 0b0100
 } stateMask_t;
 
+/// Decoding mode, the value is the number of counts per encoder pulse
+typedef enum {
+  DECODE_1X = 1,  //Count once per pulse on the FALLING edges of A and B
+  DECODE_4X = 4   //Count every edge of A and B on CHANGE
+} decodeMode_t;
+
+/// Clock the edges are timestamped with for pulse timing
+typedef enum {
+  TIMESTAMP_MICROS = 0,  //micros(), 4us resolution
+  TIMESTAMP_TIMER2       //Timer 2 counter at clk/8 extended by its compare matches, 0.5us resolution
+} timestampSource_t;
+
+/// Velocity estimation method
+typedef enum {
+  VELOCITY_IIR = 0,      //Pulse timing below GetFastCalcThreshold(), pulse counting above it, both through the IIR LPF
+  VELOCITY_MT,           //M/T method: pulses in each sample window over the time between the last edges of the windows
+  VELOCITY_LSQ           //Least-squares fit of the edge timestamps over the last edges, see SetVelocityWindow()
+} velocityEstimator_t;
+
+/// Most edges the least-squares velocity fit runs over
+#define Velocity_Max_Window  (16)
+
+/// Where the edges are decoded
+typedef enum {
+  EDGE_PROCESS_ISR = 0,  //The pin change ISRs decode every edge and estimate the speed
+  EDGE_PROCESS_DEFERRED, //The pin change ISRs queue the pin states and timestamps for DecodeEdges()
+#ifdef QUADRATURE_TIMER1_COUNTER
+  EDGE_PROCESS_COUNTER   //Timer 1 counts the falling edges of A, the direction latch interrupts on reversals only
+#endif
+} edgeProcessing_t;
+
+/// Edge records of a deferred processing ring that a 1kHz loop does not overrun
+#define Edge_Ring_Size  (64)
+
+/// Edge queued by a pin change ISR for DecodeEdges()
+typedef struct {
+  uint8_t state;   //BA state read in the ISR, bit 2 set when pin B raised it
+  uint16_t time;   //Low 16 bits of the timestamp
+} edgeRecord_t;
+
+/// Encoder state at one moment, see QuadratureEncoder::GetState()
+typedef struct {
+  int16_t position;          //Counts from 0 to GetPulsesPerRotation()-1
+  int32_t absolutePosition;  //Counts from home, not wrapped to the rotation
+  int32_t velocity;          //Counts/s (CCW is + / CW is -)
+  int8_t direction;          //Direction of the last speed update (CCW is + / CW is -)
+  int8_t edgeDirection;      //Direction of the last counted edge, 0 before the first
+  unsigned long edgeTime;    //Timestamp of the last counted edge in timestamp clock ticks
+  uint8_t sequence;          //Changes whenever the ISRs update the state
+} encoderSnapshot_t;
+
+/// Copy of the least-squares window taken with a snapshot, see QuadratureEncoder::FitWindow()
+typedef struct {
+  uint32_t sums[2];          //Sums of t and i*t over the window edges i, modulo 2^32
+  uint8_t fill;              //Edges in the window
+  unsigned long sampleTime;  //Timestamp of the last step clock sample
+} velocityWindow_t;
+
+/// State observer estimate in fixed point. Counts are Q16.16 and time is in
+/// observer updates, see GetObserverPeriod()
+typedef struct {
+  int32_t position;      //Counts in Q16.16 from 0 to GetPulsesPerRotation()
+  int32_t velocity;      //Counts per update in Q16.16 (CCW is + / CW is -)
+  int32_t acceleration;  //Counts per update squared in Q16.16
+} observerState_t;
+
+/// Observer gain applied to a Q8 residual as (residual * mantissa) >> shift, giving Q16
+typedef struct {
+  int16_t mantissa;
+  uint8_t shift;
+} observerGain_t;
+
+/// Signal integrity counters, see QuadratureEncoder::GetDiagnostics(). The counters wrap at 65535.
+typedef struct {
+  uint16_t illegalTransitions;    //Edges the decoder could not count: both lines changed, or the edge was gone when read
+  uint16_t overruns;              //Edges read too late in a fast run, so counts were lost or went the wrong way
+  uint16_t suspectedMissedCounts; //Counts lost to illegal transitions and overruns
+  uint16_t glitches;              //Glitches the glitch filter kept out of the position or the timing, see SetGlitchFilter()
+  uint16_t droppedEdges;          //Edges lost to a full queue in deferred processing
+  unsigned long minEdgeInterval;  //Shortest time between two counted edges in timestamp clock ticks
+} encoderDiagnostics_t;
+
+/// ISRs attached for one encoder instance, see QuadratureEncoder::AttachEdgeInterrupts
+typedef struct {
+  void (*leadPulseA)(void);
+  void (*leadPulseB)(void);
+  void (*edgeChange)(void);
+  void (*queueEdgeA)(void);
+  void (*queueEdgeB)(void);
+#ifdef QUADRATURE_TIMER1_COUNTER
+  void (*directionChange)(void);
+#endif
+} encoderIsrTable_t;
+
 /// QuadratureEncoder library class
 class QuadratureEncoder
 {
   public:
-    QuadratureEncoder();              //Constructor
-    void Begin(uint16_t ppr);         //Start the QuadratureEncoder library
+    QuadratureEncoder(uint8_t pinA = Quadrature_Pulse_A_Pin,  //Constructor, both pins on the same port
+                      uint8_t pinB = Quadrature_Pulse_B_Pin);
+    void Begin(uint16_t ppr, decodeMode_t mode = DECODE_1X,  //Start the QuadratureEncoder library
+               timestampSource_t source = TIMESTAMP_MICROS,
+               sampleTimerConfig_t timerConfig = SampleTimer<Sample_Timer_Default_Hz>::Config());
+    template <uint16_t sampleRateHz>
+    void Begin(uint16_t ppr, decodeMode_t mode = DECODE_1X,  //Start the library with the speed sampled at sampleRateHz
+               timestampSource_t source = TIMESTAMP_MICROS)
+    {
+      Begin(ppr, mode, source, SampleTimer<sampleRateHz>::Config());
+    }
     void SetHomePosition();           //Set the quadrature position to zero
-    uint16_t GetPulsesPerRotation();  //Return the number of pulses in one rotation of the quadrature
-    int16_t GetCurrentPosition();     //Return the current position in pulses between 0 and ppr-1
-    int32_t GetCurrentVelocity();     //Return the current velocity in pps (CCW is + / CW is -)
+    uint16_t GetPulsesPerRotation();  //Return the number of counts in one rotation of the quadrature for the decode mode
+    decodeMode_t GetDecodeMode();     //Return the decoding mode
+    bool SetVelocityEstimator(velocityEstimator_t estimator); //Select how the velocity is estimated
+    velocityEstimator_t GetVelocityEstimator();               //Return how the velocity is estimated
+    bool SetVelocityWindow(uint8_t edges, unsigned long *times); //Set the edges the VELOCITY_LSQ fit runs over and their timestamp buffer
+    uint8_t GetVelocityWindow();                              //Return the edges the VELOCITY_LSQ fit runs over
+    int16_t GetCurrentPosition();     //Return the current position in counts between 0 and GetPulsesPerRotation()-1
+    int32_t GetAbsolutePosition();    //Return the position in counts from home, counting whole turns
+    int16_t GetTurns();               //Return the whole turns from home (CCW is + / CW is -)
+    int32_t GetCurrentVelocity();     //Return the current velocity in counts/s (CCW is + / CW is -)
+    bool SetEdgeProcessing(edgeProcessing_t processing,   //Decode the edges in the ISRs or queue them into ring for DecodeEdges
+                           edgeRecord_t *ring = NULL, uint8_t ringSize = 0);
+    edgeProcessing_t GetEdgeProcessing();                 //Return where the edges are decoded
+    uint8_t DecodeEdges();                                //Decode the queued edges, call from the main loop
+    uint16_t GetDroppedEdges();                           //Return the edges lost to a full queue
+    void SetGlitchFilter(uint16_t filterUs);              //Keep glitches shorter than filterUs out of the 4x position and timing, 0 turns it off
+    uint16_t GetGlitchFilter();                           //Return the glitch filter time in microseconds
+    void GetDiagnostics(encoderDiagnostics_t &diagnostics); //Return the signal integrity counters
+    void ResetDiagnostics();                              //Clear the signal integrity counters
+    encoderSnapshot_t GetState();     //Return position, velocity, direction and last edge time from the same moment
+    encoderSnapshot_t GetPositionState(); //Return GetState() without the VELOCITY_LSQ fit, for position readers
+    void SetObserverBandwidth(uint16_t bandwidth);  //Start the state observer at a bandwidth in rad/s, 0 stops it
+    uint16_t GetObserverBandwidth();                //Return the state observer bandwidth in rad/s
+    void GetObserverState(observerState_t &state);  //Return the position, velocity and acceleration estimate
+    unsigned long GetObserverPeriod();              //Return the observer update period in timestamp clock ticks
+    unsigned long GetSamplePeriod();                //Return the speed sample period in timestamp clock ticks
+    uint16_t GetFastCalcThreshold();                //Return the speed in counts per second above which VELOCITY_IIR counts pulses
+    uint8_t GetPulsePinA();                         //Return the digital pin of the A line
+    uint8_t GetPulsePinB();                         //Return the digital pin of the B line
+    bool UsesPinChangeInterrupt();                  //Return true if the lines are decoded through PCINT instead of INT0/INT1
 
     // these methods are for use in the ISR only
-    static class QuadratureEncoder *GetInstancePtr();  //pointer to access methods in ISR on a clock step
+    static class QuadratureEncoder *GetInstancePtr(uint8_t index = 0); //pointer to access methods in ISR on a clock step
+    static void IsrTimer2Handler();                    //function to be called by the Timer 2 ISR, runs the step clock of every encoder
+    static void IsrPinChangeHandler(uint8_t port, uint8_t levels); //function to be called by the PCINTn ISRs with the PINx levels
     void IsrStepClockHandler();                        //function to be called internally, on each step of the ISR clock only
     uint8_t GetEncoderState();                         //returns the stored states of the encoder
+    unsigned long GetTimestamp();                      //returns the edge timestamp clock, call with interrupts disabled
+    unsigned long GetTimestampsPerSecond();            //returns the rate of the edge timestamp clock
+    timestampSource_t GetTimestampSource();            //returns the clock the edges are timestamped with
 
   private:
     void InitIsrIntervalForTimer2();
@@ -58,23 +237,118 @@ class QuadratureEncoder
     void CheckSpeedTimeout();
     void UpdatePosition(incrementPosition_t direction);
     void UpdateDirection(int8_t);
-    void UpdateState();
-    unsigned long UpdateSpeed(uint32_t samples, unsigned long periodMicros);
-    unsigned long UpdateAcceleration(unsigned long periodMicros);
-    static void LeadPulseA();
-    static void LeadPulseB();
+    void CountIllegal(uint8_t missedCounts);
+    void CountHeldGlitch();
+    void CountOverrun(uint8_t missedCounts);
+    bool InFastRun(unsigned long now, unsigned long lastEdge);
+    uint8_t ReadLines();
+    void UpdateState(uint8_t lines);
+    void DecodePulseA(uint8_t lines);
+    void DecodePulseB(uint8_t lines);
+    void DecodeChange(uint8_t lines);
+    void PinChange(uint8_t levels);
+    void UpdateSpeed(uint32_t samples, unsigned long period);
+    void UpdateSpeedMT(int32_t pulses, unsigned long edgeTime, unsigned long now);
+    void AttachEdgeInterrupts();
+    void AttachPinChange();
+    void QueueEdge(uint8_t record);
+#ifdef QUADRATURE_TIMER1_COUNTER
+    void UpdateCounter();
+    void ReverseCounter();
+#endif
+    void UpdateObserver();
+    void UpdateWindow(int8_t direction, unsigned long now);
+    bool FitsWindow();
+    encoderSnapshot_t CopyState(velocityWindow_t *window);
+    void FitWindow(encoderSnapshot_t &state, const velocityWindow_t &window);
+    static observerGain_t ObserverGain(float gain);
+    template <uint8_t index> static void LeadPulseA();
+    template <uint8_t index> static void LeadPulseB();
+    template <uint8_t index> static void EdgeChange();
+    template <uint8_t index> static void QueueEdgeA();
+    template <uint8_t index> static void QueueEdgeB();
+#ifdef QUADRATURE_TIMER1_COUNTER
+    template <uint8_t index> static void DirectionChange();
+#endif
 
     // member variables
+    uint8_t instanceIndex;                      //Slot in instances, Encoder_Max_Instances when none was free
+    uint8_t pulsePinA;                          //Digital pin of the A line
+    uint8_t pulsePinB;                          //Digital pin of the B line
+    volatile uint8_t *pinInput;                 //PINx register of the port both lines are on
+    uint8_t maskA;                              //Bit of the A line in pinInput
+    uint8_t maskB;                              //Bit of the B line in pinInput
+    bool pinChange;                             //Lines decoded through the pin change interrupt of their port
+    uint8_t pinChangePort;                      //PCICR bit of the port, the n of PCINTn_vect
+    volatile uint8_t pinLevels;                 //Port levels at the last pin change interrupt
     volatile uint8_t encoderState;              //Encoder state and previous 3 states of the quadrature stored as [n-3][n-2][n-1][n]
-    uint16_t pulsesPerRotation;                 //Number of pulses in one rotation of the quadrature
-    volatile int16_t position;                  //Position of the quadrature in pulses from 0 to ppr-1
-    volatile uint16_t speed[2];                 //Filtered rotation speed in pulses per second (pps)
+    uint16_t pulsesPerRotation;                 //Number of counts in one rotation of the quadrature, ppr times the decode mode
+    decodeMode_t decodeMode;                    //Counts per encoder pulse
+    volatile int16_t position;                  //Position of the quadrature in counts from 0 to pulsesPerRotation-1
+    volatile uint16_t speed[2];                 //Filtered rotation speed in counts per second
     volatile int8_t directionVector;            //The direction of the current and previous rotation (CCW is + / CW is -)
     volatile bool reverseLpfBias;               //Flag to reverse the LPF bias weight from the previous value to the current value
-    volatile unsigned long lastPositionTime;    //Timestamp the position was last updated in microseconds
+    volatile unsigned long lastPositionTime;    //Timestamp the position was last updated in timestamp clock ticks
+    volatile uint8_t stateSequence;             //Incremented by the ISRs after each update of the GetState fields
+    timestampSource_t timestampSource;          //Clock the edges are timestamped with
+    unsigned long timestampsPerSecond;          //Rate of the timestamp clock
+    unsigned long samplePeriod;                 //Speed sample period of the step clock in timestamp clock ticks
+    sampleTimerConfig_t sampleTimer;            //Timer 2 setup of the speed sample rate
+    static volatile uint32_t timer2Cycles;      //Timer 2 compare matches, the upper bits of the Timer 2 timestamps
+    uint8_t sampleCycles;                       //Timer 2 compare matches since the last speed sample with Timer 2 timestamps
     volatile int32_t pulsesPerSample;           //Pulse counter for when pulse counting is used to determine speed
     volatile bool doFastPulseCalc;              //Flag determines if speed is calculated via pulse counting (fast speeds) or pulse timing (slow speeds)
-    static class QuadratureEncoder *instancePtr;//Pointer so the global ISR can call public methods
+    uint16_t fastCalcThreshold;                 //Speed in counts per second above which pulse counting is used
+    velocityEstimator_t velocityEstimator;      //Velocity estimation method
+    unsigned long windowEdgeTime;               //Timestamp of the last edge before the current M/T window
+    unsigned long windowStartTime;              //Timestamp DecodeEdges opened the current M/T window at
+    volatile int32_t edgeCount;                 //Net counts since Begin, not wrapped to the rotation
+    int32_t homeCount;                          //edgeCount at the home position
+    volatile int8_t edgeDirection;              //Direction of the last counted edge
+    unsigned long priorPositionTime;            //lastPositionTime before the last counted edge, restored by the glitch filter
+    int8_t priorDirection;                      //edgeDirection before the last counted edge, restored by the glitch filter
+    uint16_t glitchFilterUs;                    //Glitch filter time in microseconds, 0 when off
+    unsigned long glitchFilter;                 //Glitch filter time in timestamp clock ticks
+    unsigned long overrunInterval;              //Counted edge interval of a run fast enough to outrun the ISRs in timestamp clock ticks
+    uint8_t heldState;                          //State before a both-lines read the glitch filter holds, No_Held_State when none
+    unsigned long heldTime;                     //Timestamp of the held read
+    uint8_t heldCharge;                         //Missed counts charged for the held read since the last ResetDiagnostics
+    bool lateRead;                              //The last 4x read already took the edge of the next ISR
+    uint8_t fastEdges;                          //Counted edges in a row closer than overrunInterval in one direction
+    volatile uint16_t illegalTransitions;       //Edges the decoder could not count
+    volatile uint16_t overruns;                 //Edges read too late in a fast run
+    volatile uint16_t suspectedMissedCounts;    //Counts lost to the illegal transitions and overruns
+    volatile uint16_t glitches;                 //Glitches the glitch filter kept out of the position or the timing
+    volatile unsigned long minEdgeInterval;     //Shortest time between two counted edges in timestamp clock ticks
+    uint8_t windowSize;                         //Edges the least-squares fit runs over
+    volatile uint8_t windowFill;                //Edges in the fit window, reset by a direction change
+    uint8_t windowIndex;                        //Next slot of windowTime
+    volatile int8_t windowDirection;            //Direction of the edges in the fit window
+    unsigned long *windowTime;                  //Timestamps of the edges in the fit window, given to SetVelocityWindow
+    volatile uint32_t windowSum[2];             //Sums of t and i*t over the window edges i, modulo 2^32
+    volatile unsigned long sampleTime;          //Timestamp of the last step clock sample with VELOCITY_LSQ
+    uint16_t observerBandwidth;                 //Observer bandwidth in rad/s, 0 when the observer is stopped
+    unsigned long observerPeriod;               //Observer update period in timestamp clock ticks
+    uint32_t observerReciprocal;                //4096 * 65536 / observerPeriod, turns an edge age into a Q12 fraction of an update
+    observerGain_t observerGain[3];             //Position, velocity and acceleration gains
+    uint32_t observerPosition;                  //Estimated counts since Begin in Q16.16, wraps with edgeCount
+    int32_t observerVelocity;                   //Estimated counts per update in Q16.16
+    int32_t observerAcceleration;               //Estimated counts per update squared in Q16.16
+    unsigned long observerEdgeTime;             //Timestamp of the last edge the observer has used
+    unsigned long observerUpdateTime;           //Timestamp of the last observer update
+    edgeProcessing_t edgeProcessing;            //Where the edges are decoded
+    edgeRecord_t *edgeRing;                     //Edges queued by the pin change ISRs in deferred processing, given to SetEdgeProcessing
+    uint8_t edgeRingSize;                       //Records in edgeRing
+    volatile uint8_t edgeHead;                  //Next record the ISRs write, only written by the ISRs
+    volatile uint8_t edgeTail;                  //Next record DecodeEdges reads, only written by DecodeEdges
+    volatile uint16_t droppedEdges;             //Edges the ISRs found no room for
+#ifdef QUADRATURE_TIMER1_COUNTER
+    volatile uint16_t counterLast;              //Timer 1 count already added to the position in hardware counting
+    volatile int8_t counterDirection;           //Direction of the Timer 1 counts, from the direction latch
+#endif
+    static class QuadratureEncoder *instances[Encoder_Max_Instances]; //Pointers so the global ISRs can call public methods
+    static class QuadratureEncoder *timer2Owner;//Encoder that set up Timer 2, the others share its timestamp clock and sample rate
+    static const encoderIsrTable_t isrTable[Encoder_Max_Instances]; //ISR trampolines of each slot
 
 };
 
@@ -0,0 +1,93 @@
+/******************************************************//**
+ * @file    sampleTimer.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Compile-time Timer 2 setup of the encoder speed sample
+ *          clock. The sample rate is a template argument, and the
+ *          prescaler, OCR2A value and exact period are worked out
+ *          by the compiler, which stops with an error when Timer 2
+ *          cannot reach the rate.
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __SAMPLE_TIMER_H_INCLUDED
+#define __SAMPLE_TIMER_H_INCLUDED
+
+#include <Arduino.h>
+
+/// Sample rate of the encoder when none is given, clk/1024 over 256 counts (16.384ms)
+#define Sample_Timer_Default_Hz  (61)
+
+/// Timer 2 compare match period as a timestamp clock, clk/8 over 256 counts (128us)
+#define Sample_Timer_Timestamp_Ticks  (8UL * 256)
+
+/// Timer 2 setup of one sample rate, see SampleTimer
+typedef struct {
+  uint8_t clockSelect;      //CS22:CS20 bits of TCCR2B
+  uint8_t top;              //OCR2A in CTC mode
+  uint32_t periodUs;        //Sample period in microseconds, rounded
+  uint8_t timestampCycles;  //Compare matches per sample while Timer 2 is the timestamp clock
+} sampleTimerConfig_t;
+
+/// SampleTimer library class, one type per sample rate
+template <uint16_t rateHz>
+class SampleTimer
+{
+  public:
+    static_assert(rateHz > 0, "SampleTimer rate must be above 0 Hz");
+
+    static constexpr uint16_t Prescaler(uint8_t select)  //Timer 2 prescaler of a CS22:CS20 value
+    {
+      return select == 1 ? 1 : (select == 2 ? 8 : (select == 3 ? 32 : (select == 4 ? 64 :
+             (select == 5 ? 128 : (select == 6 ? 256 : 1024)))));
+    }
+
+    static constexpr uint32_t Counts(uint8_t select)     //Timer counts per sample at a CS22:CS20 value, rounded
+    {
+      return ((uint32_t)F_CPU + (uint32_t)Prescaler(select) * rateHz / 2) / ((uint32_t)Prescaler(select) * rateHz);
+    }
+
+    static constexpr uint8_t ClockSelect(uint8_t select = 1) //Fastest prescaler whose counts fit the 8-bit timer, 0 if none
+    {
+      return select > 7 ? 0 : (Counts(select) <= 256 ? select : ClockSelect(select + 1));
+    }
+
+    static_assert(ClockSelect() != 0, "SampleTimer rate is below what Timer 2 reaches at clk/1024");
+    static_assert(Counts(1) >= 2, "SampleTimer rate is above what Timer 2 reaches at clk/1");
+
+    static constexpr uint8_t Top()                       //OCR2A value
+    {
+      return (uint8_t)(Counts(ClockSelect()) - 1);
+    }
+
+    static constexpr uint32_t PeriodUs()                 //Sample period the timer actually runs at
+    {
+      /* Cycles per sample (at most 2^18) times 1000 over clock cycles per millisecond, so the
+       * product stays inside 32 bits where cycles * 1000000 would need 38. The casts keep the
+       * host, whose unsigned long is 64 bits, at the width of the AVR. */
+      return (Counts(ClockSelect()) * Prescaler(ClockSelect()) * (uint32_t)1000 + (uint32_t)(F_CPU / 2000)) /
+             (uint32_t)(F_CPU / 1000);
+    }
+
+    static constexpr uint32_t TimestampCycles()          //Compare matches per sample with Timer 2 timestamps
+    {
+      return ((uint32_t)F_CPU + Sample_Timer_Timestamp_Ticks * rateHz / 2) / (Sample_Timer_Timestamp_Ticks * rateHz);
+    }
+
+    static_assert(TimestampCycles() >= 1, "SampleTimer rate is above one sample per Timer 2 timestamp cycle (7.8kHz)");
+    static_assert(TimestampCycles() <= 255, "SampleTimer rate is below 255 Timer 2 timestamp cycles per sample");
+
+    static constexpr sampleTimerConfig_t Config()        //Setup handed to QuadratureEncoder::Begin
+    {
+      return sampleTimerConfig_t{ClockSelect(), Top(), PeriodUs(), (uint8_t)TimestampCycles()};
+    }
+};
+
+static_assert(SampleTimer<1000>::PeriodUs() == 1000, "SampleTimer period of 1kHz is not 1000us");
+
+#endif /* #ifndef __SAMPLE_TIMER_H_INCLUDED */
@@ -14,6 +14,9 @@
 #include "stepperMotor.h"
 #include <Arduino.h>
 
+/// static member definitions
+class StepperMotor* StepperMotor::instancePtr = NULL;
+
 /******************************************************//**
  * @brief  Constructor for the StepperMotor object. Sets the
  * step mode for the stepper motor and the number of degrees
@@ -24,30 +27,49 @@
  * @retval None
  **********************************************************/
 StepperMotor::StepperMotor(float stepAngleDeg, stepMode_t stepMode) : stepMode(stepMode),
-stepAngleDegree(stepAngleDeg / (float)stepMode), stepAngleRadian( (stepAngleDeg / (float)stepMode) * PI / 180.0) {}
+stepAngleRadian( (stepAngleDeg / (float)stepMode) * PI / 180.0), stepAngleDegree(stepAngleDeg / (float)stepMode),
+radiansQ16PerStep(FixedScale(stepAngleRadian * Fixed_Q16_One)),
+stepsPerRadianQ16(FixedScale(1.0f / (stepAngleRadian * Fixed_Q16_One))),
+faults(FAULT_NONE), faultCallback(NULL) {}
 
 /******************************************************//**
  * @brief  Initializes the L6474 BSP library and any initial
  * states the stepper motor driver chip should be in.
- * @param  None
- * @retval None
+ * @param  flagInterrupt true to report driver faults from the
+ * FLAG interrupt on pin 2 with the alarms of l6474_target_config.h,
+ * false to mask every alarm and leave INT0 to an encoder on pin 2
+ * @retval false if an encoder counts with Timer 1, the step clock,
+ * and the driver did not start, else true
  **********************************************************/
-StepperMotor::Begin()
+bool StepperMotor::Begin(bool flagInterrupt)
 {
   /* Start the library to use one shield. The L6474 registers are set with the predefined
    * values from file l6474_target_config.h. This initialization step occupies the following
-   * pins on the Arduino Uno defined in l6474.h: 7, 8, 9 and 2 (pin 2 we will reclaim)*/
-  L6474shield.Begin(1);
-
-  /* Detatch the interrupt from the L6474.Begin() init function. Only two interrupts are 
-   * available on the Arduino Uno and we will need them both for the encoder. */
-  detachInterrupt(2);
+   * pins on the Arduino Uno defined in l6474.h: 7, 8, 9 and 2 (FLAG on INT0)*/
+  if (!L6474shield.Begin(1))
+  {
+    return false;
+  }
 
-  /* As per section 6.17 in hte L6474 datasheet - mask the FLAG conditions to keep the FLAG
-   * pin from being pulled to ground through an open drain transistor. This will keep the 
-   * interrupt on pin 2 open for use with the encoder and not create a pulse with an error
-   * condition. */
-  L6474shield.CmdSetParam(0, L6474_ALARM_EN, 0x0);
+  if (flagInterrupt)
+  {
+    /* L6474.Begin() attached its FLAG handler to INT0 and released the FLAG pin by reading the
+     * status, so every alarm enabled in ALARM_EN now reaches FlagInterruptHandler. */
+    instancePtr = this;
+    L6474shield.AttachFlagInterrupt(FlagInterruptHandler);
+  }
+  else
+  {
+    /* Detatch the interrupt from the L6474.Begin() init function so an encoder on pins 2 and 3
+     * can have both external interrupts. */
+    detachInterrupt(0);
+
+    /* As per section 6.17 in hte L6474 datasheet - mask the FLAG conditions to keep the FLAG
+     * pin from being pulled to ground through an open drain transistor. This will keep the
+     * interrupt on pin 2 open for use with the encoder and not create a pulse with an error
+     * condition. */
+    L6474shield.CmdSetParam(0, L6474_ALARM_EN, 0x0);
+  }
 
   /* Select the step mode for the stepper motor */
   switch(stepMode)
@@ -84,6 +106,96 @@ StepperMotor::Begin()
   /* Keep power bridge active when stepper motor stops moving. This will have the stepper motor
    * hold its position when inactive. */
   L6474shield.SetHoldPositionOnStop(true);
+  return true;
+}
+
+/******************************************************//**
+ * @brief Returns the driver faults reported through the FLAG
+ * interrupt since the last ClearFaults
+ * @param None
+ * @retval stepperFault_t bits, FAULT_NONE without a fault
+ **********************************************************/
+uint8_t StepperMotor::GetFaults()
+{
+  return faults;
+}
+
+/******************************************************//**
+ * @brief Forgets the reported driver faults. A condition that
+ * is still present pulls FLAG low again and is reported anew.
+ * @param None
+ * @retval None
+ **********************************************************/
+void StepperMotor::ClearFaults()
+{
+  faults = FAULT_NONE;
+}
+
+/******************************************************//**
+ * @brief Attaches a function called from the FLAG interrupt with
+ * the faults of each report. It runs with interrupts disabled;
+ * L6474 commands sent from it are safe, a command it interrupts
+ * is sent again.
+ * @param callback Function to call, NULL to detach
+ * @retval None
+ **********************************************************/
+void StepperMotor::AttachFaultCallback(void (*callback)(uint8_t faults))
+{
+  faultCallback = callback;
+}
+
+/******************************************************//**
+ * @brief FLAG interrupt callback. Reading the status releases the
+ * FLAG pin and the latched alarm flags of the L6474.
+ * @param None
+ * @retval None
+ **********************************************************/
+void StepperMotor::FlagInterruptHandler()
+{
+  StepperMotor *motor = instancePtr;
+  if (motor == NULL)
+  {
+    return;
+  }
+
+  uint8_t reported = StatusToFaults(motor->L6474shield.CmdGetStatus(0));
+  motor->faults |= reported;
+  if (reported != FAULT_NONE && motor->faultCallback != NULL)
+  {
+    motor->faultCallback(reported);
+  }
+}
+
+/******************************************************//**
+ * @brief Converts the L6474 STATUS register to stepperFault_t bits.
+ * UVLO, TH_WRN, TH_SD and OCD are active low.
+ * @param status STATUS register value
+ * @retval stepperFault_t bits
+ **********************************************************/
+uint8_t StepperMotor::StatusToFaults(uint16_t status)
+{
+  uint8_t result = FAULT_NONE;
+  if (!(status & L6474_STATUS_OCD))
+  {
+    result |= FAULT_OVERCURRENT;
+  }
+  if (!(status & L6474_STATUS_TH_SD))
+  {
+    result |= FAULT_THERMAL_SHUTDOWN;
+  }
+  if (!(status & L6474_STATUS_TH_WRN))
+  {
+    result |= FAULT_THERMAL_WARNING;
+  }
+  if (!(status & L6474_STATUS_UVLO))
+  {
+    result |= FAULT_UNDERVOLTAGE;
+  }
+  if (status & (L6474_STATUS_WRONG_CMD | L6474_STATUS_NOTPERF_CMD))
+  {
+    result |= FAULT_COMMAND;
+  }
+  return result;
 }
 
 /******************************************************//**
@@ -208,6 +320,73 @@ float StepperMotor::GetAbsolutePositionDeg()
   return (float)L6474shield.GetPosition(0) * stepAngleDegree;
 }
 
+/******************************************************//**
+ * @brief  Returns the acceleration of the stepper motor in
+ * fixed point, without float math
+ * @param  None
+ * @retval Acceleration in radians/s^2 Q16.16
+ **********************************************************/
+angularAccelerationQ16_t StepperMotor::GetAccelerationQ16()
+{
+  return angularAccelerationQ16_t::FromRaw(ApplyScale(L6474shield.GetAcceleration(0), radiansQ16PerStep));
+}
+
+/******************************************************//**
+ * @brief  Returns the current speed of the stepper motor in
+ * fixed point, without float math
+ * @param  None
+ * @retval Current speed in radians/s Q16.16
+ **********************************************************/
+angularVelocityQ16_t StepperMotor::GetCurrentSpeedQ16()
+{
+  return angularVelocityQ16_t::FromRaw(ApplyScale(L6474shield.GetCurrentSpeed(0), radiansQ16PerStep));
+}
+
+/******************************************************//**
+ * @brief  Returns the max speed of the stepper motor in
+ * fixed point, without float math
+ * @param  None
+ * @retval Max speed in radians/s Q16.16
+ **********************************************************/
+angularVelocityQ16_t StepperMotor::GetMaxSpeedQ16()
+{
+  return angularVelocityQ16_t::FromRaw(ApplyScale(L6474shield.GetMaxSpeed(0), radiansQ16PerStep));
+}
+
+/******************************************************//**
+ * @brief  Returns the min speed of the stepper motor in
+ * fixed point, without float math
+ * @param  None
+ * @retval Min speed in radians/s Q16.16
+ **********************************************************/
+angularVelocityQ16_t StepperMotor::GetMinSpeedQ16()
+{
+  return angularVelocityQ16_t::FromRaw(ApplyScale(L6474shield.GetMinSpeed(0), radiansQ16PerStep));
+}
+
+/******************************************************//**
+ * @brief  Returns the deceleration of the stepper motor in
+ * fixed point, without float math
+ * @param  None
+ * @retval Deceleration in radians/s^2 Q16.16
+ **********************************************************/
+angularAccelerationQ16_t StepperMotor::GetDecelerationQ16()
+{
+  return angularAccelerationQ16_t::FromRaw(ApplyScale(L6474shield.GetDeceleration(0), radiansQ16PerStep));
+}
+
+/******************************************************//**
+ * @brief  Returns the absolute position of the stepper motor
+ * in fixed point, without float math. Saturates about 32768 rad
+ * from home.
+ * @param  None
+ * @retval Absolute position from home in radians Q16.16
+ **********************************************************/
+angleQ16_t StepperMotor::GetAbsolutePositionQ16()
+{
+  return angleQ16_t::FromRaw(ApplyScale(L6474shield.GetPosition(0), radiansQ16PerStep));
+}
+
 /******************************************************//**
  * @brief  Changes the acceleration of the stepper motor
  * @param newAcceleration New acceleration to apply in radians/s^2
@@ -304,6 +483,64 @@ bool StepperMotor::SetDecelerationDeg(float newDeceleration)
   return newDeceleration > 0 ? L6474shield.SetDeceleration(0, (uint16_t)(newDeceleration / stepAngleDegree)) : false;
 }
 
+/******************************************************//**
+ * @brief  Converts a positive rate in Q16.16 radians to the
+ * steps the L6474 speed and acceleration registers take.
+ * Rounds to the nearest step and saturates instead of wrapping
+ * when the rate is above what the registers hold.
+ * @param  rateQ16 Rate in radians/s or radians/s^2 Q16.16
+ * @retval Rate in steps/s or steps/s^2
+ **********************************************************/
+uint16_t StepperMotor::ToStepRate(int32_t rateQ16)
+{
+  int32_t steps = ApplyScale(rateQ16, stepsPerRadianQ16);
+  return steps > 0xFFFF ? 0xFFFF : (uint16_t)steps;
+}
+
+/******************************************************//**
+ * @brief  Changes the acceleration of the stepper motor
+ * @param newAcceleration New acceleration to apply in fixed point
+ * @retval true if the command is successfully executed, else false
+ * @note The command is not performed is the shield is executing 
+ * a MOVE or GOTO command (but it can be used during a RUN command)
+ **********************************************************/
+bool StepperMotor::SetAccelerationQ16(angularAccelerationQ16_t newAcceleration)
+{
+  return newAcceleration.Raw() > 0 ? L6474shield.SetAcceleration(0, ToStepRate(newAcceleration.Raw())) : false;
+}
+
+/******************************************************//**
+ * @brief  Changes the max speed of the stepper motor
+ * @param newMaxSpeed New max speed to apply in fixed point
+ * @retval true if the command is successfully executed, else false
+ **********************************************************/
+bool StepperMotor::SetMaxSpeedQ16(angularVelocityQ16_t newMaxSpeed)
+{
+  return newMaxSpeed.Raw() > 0 ? L6474shield.SetMaxSpeed(0, ToStepRate(newMaxSpeed.Raw())) : false;
+}
+
+/******************************************************//**
+ * @brief  Changes the min speed of the stepper motor
+ * @param newMinSpeed New min speed to apply in fixed point
+ * @retval true if the command is successfully executed, else false
+ **********************************************************/
+bool StepperMotor::SetMinSpeedQ16(angularVelocityQ16_t newMinSpeed)
+{
+  return newMinSpeed.Raw() > 0 ? L6474shield.SetMinSpeed(0, ToStepRate(newMinSpeed.Raw())) : false;
+}
+
+/******************************************************//**
+ * @brief  Changes the deceleration of the stepper motor
+ * @param newDeceleration New deceleration to apply in fixed point
+ * @retval true if the command is successfully executed, else false
+ * @note The command is not performed is the shield is executing 
+ * a MOVE or GOTO command (but it can be used during a RUN command)
+ **********************************************************/
+bool StepperMotor::SetDecelerationQ16(angularAccelerationQ16_t newDeceleration)
+{
+  return newDeceleration.Raw() > 0 ? L6474shield.SetDeceleration(0, ToStepRate(newDeceleration.Raw())) : false;
+}
+
 /******************************************************//**
  * @brief  Stops program execution until the shield state becomes Inactive
  * @param  None
@@ -405,3 +642,25 @@ void StepperMotor::MoveDeg(float targetDistance)
 {
   L6474shield.Move(0, targetDistance > 0 ? FORWARD : BACKWARD, (uint32_t)(abs(targetDistance) / stepAngleDegree));
 }
+
+/******************************************************//**
+ * @brief  Requests the motor to move to the specified position 
+ * @param  targetPosition absolute position in fixed point (CCW is + / CW is -)
+ * @retval None
+ **********************************************************/
+void StepperMotor::GoToQ16(angleQ16_t targetPosition)
+{
+  L6474shield.GoTo(0, ApplyScale(targetPosition.Raw(), stepsPerRadianQ16));
+}
+
+/******************************************************//**
+ * @brief  Moves the motor of the specified angle
+ * @param  targetDistance Target distance in fixed point
+ * @retval None
+ **********************************************************/
+void StepperMotor::MoveQ16(angleQ16_t targetDistance)
+{
+  bool forward = targetDistance > angleQ16_t();
+  L6474shield.Move(0, forward ? FORWARD : BACKWARD,
+                   (uint32_t)ApplyScale((forward ? targetDistance : -targetDistance).Raw(), stepsPerRadianQ16));
+}
@@ -15,6 +15,7 @@
 #define __STEPPER_MOTOR_H_INCLUDED
 
 #include "l6474.h"
+#include "fixedPoint.h"
 
 /// Step mode options for stepper motor
 typedef enum {
@@ -31,11 +32,26 @@ typedef enum {
   CW = BACKWARD       //move clockwise
 } direction_t;
 
+/// Driver faults reported through the L6474 FLAG pin, same bits as ALARM_EN
+typedef enum {
+  FAULT_NONE             = 0x00,
+  FAULT_OVERCURRENT      = L6474_ALARM_EN_OVERCURRENT,
+  FAULT_THERMAL_SHUTDOWN = L6474_ALARM_EN_THERMAL_SHUTDOWN,
+  FAULT_THERMAL_WARNING  = L6474_ALARM_EN_THERMAL_WARNING,
+  FAULT_UNDERVOLTAGE     = L6474_ALARM_EN_UNDERVOLTAGE,
+  FAULT_COMMAND          = L6474_ALARM_EN_WRONG_NPERF_CMD  //wrong or not performable command
+} stepperFault_t;
+
 class StepperMotor
 {
   public:
     StepperMotor(float stepAngleDeg, stepMode_t stepMode);//Constructor for the StepperMotor
-    Begin();                                              //Start the StepperMotor library
+    bool Begin(bool flagInterrupt = true);                //Start the StepperMotor library, false gives pin 2 to an encoder
+
+    uint8_t GetFaults();                                  //Return the stepperFault_t bits reported since ClearFaults
+    void ClearFaults();                                   //Forget the reported faults
+    void AttachFaultCallback(void (*callback)(uint8_t faults)); //Call a function from the FLAG interrupt on every fault
+    static void FlagInterruptHandler();                   //Read and release the L6474 status when FLAG falls
 
     float GetAccelerationRad();                           //Return the acceleration in radians/s^2
     float GetAccelerationDeg();                           //Return the acceleration in degrees/s^2
@@ -55,6 +71,13 @@ class StepperMotor
     float GetAbsolutePositionRad();                       //Return the absolute position from home in radians
     float GetAbsolutePositionDeg();                       //Return the absolute position from home in degrees
 
+    angularAccelerationQ16_t GetAccelerationQ16();        //Return the acceleration in fixed point
+    angularVelocityQ16_t GetCurrentSpeedQ16();            //Return the current speed in fixed point
+    angularVelocityQ16_t GetMaxSpeedQ16();                //Return the max speed in fixed point
+    angularVelocityQ16_t GetMinSpeedQ16();                //Return the min speed in fixed point
+    angularAccelerationQ16_t GetDecelerationQ16();        //Return the deceleration in fixed point
+    angleQ16_t GetAbsolutePositionQ16();                  //Return the absolute position from home in fixed point
+
     bool SetAccelerationRad(float newAcceleration);       //Set the acceleration in radians/s^2
     bool SetAccelerationDeg(float newAcceleration);       //Set the acceleration in degrees/s^2
 
@@ -67,6 +90,11 @@ class StepperMotor
     bool SetDecelerationRad(float newDeceleration);       //Set the deceleration in radians/s^2
     bool SetDecelerationDeg(float newDeceleration);       //Set the deceleration in degrees/s^2
 
+    bool SetAccelerationQ16(angularAccelerationQ16_t newAcceleration); //Set the acceleration in fixed point
+    bool SetMaxSpeedQ16(angularVelocityQ16_t newMaxSpeed);             //Set the max speed in fixed point
+    bool SetMinSpeedQ16(angularVelocityQ16_t newMinSpeed);             //Set the min speed in fixed point
+    bool SetDecelerationQ16(angularAccelerationQ16_t newDeceleration); //Set the deceleration in fixed point
+
     void WaitWhileActive();                               //Wait for the shield state becomes Inactive
     void HardStop();                                      //Stop the motor
     bool SoftStop();                                      //Progressively stops the motor
@@ -81,11 +109,21 @@ class StepperMotor
     void MoveRad(float targetDistance);                   //Move the motor the specified number of radians (CCW is + / CW is -)
     void MoveDeg(float targetDistance);                   //Move the motor the specified number of degrees (CCW is + / CW is -)
 
+    void GoToQ16(angleQ16_t targetPosition);              //Go to the specified position in fixed point (CCW is + / CW is -)
+    void MoveQ16(angleQ16_t targetDistance);              //Move the motor the specified angle in fixed point (CCW is + / CW is -)
+
   private:
+    static uint8_t StatusToFaults(uint16_t status);
+    uint16_t ToStepRate(int32_t rateQ16);                 //Steps/s or steps/s^2 for a positive Q16.16 rate, saturated at 0xFFFF
     L6474 L6474shield;
     stepMode_t stepMode;
     float stepAngleRadian;
     float stepAngleDegree;
+    fixedScale_t radiansQ16PerStep;                       //Steps to Q16.16 radians
+    fixedScale_t stepsPerRadianQ16;                       //Q16.16 radians to steps
+    volatile uint8_t faults;                              //stepperFault_t bits reported since ClearFaults
+    void (*faultCallback)(uint8_t faults);                //Called from the FLAG interrupt, NULL for none
+    static class StepperMotor *instancePtr;               //Pointer so the FLAG interrupt can reach the instance
 };
 
 
@@ -0,0 +1,141 @@
+/******************************************************//**
+ * @file    trigTable.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Cosine tables in flash with one entry per encoder
+ *          count, generated by the compiler for the table size.
+ *          A lookup is one pgm_read_word instead of a soft-float
+ *          cos() call on the AVR, and the sine is the same table a
+ *          quarter turn on.
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __TRIG_TABLE_H_INCLUDED
+#define __TRIG_TABLE_H_INCLUDED
+
+#include <Arduino.h>
+
+/// Table value of 1.0, so +1 and -1 both fit an int16_t
+#define Trig_Table_One  (32767)
+
+/// Indices 0..size-1 as a template argument pack
+template <uint16_t... index>
+struct TrigTableIndices {};
+
+/// Concatenates two index packs, shifting the second past the first
+template <class first, class second>
+struct TrigTableJoin;
+
+template <uint16_t... first, uint16_t... second>
+struct TrigTableJoin<TrigTableIndices<first...>, TrigTableIndices<second...> >
+{
+  typedef TrigTableIndices<first..., (uint16_t)(sizeof...(first) + second)...> type;
+};
+
+/// Builds the pack 0..size-1 by halves, so the nesting depth is log2(size)
+template <uint16_t size>
+struct TrigTableSequence
+{
+  typedef typename TrigTableJoin<typename TrigTableSequence<size / 2>::type,
+                                 typename TrigTableSequence<size - size / 2>::type>::type type;
+};
+
+template <>
+struct TrigTableSequence<0>
+{
+  typedef TrigTableIndices<> type;
+};
+
+template <>
+struct TrigTableSequence<1>
+{
+  typedef TrigTableIndices<0> type;
+};
+
+/******************************************************//**
+ * @brief  Taylor series of cos from the given term on, evaluated
+ * by the compiler. 15 terms are exact to double precision for
+ * angles in [-pi, pi].
+ * @param  squared Angle squared
+ * @param  term Value of term n
+ * @param  n Term number
+ * @retval sum of the terms from n on
+ **********************************************************/
+constexpr double TrigTableCosSeries(double squared, double term, uint8_t n)
+{
+  return n > 15 ? term : term + TrigTableCosSeries(squared, -term * squared / ((2.0 * n + 1.0) * (2.0 * n + 2.0)), n + 1);
+}
+
+/******************************************************//**
+ * @brief  Angle of a count taken to [-pi, pi], so the series
+ * converges, evaluated by the compiler
+ * @param  index Count from 0 to size-1
+ * @param  size Counts in one turn
+ * @retval angle in radians
+ **********************************************************/
+constexpr double TrigTableAngle(uint16_t index, uint16_t size)
+{
+  return TWO_PI * ((int32_t)index * 2 <= size ? (int32_t)index : (int32_t)index - size) / size;
+}
+
+/******************************************************//**
+ * @brief  Rounds a table value to the nearest integer
+ * @param  value Value scaled by Trig_Table_One
+ * @retval rounded value
+ **********************************************************/
+constexpr int16_t TrigTableRound(double value)
+{
+  return (int16_t)(value + (value < 0.0 ? -0.5 : 0.5));
+}
+
+/******************************************************//**
+ * @brief  Table entry for one count, evaluated by the compiler
+ * @param  index Count from 0 to size-1
+ * @param  size Counts in one turn
+ * @retval cos(2pi index / size) scaled by Trig_Table_One
+ **********************************************************/
+constexpr int16_t TrigTableCos(uint16_t index, uint16_t size)
+{
+  return TrigTableRound(Trig_Table_One * TrigTableCosSeries(TrigTableAngle(index, size) * TrigTableAngle(index, size), 1.0, 0));
+}
+
+/// Flash storage of one table size, shared by every user of that size
+template <uint16_t size, class indices>
+struct TrigTableData;
+
+template <uint16_t size, uint16_t... index>
+struct TrigTableData<size, TrigTableIndices<index...> >
+{
+  static const int16_t cosine[size];
+};
+
+template <uint16_t size, uint16_t... index>
+const int16_t TrigTableData<size, TrigTableIndices<index...> >::cosine[size] PROGMEM = {TrigTableCos(index, size)...};
+
+/// Cosine and sine of an angle given in counts, size counts per turn
+template <uint16_t size>
+class TrigTable
+{
+  public:
+    static_assert(size % 4 == 0, "The sine reads the cosine table a quarter turn on, counts per turn must divide by 4");
+
+    static int16_t Cos(uint16_t count)    //cos of count * 2pi / size, count from 0 to size-1
+    {
+      return (int16_t)pgm_read_word(&Data::cosine[count]);
+    }
+
+    static int16_t Sin(uint16_t count)    //sin of count * 2pi / size, count from 0 to size-1
+    {
+      return (int16_t)pgm_read_word(&Data::cosine[count >= size / 4 ? count - size / 4 : count + size - size / 4]);
+    }
+
+  private:
+    typedef TrigTableData<size, typename TrigTableSequence<size>::type> Data;
+};
+
+#endif /* #ifndef __TRIG_TABLE_H_INCLUDED */
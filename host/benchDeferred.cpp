@@ -0,0 +1,194 @@
+/******************************************************//**
+ * @file    benchDeferred.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Edges decoded in the pin change ISRs against edges
+ *          queued by the ISRs and decoded by a 1kHz main loop, and
+ *          pulses counted by Timer 1: handler time, CPU load, lost
+ *          counts, queue depth and velocity error on generated edge
+ *          streams
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "quadratureEdgeGenerator.h"
+#include "quadratureEncoder.h"
+#include "l6474Model.h"
+#include "stepperMotor.h"
+#include <stdio.h>
+
+/// Encoder on the rig
+#define Bench_Encoder_Ppr       (360)
+
+/// The main loop decodes and reads the velocity at 1kHz, errors count after the estimate settles
+#define Bench_Loop_Period_Us    (1000)
+#define Bench_Settle_Seconds    (0.25)
+
+/// Edge processing names for the report
+static const char *processingNames[] = {"isr", "deferred", "counter"};
+
+/// Main loop results of one stream
+typedef struct {
+  double sumSquaredError;
+  double maxError;
+  uint32_t readings;
+  uint8_t maxBatch;           //Most edges decoded in one loop
+  uint32_t decoded;
+  uint64_t decodeNanos;       //Host wall time in DecodeEdges
+} loopResult_t;
+
+static HostSimulator simulator;
+static QuadratureEncoder encoder;
+static edgeRecord_t edgeRing[Edge_Ring_Size];
+static QuadratureEdgeGenerator generator;
+static loopResult_t loop;
+static uint64_t streamStart;
+static uint64_t streamEnd;
+
+/******************************************************//**
+ * @brief  Simulator event standing in for the control loop. It
+ * decodes the queued edges, then compares the velocity with the
+ * rate the generator is producing.
+ * @param  context Unused
+ * @retval None
+ **********************************************************/
+static void ControlLoop(void *context)
+{
+  uint64_t now = simulator.GetTime();
+  if (now >= streamEnd)
+  {
+    return;
+  }
+
+  uint64_t hostStart = HostWallClockNanos();
+  uint8_t batch = encoder.DecodeEdges();
+  loop.decodeNanos += HostWallClockNanos() - hostStart;
+  loop.decoded += batch;
+  loop.maxBatch = batch > loop.maxBatch ? batch : loop.maxBatch;
+
+  double time = (double)(now - streamStart) / Sim_Ticks_Per_Second;
+  if (time >= Bench_Settle_Seconds)
+  {
+    /* Four edges per pulse, one count per pulse in 1x and one per edge in 4x */
+    double truth = generator.GetRate(time) / 4.0 * encoder.GetDecodeMode();
+    double difference = fabs(encoder.GetCurrentVelocity() - truth);
+    loop.sumSquaredError += difference * difference;
+    loop.maxError = difference > loop.maxError ? difference : loop.maxError;
+    loop.readings++;
+  }
+  simulator.ScheduleIn((uint64_t)Bench_Loop_Period_Us * Sim_Ticks_Per_Us, ControlLoop, context);
+}
+
+/******************************************************//**
+ * @brief  Plays one stream with one edge processing and prints
+ * what the ISRs cost and what the main loop made of it
+ * @param  name Stream name
+ * @param  config Stream description
+ * @param  processing Edge processing under test
+ * @retval None
+ **********************************************************/
+static void Compare(const char *name, const edgeStreamConfig_t &config, edgeProcessing_t processing)
+{
+  /* Let the previous estimate time out so every stream starts from rest */
+  encoder.SetEdgeProcessing(processing, edgeRing, Edge_Ring_Size);
+  simulator.RunFor(Sim_Ticks_Per_Second);
+
+  memset(&loop, 0, sizeof(loop));
+  uint16_t droppedBefore = encoder.GetDroppedEdges();
+  streamStart = simulator.GetTime();
+  streamEnd = streamStart + (uint64_t)(config.duration * Sim_Ticks_Per_Second);
+  simulator.ScheduleIn(0, ControlLoop, NULL);
+  edgeStreamResult_t result = generator.Run(config);
+
+  printf("  %-18s %-8s missed %6ld  dropped %5u  load %5.1f%%  isr %5.1f us  batch %3u  velocity rms %8.1f max %8.1f",
+         name, processingNames[processing], (long)result.missedCounts,
+         (unsigned)(uint16_t)(encoder.GetDroppedEdges() - droppedBefore), result.cpuLoad * 100.0,
+         result.isrTargetUs, loop.maxBatch, loop.readings ? sqrt(loop.sumSquaredError / loop.readings) : 0.0,
+         loop.maxError);
+  if (loop.decoded)
+  {
+    printf("  decode %5.1f ns/edge", (double)loop.decodeNanos / loop.decoded);
+  }
+  printf("\n");
+}
+
+/******************************************************//**
+ * @brief  Runs every stream with the edges decoded in the ISRs,
+ * in the main loop and by Timer 1
+ * @param  mode Decode mode given to QuadratureEncoder::Begin
+ * @param  source Timestamp clock given to QuadratureEncoder::Begin
+ * @retval None
+ **********************************************************/
+static void RunSuite(decodeMode_t mode, timestampSource_t source)
+{
+  static const uint16_t rates[] = {100, 1000, 5000, 10000, 15000, 20000, 30000};
+  char name[32];
+  edgeStreamConfig_t config;
+
+  encoder.Begin(Bench_Encoder_Ppr, mode, source);
+  encoder.SetVelocityEstimator(VELOCITY_MT);
+  printf("%ux decoding, %s timestamps, M/T velocity, error in counts/s\n", (unsigned)mode,
+         source == TIMESTAMP_TIMER2 ? "Timer 2" : "micros()");
+
+  config.profile = EDGE_PROFILE_CONSTANT;
+  config.rate1 = 0.0;
+  config.period = 1.0;
+  config.duration = 1.0;
+  config.jitter = 0.1;
+  config.glitchRate = 0.0;
+  config.glitchNs = 0;
+  config.seed = 7;
+  for (uint8_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+  {
+    config.rate0 = 4.0 * rates[i];
+    snprintf(name, sizeof(name), "%u pps", rates[i]);
+    Compare(name, config, EDGE_PROCESS_ISR);
+    Compare(name, config, EDGE_PROCESS_DEFERRED);
+    Compare(name, config, EDGE_PROCESS_COUNTER);
+  }
+
+  config.profile = EDGE_PROFILE_SINE;
+  config.rate0 = 4.0 * 2000;
+  config.period = 0.25;
+  config.duration = 2.0;
+  Compare("reversals +-2k pps", config, EDGE_PROCESS_ISR);
+  Compare("reversals +-2k pps", config, EDGE_PROCESS_DEFERRED);
+  Compare("reversals +-2k pps", config, EDGE_PROCESS_COUNTER);
+}
+
+int main()
+{
+  simulator.Begin();
+  generator.Begin(&simulator);
+
+  edgeIsrCost_t cost = generator.GetIsrCost();
+  printf("Longest encoder handler on the target: %.1f us decoding, %.1f us queueing, %.1f us per reversal"
+         " with Timer 1 counting (%u / %u / %u cycles with entry)\n",
+         (cost.entry + cost.slowCount) / 16.0, (cost.entry + cost.queue) / 16.0, (cost.entry + cost.reversal) / 16.0,
+         cost.entry + cost.slowCount, cost.entry + cost.queue, cost.entry + cost.reversal);
+
+  RunSuite(DECODE_1X, TIMESTAMP_MICROS);
+  RunSuite(DECODE_4X, TIMESTAMP_TIMER2);
+
+  /* The counter rows run without the motor. StepperMotor steps shield 0 from Timer 1, so it
+   * is refused while the counter holds the timer, and the counter once the motor has begun. */
+  L6474Model model;
+  StepperMotor stepperMotor(1.8f, STEP_QUARTER);
+  model.Begin(1);
+  bool begun = stepperMotor.Begin();
+  printf("Motor begun while Timer 1 counts: %s,", begun ? "started" : "refused");
+  encoder.SetEdgeProcessing(EDGE_PROCESS_ISR);
+  begun = stepperMotor.Begin();
+  bool accepted = encoder.SetEdgeProcessing(EDGE_PROCESS_COUNTER);
+  printf(" after the counter stops: %s, then Timer 1 counting %s\n", begun ? "started" : "refused",
+         accepted ? "accepted" : "refused");
+  model.End();
+
+  generator.End();
+  simulator.End();
+  return 0;
+}
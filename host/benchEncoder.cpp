@@ -0,0 +1,252 @@
+/******************************************************//**
+ * @file    benchEncoder.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Stress test of the QuadratureEncoder interrupt handlers
+ *          with generated A/B edge streams: constant rates, ramps,
+ *          reversals, jitter and glitches, and a search for the
+ *          highest rate the decoder follows without losing counts,
+ *          in 1x and 4x decoding and with either timestamp clock,
+ *          and the signal integrity counters with and without the
+ *          glitch filter
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "quadratureEdgeGenerator.h"
+#include "quadratureEncoder.h"
+#include <stdio.h>
+
+/// Encoder on the rig
+#define Bench_Encoder_Ppr      (360)
+
+/// Highest pulse rate swept, four edges per pulse
+#define Bench_Max_Pps          (20000)
+#define Bench_Step_Seconds     (0.2)
+#define Bench_Search_Seconds   (0.5)
+
+/// Glitch filter times tried on noisy lines
+#define Bench_Filter_Short_Us  (20)
+#define Bench_Filter_Long_Us   (50)
+
+static HostSimulator simulator;
+static QuadratureEncoder encoder;
+static QuadratureEdgeGenerator generator;
+
+/******************************************************//**
+ * @brief  Returns a stream description with everything off
+ * @param  None
+ * @retval constant stream at 0 edges/s
+ **********************************************************/
+static edgeStreamConfig_t DefaultConfig()
+{
+  edgeStreamConfig_t config;
+  config.profile = EDGE_PROFILE_CONSTANT;
+  config.rate0 = 0.0;
+  config.rate1 = 0.0;
+  config.period = 1.0;
+  config.duration = Bench_Step_Seconds;
+  config.jitter = 0.0;
+  config.glitchRate = 0.0;
+  config.glitchNs = 0;
+  config.seed = 1;
+  return config;
+}
+
+/******************************************************//**
+ * @brief  Lets the speed estimate of the previous stream time out
+ * so every stream starts from rest
+ * @param  None
+ * @retval None
+ **********************************************************/
+static void Settle()
+{
+  simulator.RunFor(200ULL * Sim_Ticks_Per_Ms);
+}
+
+/******************************************************//**
+ * @brief  Prints one stream result line
+ * @param  name Stream name
+ * @param  result What the firmware made of the stream
+ * @retval None
+ **********************************************************/
+static void Report(const char *name, const edgeStreamResult_t &result)
+{
+  printf("  %-22s %8lu edges %8ld exp %8ld fw %6ld missed %5lu lost  load %5.1f%%  isr %5.1f us  host %6.1f ns\n",
+         name, (unsigned long)result.edges, (long)result.expectedCounts, (long)result.firmwareCounts,
+         (long)result.missedCounts, (unsigned long)result.lostRequests, result.cpuLoad * 100.0,
+         result.isrTargetUs, result.isrHostNs);
+}
+
+/******************************************************//**
+ * @brief  Plays one stream with the diagnostics cleared and prints
+ * the counters next to what the reference decoder saw
+ * @param  name Stream name
+ * @param  config Stream to play
+ * @param  filterUs Glitch filter time in microseconds, 0 for off
+ * @retval None
+ **********************************************************/
+static void ReportDiagnostics(const char *name, const edgeStreamConfig_t &config, uint16_t filterUs)
+{
+  encoderDiagnostics_t diagnostics;
+
+  encoder.SetGlitchFilter(filterUs);
+  Settle();
+  encoder.ResetDiagnostics();
+  edgeStreamResult_t result = generator.Run(config);
+  encoder.GetDiagnostics(diagnostics);
+
+  printf("  %-22s filter %2u us  illegal %5u  overruns %5u  suspected %5u  missed %5ld  glitches %5u  min %6.1f us\n",
+         name, filterUs, diagnostics.illegalTransitions, diagnostics.overruns, diagnostics.suspectedMissedCounts,
+         (long)result.missedCounts, diagnostics.glitches, diagnostics.minEdgeInterval * 1e6 / encoder.GetTimestampsPerSecond());
+}
+
+/******************************************************//**
+ * @brief  Binary search for the highest constant pulse rate the
+ * firmware follows without a divergence from the reference decoder
+ * @param  jitter Edge jitter as a fraction of the edge interval
+ * @retval highest followed rate in pulses/s
+ **********************************************************/
+static uint32_t FindMaxRate(double jitter)
+{
+  uint32_t low = 0;
+  uint32_t high = 4UL * Bench_Max_Pps;
+  edgeStreamConfig_t config = DefaultConfig();
+  config.duration = Bench_Search_Seconds;
+  config.jitter = jitter;
+
+  while (high - low > 10)
+  {
+    uint32_t pps = (low + high) / 2;
+    config.rate0 = 4.0 * pps;
+    Settle();
+    edgeStreamResult_t result = generator.Run(config);
+    if (result.maxDivergence == 0)
+    {
+      low = pps;
+    }
+    else
+    {
+      high = pps;
+    }
+  }
+  return low;
+}
+
+/******************************************************//**
+ * @brief  Runs the rate sweep, the highest rate search and the
+ * profiles with the encoder in one decode mode
+ * @param  mode Decode mode given to QuadratureEncoder::Begin
+ * @param  source Timestamp clock given to QuadratureEncoder::Begin
+ * @retval None
+ **********************************************************/
+static void RunSuite(decodeMode_t mode, timestampSource_t source)
+{
+  static const uint32_t sweep[] = {100, 500, 1000, 2000, 3000, 4000, 5000, 7500, 10000, 15000, 20000};
+  char name[32];
+  edgeStreamConfig_t config;
+  edgeStreamResult_t result;
+
+  encoder.Begin(Bench_Encoder_Ppr, mode, source);
+  printf("%ux decoding, %u counts per rotation, %s timestamps\n", (unsigned)mode, encoder.GetPulsesPerRotation(),
+         source == TIMESTAMP_TIMER2 ? "Timer 2" : "micros()");
+
+  printf("Constant rate, CPU model\n");
+  for (uint8_t i = 0; i < sizeof(sweep) / sizeof(sweep[0]); i++)
+  {
+    config = DefaultConfig();
+    config.rate0 = 4.0 * sweep[i];
+    Settle();
+    result = generator.Run(config);
+    snprintf(name, sizeof(name), "%lu pps", (unsigned long)sweep[i]);
+    Report(name, result);
+  }
+
+  printf("Constant rate, handlers run instantly\n");
+  generator.SetCpuModel(false);
+  for (uint8_t i = 0; i < sizeof(sweep) / sizeof(sweep[0]); i += 5)
+  {
+    config = DefaultConfig();
+    config.rate0 = 4.0 * sweep[i];
+    Settle();
+    result = generator.Run(config);
+    snprintf(name, sizeof(name), "%lu pps", (unsigned long)sweep[i]);
+    Report(name, result);
+  }
+  generator.SetCpuModel(true);
+
+  printf("Highest followed rate\n");
+  printf("  no jitter              %6lu pps\n", (unsigned long)FindMaxRate(0.0));
+  printf("  20%% jitter             %6lu pps\n", (unsigned long)FindMaxRate(0.2));
+  printf("  45%% jitter             %6lu pps\n", (unsigned long)FindMaxRate(0.45));
+
+  printf("Profiles\n");
+  config = DefaultConfig();
+  config.profile = EDGE_PROFILE_RAMP;
+  config.rate1 = 4.0 * Bench_Max_Pps;
+  config.duration = 2.0;
+  Settle();
+  result = generator.Run(config);
+  Report("ramp 0-20k pps", result);
+  if (result.firstMissTime >= 0.0)
+  {
+    printf("  %-22s first miss at %.3f s, %.0f pps\n", "", result.firstMissTime, result.firstMissRate / 4.0);
+  }
+
+  config = DefaultConfig();
+  config.profile = EDGE_PROFILE_SINE;
+  config.rate0 = 4.0 * 2000;
+  config.period = 0.25;
+  config.duration = 2.0;
+  config.jitter = 0.2;
+  Settle();
+  Report("reversals +-2k pps", generator.Run(config));
+
+  config = DefaultConfig();
+  config.rate0 = 4.0 * 1000;
+  config.duration = 2.0;
+  config.glitchRate = 50.0;
+  config.glitchNs = 500;
+  Settle();
+  result = generator.Run(config);
+  Report("1k pps, glitches", result);
+  printf("  %-22s %lu glitches of %lu ns\n", "", (unsigned long)result.glitches, (unsigned long)config.glitchNs);
+
+  printf("Signal integrity\n");
+  config = DefaultConfig();
+  config.rate0 = 4.0 * 1000;
+  config.duration = 1.0;
+  ReportDiagnostics("1k pps, clean", config, 0);
+  ReportDiagnostics("1k pps, clean", config, Bench_Filter_Long_Us);
+  config.rate0 = 4.0 * 15000;
+  ReportDiagnostics("15k pps, overloaded", config, 0);
+  config.rate0 = 4.0 * 1000;
+  config.glitchRate = 200.0;
+  config.glitchNs = 2000;
+  ReportDiagnostics("1k pps, 2 us glitches", config, 0);
+  ReportDiagnostics("1k pps, 2 us glitches", config, Bench_Filter_Short_Us);
+  ReportDiagnostics("1k pps, 2 us glitches", config, Bench_Filter_Long_Us);
+  encoder.SetGlitchFilter(0);
+}
+
+int main()
+{
+  simulator.Begin();
+  generator.Begin(&simulator);
+
+  edgeIsrCost_t cost = generator.GetIsrCost();
+  printf("Handler cost model (cycles): entry %u, edge %u, count %u fast / %u slow, sample %u, tick %u\n",
+         cost.entry, cost.edge, cost.fastCount, cost.slowCount, cost.sample, cost.tick);
+
+  RunSuite(DECODE_1X, TIMESTAMP_MICROS);
+  RunSuite(DECODE_4X, TIMESTAMP_MICROS);
+  RunSuite(DECODE_4X, TIMESTAMP_TIMER2);
+
+  generator.End();
+  simulator.End();
+  return 0;
+}
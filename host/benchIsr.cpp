@@ -0,0 +1,141 @@
+/******************************************************//**
+ * @file    benchIsr.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Wall-clock benchmark of the firmware interrupt handlers
+ *          and hot control calls running on the host HAL
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "hostHal.h"
+#include "stepperMotor.h"
+#include "pendulum.h"
+#include <stdio.h>
+
+#define Bench_Iterations (1000000UL)
+
+static StepperMotor stepperMotor(1.8f, STEP_QUARTER);
+static Pendulum<360> pendulum;
+static volatile float floatSink;
+static volatile int32_t fixedSink;
+static uint8_t encoderPhase = 0;
+
+/******************************************************//**
+ * @brief  Moves the simulated encoder by one edge. Phases are
+ * the BA levels 11, 01, 00, 10 seen while turning CCW.
+ * @param  direction +1 for CCW, -1 for CW
+ * @retval None
+ **********************************************************/
+static void StepEncoder(int8_t direction)
+{
+  encoderPhase = (encoderPhase + direction) & 0x03;
+  HostSetPinLevel(Quadrature_Pendulum_B_Pin, (encoderPhase == 0 || encoderPhase == 3) ? HIGH : LOW);
+  HostSetPinLevel(Quadrature_Pendulum_A_Pin, (encoderPhase == 0 || encoderPhase == 1) ? HIGH : LOW);
+}
+
+/******************************************************//**
+ * @brief  Prints one benchmark result line
+ * @param  name Benchmark name
+ * @param  nanos Elapsed wall time in nanoseconds
+ * @param  count Number of operations timed
+ * @retval None
+ **********************************************************/
+static void Report(const char *name, uint64_t nanos, unsigned long count)
+{
+  printf("%-44s %10lu ops %9.1f ns/op\n", name, count, (double)nanos / (double)count);
+}
+
+int main()
+{
+  uint64_t start;
+  unsigned long i;
+
+  stepperMotor.Begin();
+  pendulum.Begin();
+
+  /* One pin change interrupt per encoder edge, decoded on the falling edges of A and B */
+  HostResetInterruptCounts();
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    StepEncoder(1);
+  }
+  Report("encoder edge (PCINT1_vect)", HostWallClockNanos() - start,
+         HostGetInterruptCount(HOST_VECT_PCINT1));
+
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    HostRaiseInterrupt(HOST_VECT_TIMER2_COMPA);
+  }
+  Report("encoder sample (TIMER2_COMPA_vect)", HostWallClockNanos() - start, Bench_Iterations);
+
+  stepperMotor.Run(CCW);
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    HostRaiseInterrupt(HOST_VECT_TIMER1_OVF);
+  }
+  Report("step clock, run (TIMER1_OVF_vect)", HostWallClockNanos() - start, Bench_Iterations);
+  stepperMotor.HardStop();
+
+  stepperMotor.MoveDeg(1000000.0);
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    HostRaiseInterrupt(HOST_VECT_TIMER1_OVF);
+  }
+  Report("step clock, move (TIMER1_OVF_vect)", HostWallClockNanos() - start, Bench_Iterations);
+  stepperMotor.HardStop();
+
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    floatSink = stepperMotor.GetAbsolutePositionDeg();
+  }
+  Report("StepperMotor::GetAbsolutePositionDeg", HostWallClockNanos() - start, Bench_Iterations);
+
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    fixedSink = stepperMotor.GetAbsolutePositionQ16().Raw();
+  }
+  Report("StepperMotor::GetAbsolutePositionQ16", HostWallClockNanos() - start, Bench_Iterations);
+
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    floatSink = pendulum.GetCurrentPositionRad() + pendulum.GetCurrentVelocityRad();
+  }
+  Report("Pendulum position + velocity (rad)", HostWallClockNanos() - start, Bench_Iterations);
+
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    pendulumState_t state = pendulum.GetStateRad();
+    floatSink = state.position + state.velocity;
+  }
+  Report("Pendulum::GetStateRad snapshot", HostWallClockNanos() - start, Bench_Iterations);
+
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    fixedSink = pendulum.GetCurrentPositionQ16().Raw() + pendulum.GetCurrentVelocityQ16().Raw();
+  }
+  Report("Pendulum position + velocity (Q16 rad)", HostWallClockNanos() - start, Bench_Iterations);
+
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    pendulumStateQ16_t state = pendulum.GetStateQ16();
+    fixedSink = state.position.Raw() + state.velocity.Raw();
+  }
+  Report("Pendulum::GetStateQ16 snapshot", HostWallClockNanos() - start, Bench_Iterations);
+
+  return 0;
+}
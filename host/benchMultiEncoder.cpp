@@ -0,0 +1,236 @@
+/******************************************************//**
+ * @file    benchMultiEncoder.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Two QuadratureEncoder instances on one CPU: the
+ *          pendulum encoder on INT0/INT1 and the cart encoder on
+ *          the pin change interrupt of port C. Dispatch cost per
+ *          edge, the highest rate each follows alone, and lost
+ *          counts while both turn at once.
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "quadratureEdgeGenerator.h"
+#include "quadratureEncoder.h"
+#include <stdio.h>
+
+/// Encoders on the rig
+#define Bench_Encoder_Ppr       (360)
+#define Bench_Cart_Ppr          (600)
+
+/// Most cycles the interrupt dispatch may take per edge before the decoding starts
+#define Bench_Dispatch_Budget_Cycles  (64)
+
+/// Stream lengths and the highest rate searched, four edges per pulse
+#define Bench_Step_Seconds      (0.2)
+#define Bench_Search_Seconds    (0.5)
+#define Bench_Max_Pps           (20000)
+
+/// Constant rate edge source on the cart encoder pins, played next to a generator stream
+typedef struct {
+  double interval;            //Seconds between edges
+  uint32_t remaining;         //Edges still to play
+  int32_t phase;              //Quadrature position in edges, BA levels 11, 01, 00, 10 while CCW
+} cartSource_t;
+
+static HostSimulator simulator;
+static QuadratureEncoder pendulumEncoder;
+static QuadratureEncoder cartEncoder(Quadrature_Cart_A_Pin, Quadrature_Cart_B_Pin);
+static QuadratureEdgeGenerator generator;
+static cartSource_t cart;
+
+/******************************************************//**
+ * @brief  Returns a stream description with everything off
+ * @param  None
+ * @retval constant stream at 0 edges/s
+ **********************************************************/
+static edgeStreamConfig_t DefaultConfig()
+{
+  edgeStreamConfig_t config;
+  config.profile = EDGE_PROFILE_CONSTANT;
+  config.rate0 = 0.0;
+  config.rate1 = 0.0;
+  config.period = 1.0;
+  config.duration = Bench_Step_Seconds;
+  config.jitter = 0.0;
+  config.glitchRate = 0.0;
+  config.glitchNs = 0;
+  config.seed = 1;
+  return config;
+}
+
+/******************************************************//**
+ * @brief  Lets the speed estimates of the previous stream time out
+ * so every stream starts from rest
+ * @param  None
+ * @retval None
+ **********************************************************/
+static void Settle()
+{
+  simulator.RunFor(200ULL * Sim_Ticks_Per_Ms);
+}
+
+/******************************************************//**
+ * @brief  Simulator event moving the cart encoder by one edge in
+ * the CCW direction. The request latches while the generator holds
+ * the interrupts, so the generator is told to service it.
+ * @param  context Unused
+ * @retval None
+ **********************************************************/
+static void CartEdge(void *context)
+{
+  if (cart.remaining == 0)
+  {
+    return;
+  }
+
+  cart.phase++;
+  cart.remaining--;
+  uint8_t state = cart.phase & 0x03;
+  HostSetPinLevel(Quadrature_Cart_B_Pin, (state == 0 || state == 3) ? HIGH : LOW);
+  HostSetPinLevel(Quadrature_Cart_A_Pin, (state == 0 || state == 1) ? HIGH : LOW);
+  generator.NotifyRequest();
+  simulator.ScheduleIn((uint64_t)(cart.interval * Sim_Ticks_Per_Second), CartEdge, context);
+}
+
+/******************************************************//**
+ * @brief  Binary search for the highest constant pulse rate the
+ * encoder the generator plays into follows without a divergence
+ * from the reference decoder
+ * @param  None
+ * @retval highest followed rate in pulses/s
+ **********************************************************/
+static uint32_t FindMaxRate()
+{
+  uint32_t low = 0;
+  uint32_t high = 4UL * Bench_Max_Pps;
+  edgeStreamConfig_t config = DefaultConfig();
+  config.duration = Bench_Search_Seconds;
+
+  while (high - low > 10)
+  {
+    uint32_t pps = (low + high) / 2;
+    config.rate0 = 4.0 * pps;
+    Settle();
+    edgeStreamResult_t result = generator.Run(config);
+    if (result.maxDivergence == 0)
+    {
+      low = pps;
+    }
+    else
+    {
+      high = pps;
+    }
+  }
+  return low;
+}
+
+/******************************************************//**
+ * @brief  Plays constant rates into one encoder while the other
+ * stays still, then searches its highest followed rate
+ * @param  name Encoder name for the report
+ * @param  target Encoder the generator plays into
+ * @retval None
+ **********************************************************/
+static void RunAlone(const char *name, QuadratureEncoder *target)
+{
+  static const uint32_t rates[] = {1000, 5000, 10000};
+  edgeStreamConfig_t config = DefaultConfig();
+
+  generator.SetEncoder(target);
+  for (uint8_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+  {
+    config.rate0 = 4.0 * rates[i];
+    Settle();
+    edgeStreamResult_t result = generator.Run(config);
+    printf("  %-8s %5lu pps     missed %4ld  lost %4lu  load %5.1f%%  isr %5.1f us  host %6.1f ns\n",
+           name, (unsigned long)rates[i], (long)result.missedCounts, (unsigned long)result.lostRequests,
+           result.cpuLoad * 100.0, result.isrTargetUs, result.isrHostNs);
+  }
+  printf("  %-8s highest followed rate %lu pps\n", name, (unsigned long)FindMaxRate());
+}
+
+/******************************************************//**
+ * @brief  Plays a pendulum stream while the cart encoder turns at a
+ * constant rate, and checks both counts
+ * @param  pendulumPps Pendulum pulse rate
+ * @param  cartPps Cart pulse rate
+ * @retval None
+ **********************************************************/
+static void RunBoth(uint32_t pendulumPps, uint32_t cartPps)
+{
+  edgeStreamConfig_t config = DefaultConfig();
+  config.rate0 = 4.0 * pendulumPps;
+  config.jitter = 0.2;
+
+  /* Whole pulses that end before the stream, so the cart count is exact */
+  uint32_t pulses = (uint32_t)(cartPps * config.duration * 0.9);
+  cart.interval = 1.0 / (4.0 * cartPps);
+  cart.remaining = 4 * pulses;
+
+  generator.SetEncoder(&pendulumEncoder);
+  Settle();
+  int32_t cartBefore = cartEncoder.GetAbsolutePosition();
+  simulator.ScheduleIn((uint64_t)(cart.interval * Sim_Ticks_Per_Second / 2), CartEdge, NULL);
+  edgeStreamResult_t result = generator.Run(config);
+  int32_t cartMissed = (int32_t)(pulses * cartEncoder.GetDecodeMode()) - (cartEncoder.GetAbsolutePosition() - cartBefore);
+
+  printf("  pendulum %5lu pps, cart %5lu pps  pendulum missed %4ld  cart missed %4ld  load %5.1f%%\n",
+         (unsigned long)pendulumPps, (unsigned long)cartPps, (long)result.missedCounts, (long)cartMissed,
+         result.cpuLoad * 100.0);
+}
+
+/******************************************************//**
+ * @brief  Runs the single encoder rates and the concurrent rates
+ * in one decode mode and timestamp clock
+ * @param  mode Decode mode of both encoders
+ * @param  source Timestamp clock, set up by the pendulum encoder
+ * @retval None
+ **********************************************************/
+static void RunSuite(decodeMode_t mode, timestampSource_t source)
+{
+  pendulumEncoder.Begin(Bench_Encoder_Ppr, mode, source);
+  cartEncoder.Begin(Bench_Cart_Ppr, mode, source);
+  printf("%ux decoding, %s timestamps\n", (unsigned)mode, source == TIMESTAMP_TIMER2 ? "Timer 2" : "micros()");
+
+  printf("One encoder turning\n");
+  RunAlone("pendulum", &pendulumEncoder);
+  RunAlone("cart", &cartEncoder);
+
+  printf("Both turning, 20%% jitter on the pendulum\n");
+  RunBoth(1000, 2000);
+  RunBoth(2000, 2000);
+  RunBoth(4000, 2000);
+  RunBoth(2000, 5000);
+}
+
+int main()
+{
+  simulator.Begin();
+  generator.Begin(&simulator);
+
+  /* Put the cart lines at rest before the encoder reads them */
+  HostSetPinLevel(Quadrature_Cart_B_Pin, HIGH);
+  HostSetPinLevel(Quadrature_Cart_A_Pin, HIGH);
+
+  edgeIsrCost_t cost = generator.GetIsrCost();
+  uint16_t pinChangeDispatch = cost.entry + cost.pinChange;
+  printf("Dispatch per edge (cycles): INT0/INT1 %u, PCINT %u + %u = %u, budget %u, %s\n",
+         cost.entry, cost.entry, cost.pinChange, pinChangeDispatch, Bench_Dispatch_Budget_Cycles,
+         pinChangeDispatch <= Bench_Dispatch_Budget_Cycles ? "within" : "OVER");
+  printf("Encoder slots: pendulum %s, cart %s\n",
+         pendulumEncoder.UsesPinChangeInterrupt() ? "PCINT" : "INT0/INT1",
+         cartEncoder.UsesPinChangeInterrupt() ? "PCINT" : "INT0/INT1");
+
+  RunSuite(DECODE_1X, TIMESTAMP_MICROS);
+  RunSuite(DECODE_4X, TIMESTAMP_TIMER2);
+
+  generator.End();
+  simulator.End();
+  return 0;
+}
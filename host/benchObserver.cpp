@@ -0,0 +1,254 @@
+/******************************************************//**
+ * @file    benchObserver.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Estimation error of the encoder state observer read
+ *          through Pendulum, against the true angle, velocity and
+ *          acceleration of generated edge streams, next to the
+ *          count position, the interpolated position and the IIR
+ *          velocity, and the cost of one observer update
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "quadratureEdgeGenerator.h"
+#include "pendulum.h"
+#include <stdio.h>
+
+/// Encoder on the rig
+#define Bench_Encoder_Ppr       (360)
+
+/// State is read like a 1kHz control loop would, after the estimate settles
+#define Bench_Read_Period_Us    (1000)
+#define Bench_Settle_Seconds    (0.25)
+#define Bench_Integration_Steps (20)
+
+/// Observer updates timed for the host cost
+#define Bench_Iterations        (1000000UL)
+
+/// Squared error sums of one stream
+typedef struct {
+  double countPosition;
+  double interpolatedPosition;
+  double observedPosition;
+  double iirVelocity;
+  double observedVelocity;
+  double maxIirVelocity;
+  double maxObservedVelocity;
+  double observedAcceleration;
+  double trueAcceleration;
+  uint32_t readings;
+} observerError_t;
+
+static HostSimulator simulator;
+static QuadratureEdgeGenerator generator;
+static observerError_t error;
+static uint64_t streamStart;
+static uint64_t streamEnd;
+static double countsPerEdge;
+static double radiansPerCount;
+static double startAngle;
+static double trueAngle;
+static double lastTime;
+
+/******************************************************//**
+ * @brief  Wraps an angle difference to -pi to pi
+ * @param  angle Angle in radians
+ * @retval wrapped angle
+ **********************************************************/
+static double WrapAngle(double angle)
+{
+  return angle - TWO_PI * floor((angle + PI) / TWO_PI);
+}
+
+/******************************************************//**
+ * @brief  Simulator event reading the Pendulum state and comparing
+ * it with the motion the generator is producing. The true angle
+ * integrates the profile rate between readings.
+ * @param  context Pendulum under test
+ * @retval None
+ **********************************************************/
+template <class PendulumType>
+static void ReadState(void *context)
+{
+  PendulumType *pendulum = (PendulumType *)context;
+  uint64_t now = simulator.GetTime();
+  if (now >= streamEnd)
+  {
+    return;
+  }
+
+  double time = (double)(now - streamStart) / Sim_Ticks_Per_Second;
+  double step = (time - lastTime) / Bench_Integration_Steps;
+  for (uint8_t i = 0; i < Bench_Integration_Steps; i++)
+  {
+    trueAngle += generator.GetRate(lastTime + (i + 0.5) * step) * step * countsPerEdge * radiansPerCount;
+  }
+  lastTime = time;
+
+  if (time >= Bench_Settle_Seconds)
+  {
+    double velocity = generator.GetRate(time) * countsPerEdge * radiansPerCount;
+    double acceleration = (generator.GetRate(time + 1.0e-4) - generator.GetRate(time - 1.0e-4)) / 2.0e-4 *
+                          countsPerEdge * radiansPerCount;
+    double angle = startAngle + trueAngle;
+    double iirError = pendulum->GetCurrentVelocityRad() - velocity;
+    double observedError = pendulum->GetObservedVelocityRad() - velocity;
+    double countError = WrapAngle(pendulum->GetCurrentPositionRad() - angle);
+    double interpolatedError = WrapAngle(pendulum->GetInterpolatedStateRad().position - angle);
+    double positionError = WrapAngle(pendulum->GetObservedPositionRad() - angle);
+    double accelerationError = pendulum->GetObservedAccelerationRad() - acceleration;
+
+    error.countPosition += countError * countError;
+    error.interpolatedPosition += interpolatedError * interpolatedError;
+    error.observedPosition += positionError * positionError;
+    error.iirVelocity += iirError * iirError;
+    error.observedVelocity += observedError * observedError;
+    error.maxIirVelocity = fabs(iirError) > error.maxIirVelocity ? fabs(iirError) : error.maxIirVelocity;
+    error.maxObservedVelocity = fabs(observedError) > error.maxObservedVelocity ? fabs(observedError) : error.maxObservedVelocity;
+    error.observedAcceleration += accelerationError * accelerationError;
+    error.trueAcceleration += acceleration * acceleration;
+    error.readings++;
+  }
+  simulator.ScheduleIn((uint64_t)Bench_Read_Period_Us * Sim_Ticks_Per_Us, ReadState<PendulumType>, context);
+}
+
+/******************************************************//**
+ * @brief  Plays one stream with the observer at one bandwidth and
+ * prints the RMS errors
+ * @param  pendulum Pendulum under test
+ * @param  name Stream name
+ * @param  config Stream description
+ * @param  bandwidth Observer bandwidth in rad/s
+ * @retval None
+ **********************************************************/
+template <class PendulumType>
+static void Compare(PendulumType *pendulum, const char *name, const edgeStreamConfig_t &config, uint16_t bandwidth)
+{
+  /* Let the previous estimates come to rest so every stream starts from rest */
+  pendulum->SetObserverBandwidth(bandwidth);
+  simulator.RunFor(Sim_Ticks_Per_Second);
+
+  memset(&error, 0, sizeof(error));
+  startAngle = pendulum->GetCurrentPositionRad();
+  trueAngle = 0.0;
+  lastTime = 0.0;
+  streamStart = simulator.GetTime();
+  streamEnd = streamStart + (uint64_t)(config.duration * Sim_Ticks_Per_Second);
+  simulator.ScheduleIn(0, ReadState<PendulumType>, pendulum);
+  edgeStreamResult_t result = generator.Run(config);
+
+  double readings = error.readings ? error.readings : 1;
+  printf("  %-18s %4u rad/s  angle %7.4f / %7.4f / %7.4f  velocity %7.3f / %7.3f  max %7.3f / %7.3f  accel %8.2f of %8.2f  load %5.1f%%\n",
+         name, bandwidth, sqrt(error.countPosition / readings), sqrt(error.interpolatedPosition / readings),
+         sqrt(error.observedPosition / readings),
+         sqrt(error.iirVelocity / readings), sqrt(error.observedVelocity / readings),
+         error.maxIirVelocity, error.maxObservedVelocity, sqrt(error.observedAcceleration / readings),
+         sqrt(error.trueAcceleration / readings), result.cpuLoad * 100.0);
+}
+
+/******************************************************//**
+ * @brief  Runs every stream at each bandwidth
+ * @param  target Pendulum under test, started in the decode mode and
+ * timestamp clock of the suite
+ * @param  bandwidths Observer bandwidths in rad/s
+ * @param  count Number of bandwidths
+ * @retval None
+ **********************************************************/
+template <class PendulumType>
+static void RunSuite(PendulumType &target, const uint16_t *bandwidths, uint8_t count)
+{
+  QuadratureEncoder *encoder = QuadratureEncoder::GetInstancePtr();
+  edgeStreamConfig_t config;
+
+  target.Begin();
+  countsPerEdge = encoder->GetDecodeMode() / 4.0;
+  radiansPerCount = TWO_PI / encoder->GetPulsesPerRotation();
+  printf("%ux decoding, %s timestamps, observer update every %.3f ms\n", (unsigned)encoder->GetDecodeMode(),
+         encoder->GetTimestampSource() == TIMESTAMP_TIMER2 ? "Timer 2" : "micros()",
+         1000.0 * encoder->GetObserverPeriod() / encoder->GetTimestampsPerSecond());
+  printf("  RMS error: angle in rad (count / interpolated / observer), velocity in rad/s (IIR / observer), acceleration in rad/s^2\n");
+
+  config.rate1 = 0.0;
+  config.jitter = 0.1;
+  config.glitchRate = 0.0;
+  config.glitchNs = 0;
+  config.seed = 7;
+  for (uint8_t i = 0; i < count; i++)
+  {
+    /* A fast swing through the bottom and a small one near the top */
+    config.profile = EDGE_PROFILE_SINE;
+    config.rate0 = 4.0 * 300;
+    config.period = 1.1;
+    config.duration = 4.4;
+    Compare(&target, "swing +-300 pps", config, bandwidths[i]);
+
+    config.rate0 = 4.0 * 40;
+    config.period = 2.0;
+    config.duration = 4.0;
+    Compare(&target, "swing +-40 pps", config, bandwidths[i]);
+
+    config.profile = EDGE_PROFILE_RAMP;
+    config.rate0 = 4.0 * 20;
+    config.rate1 = 4.0 * 400;
+    config.duration = 4.0;
+    Compare(&target, "ramp 20-400 pps", config, bandwidths[i]);
+
+    config.profile = EDGE_PROFILE_CONSTANT;
+    config.rate0 = 4.0 * 2000;
+    config.rate1 = 0.0;
+    config.duration = 2.0;
+    Compare(&target, "2000 pps", config, bandwidths[i]);
+  }
+}
+
+/******************************************************//**
+ * @brief  Times the step clock handler with and without the
+ * observer. With micros() timestamps every step runs an update.
+ * @param  target Pendulum started with micros() timestamps
+ * @retval None
+ **********************************************************/
+static void TimeUpdate(PendulumBase &target)
+{
+  uint64_t nanos[2];
+
+  target.Begin();
+  for (uint8_t enabled = 0; enabled < 2; enabled++)
+  {
+    target.SetObserverBandwidth(enabled ? 20 : 0);
+    uint64_t start = HostWallClockNanos();
+    for (unsigned long i = 0; i < Bench_Iterations; i++)
+    {
+      HostRaiseInterrupt(HOST_VECT_TIMER2_COMPA);
+    }
+    nanos[enabled] = HostWallClockNanos() - start;
+  }
+
+  printf("Observer update: %u cycles modelled on the target, %.1f ns on the host\n",
+         generator.GetIsrCost().observer, (double)(nanos[1] - nanos[0]) / Bench_Iterations);
+}
+
+int main()
+{
+  static const uint16_t slowBandwidths[] = {10, 20, 40};
+  static const uint16_t fastBandwidths[] = {30, 60, 120};
+
+  simulator.Begin();
+  generator.Begin(&simulator);
+
+  Pendulum<Bench_Encoder_Ppr, DECODE_1X> slow(TIMESTAMP_MICROS);
+  RunSuite(slow, slowBandwidths, sizeof(slowBandwidths) / sizeof(slowBandwidths[0]));
+  Pendulum<Bench_Encoder_Ppr, DECODE_4X> fast(TIMESTAMP_TIMER2);
+  RunSuite(fast, fastBandwidths, sizeof(fastBandwidths) / sizeof(fastBandwidths[0]));
+
+  generator.End();
+  simulator.End();
+
+  Pendulum<Bench_Encoder_Ppr, DECODE_1X> timed(TIMESTAMP_MICROS);
+  TimeUpdate(timed);
+  return 0;
+}
@@ -0,0 +1,177 @@
+/******************************************************//**
+ * @file    benchSpi.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   SPI traffic of the L6474 driver API measured against
+ *          the register-level L6474 model: bursts and bytes per
+ *          call, bus time at 4MHz and the traffic a move generates
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "l6474Model.h"
+#include <stdio.h>
+
+#define Bench_Calls (10000UL)
+
+/// API call under measurement
+typedef enum {
+  CALL_GET_ABS_POS = 0,
+  CALL_GET_STEP_MODE,
+  CALL_GET_CONFIG,
+  CALL_SET_ABS_POS,
+  CALL_SET_TVAL,
+  CALL_GET_STATUS,
+  CALL_ENABLE,
+  CALL_GET_POSITION,
+  CALL_COUNT
+} benchCall_t;
+
+static const char *callNames[CALL_COUNT] = {
+  "CmdGetParam(ABS_POS)", "CmdGetParam(STEP_MODE)", "CmdGetParam(CONFIG)",
+  "CmdSetParam(ABS_POS)", "CmdSetParam(TVAL)", "CmdGetStatus",
+  "CmdEnable", "GetPosition"
+};
+
+static HostSimulator simulator;
+static L6474Model model;
+static L6474 driver;
+static volatile uint32_t sink;
+
+/******************************************************//**
+ * @brief  Issues one driver API call
+ * @param  call Call to issue
+ * @param  shieldId Shield addressed
+ * @retval None
+ **********************************************************/
+static void Issue(benchCall_t call, uint8_t shieldId)
+{
+  switch (call)
+  {
+    case CALL_GET_ABS_POS:   sink = driver.CmdGetParam(shieldId, L6474_ABS_POS); break;
+    case CALL_GET_STEP_MODE: sink = driver.CmdGetParam(shieldId, L6474_STEP_MODE); break;
+    case CALL_GET_CONFIG:    sink = driver.CmdGetParam(shieldId, L6474_CONFIG); break;
+    case CALL_SET_ABS_POS:   driver.CmdSetParam(shieldId, L6474_ABS_POS, 0x1234); break;
+    case CALL_SET_TVAL:      driver.CmdSetParam(shieldId, L6474_TVAL, 0x20); break;
+    case CALL_GET_STATUS:    sink = driver.CmdGetStatus(shieldId); break;
+    case CALL_ENABLE:        driver.CmdEnable(shieldId); break;
+    default:                 sink = driver.GetPosition(shieldId); break;
+  }
+}
+
+/******************************************************//**
+ * @brief  Measures every API call on one shield of the chain
+ * @param  nbShields Length of the daisy chain
+ * @param  shieldId Shield addressed
+ * @retval None
+ **********************************************************/
+static void CallTable(uint8_t nbShields, uint8_t shieldId)
+{
+  printf("%u shield(s), shield %u\n", nbShields, shieldId);
+  printf("  %-24s %7s %6s %8s %9s\n", "call", "bursts", "bytes", "bus us", "host ns");
+  for (uint8_t call = 0; call < CALL_COUNT; call++)
+  {
+    model.ResetSpiStats();
+    uint64_t start = HostWallClockNanos();
+    for (unsigned long i = 0; i < Bench_Calls; i++)
+    {
+      Issue((benchCall_t)call, shieldId);
+    }
+    uint64_t nanos = HostWallClockNanos() - start;
+    l6474ModelSpiStats_t totals = model.GetSpiTotals();
+    double bursts = (double)totals.bursts / Bench_Calls;
+    double bytes = (double)totals.bytes / Bench_Calls;
+    printf("  %-24s %7.1f %6.1f %8.1f %9.1f\n", callNames[call], bursts, bytes,
+           bytes * L6474_Model_Spi_Byte_Ns / 1000.0, (double)nanos / Bench_Calls);
+  }
+  if (model.GetChainErrors() != 0)
+  {
+    printf("  %lu bursts did not match the chain length\n", (unsigned long)model.GetChainErrors());
+  }
+}
+
+/******************************************************//**
+ * @brief  Checks the register round trip through the chain:
+ * each shield gets a different value and must read back its own
+ * @param  nbShields Length of the daisy chain
+ * @retval None
+ **********************************************************/
+static void RoundTrip(uint8_t nbShields)
+{
+  uint8_t failures = 0;
+  for (uint8_t shieldId = 0; shieldId < nbShields; shieldId++)
+  {
+    driver.CmdSetParam(shieldId, L6474_MARK, 0x1000 + shieldId);
+  }
+  for (uint8_t shieldId = 0; shieldId < nbShields; shieldId++)
+  {
+    if (model.GetRegister(shieldId, L6474_MARK) != 0x1000U + shieldId ||
+        driver.CmdGetParam(shieldId, L6474_MARK) != 0x1000U + shieldId)
+    {
+      failures++;
+    }
+  }
+  printf("  MARK round trip through the chain: %s\n", failures == 0 ? "ok" : "FAILED");
+}
+
+/******************************************************//**
+ * @brief  Runs a move on shield 0 and reports the SPI traffic
+ * the step clock handler generates while it checks ABS_POS
+ * @param  steps Number of steps to move
+ * @retval None
+ **********************************************************/
+static void MoveTraffic(uint32_t steps)
+{
+  driver.SetHome(0);
+  model.ResetSpiStats();
+  uint32_t stepsBefore = model.GetStepCount(0);
+  uint64_t start = simulator.GetTime();
+
+  driver.Move(0, FORWARD, steps);
+  while (driver.GetShieldState(0) != INACTIVE && simulator.GetTime() - start < 60ULL * Sim_Ticks_Per_Second)
+  {
+    simulator.RunFor(Sim_Ticks_Per_Ms);
+  }
+
+  uint32_t stepped = model.GetStepCount(0) - stepsBefore;
+  l6474ModelSpiStats_t getParam = model.GetSpiStats(MODEL_CMD_GET_PARAM);
+  l6474ModelSpiStats_t totals = model.GetSpiTotals();
+  double seconds = (double)(simulator.GetTime() - start) / Sim_Ticks_Per_Second;
+
+  printf("  move %lu steps: %lu STEP pulses, ABS_POS %ld, GetPosition %ld\n",
+         (unsigned long)steps, (unsigned long)stepped, (long)model.GetPosition(0), (long)driver.GetPosition(0));
+  printf("  %lu GET_PARAM calls (%.3f per step), %lu bytes, %.2f bytes/step, bus busy %.3f%% of %.3f s\n",
+         (unsigned long)getParam.calls, (double)getParam.calls / stepped, (unsigned long)totals.bytes,
+         (double)totals.bytes / stepped, 100.0 * totals.bytes * L6474_Model_Spi_Byte_Ns / (seconds * 1.0e9), seconds);
+}
+
+int main()
+{
+  simulator.Begin();
+  model.AttachToSimulator(&simulator);
+
+  model.Begin(1);
+  driver.Begin(1);
+  CallTable(1, 0);
+  RoundTrip(1);
+
+  model.Begin(3);
+  driver.Begin(3);
+  CallTable(3, 0);
+  CallTable(3, 2);
+  RoundTrip(3);
+
+  model.Begin(1);
+  driver.Begin(1);
+  printf("Step clock traffic\n");
+  MoveTraffic(200);
+  MoveTraffic(4000);
+
+  model.End();
+  simulator.End();
+  return 0;
+}
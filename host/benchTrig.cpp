@@ -0,0 +1,198 @@
+/******************************************************//**
+ * @file    benchTrig.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Flash cosine table and swing energy estimate of the
+ *          Pendulum library: table accuracy per decode mode, host
+ *          cost of a table read against cos(), and the Q16 energy
+ *          along a free swing of the cart-pendulum plant against
+ *          the plant energy
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "cartPendulumPlant.h"
+#include "pendulum.h"
+#include <stdio.h>
+
+#define Bench_Iterations     (1000000UL)
+
+/// Free swing: release angle from upright, swing length and sample period
+#define Bench_Release_Deg    (30.0)
+#define Bench_Swing_Seconds  (5)
+#define Bench_Sample_Ms      (5)
+
+typedef Pendulum<360, DECODE_1X> slowPendulum_t;
+typedef Pendulum<360, DECODE_4X> fastPendulum_t;
+
+static HostSimulator simulator;
+static L6474Model model;
+static CartPendulumPlant plant;
+static fastPendulum_t pendulum(TIMESTAMP_TIMER2);
+static volatile float floatSink;
+static volatile int32_t fixedSink;
+
+/******************************************************//**
+ * @brief  Prints one benchmark result line
+ * @param  name Benchmark name
+ * @param  nanos Elapsed wall time in nanoseconds
+ * @param  count Number of operations timed
+ * @retval None
+ **********************************************************/
+static void Report(const char *name, uint64_t nanos, unsigned long count)
+{
+  printf("  %-34s %10lu ops %9.1f ns/op\n", name, count, (double)nanos / (double)count);
+}
+
+/******************************************************//**
+ * @brief  Compares every table entry of one resolution with
+ * cos() and sin()
+ * @param  name Decode mode name
+ * @retval None
+ **********************************************************/
+template <class PendulumType>
+static void CheckTable(const char *name)
+{
+  double cosError = 0.0;
+  double sinError = 0.0;
+  for (uint16_t i = 0; i < PendulumType::CountsPerRotation(); i++)
+  {
+    double angle = TWO_PI * i / PendulumType::CountsPerRotation();
+    double error = fabs(PendulumType::CosQ15(i) / (double)Trig_Table_One - cos(angle));
+    cosError = error > cosError ? error : cosError;
+    error = fabs(PendulumType::SinQ15(i) / (double)Trig_Table_One - sin(angle));
+    sinError = error > sinError ? error : sinError;
+  }
+  printf("  %-3s %5u entries %5u bytes of flash  max error cos %.1e  sin %.1e\n", name,
+         PendulumType::CountsPerRotation(), (unsigned)(PendulumType::CountsPerRotation() * sizeof(int16_t)),
+         cosError, sinError);
+}
+
+/******************************************************//**
+ * @brief  Times cos() against the table, and the energy from the
+ * float state and cos() against GetEnergyQ16
+ * @param  naturalFrequency sqrt(g/l) in rad/s
+ * @retval None
+ **********************************************************/
+static void TimeCalls(double naturalFrequency)
+{
+  uint64_t start;
+  unsigned long i;
+  uint16_t counts = fastPendulum_t::CountsPerRotation();
+  float frequencySquared = (float)(naturalFrequency * naturalFrequency);
+
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    floatSink = cos((double)(i % counts) * fastPendulum_t::RadiansPerCount());
+  }
+  Report("cos(), double", HostWallClockNanos() - start, Bench_Iterations);
+
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    floatSink = cosf((float)(i % counts) * fastPendulum_t::RadiansPerCount());
+  }
+  Report("cosf(), float", HostWallClockNanos() - start, Bench_Iterations);
+
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    fixedSink = fastPendulum_t::CosQ15(i % counts);
+  }
+  Report("Pendulum::CosQ15 table read", HostWallClockNanos() - start, Bench_Iterations);
+
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    pendulumState_t state = pendulum.GetUprightStateRad();
+    floatSink = 0.5f * state.velocity * state.velocity + frequencySquared * (cosf(state.position) - 1.0f);
+  }
+  Report("energy, float state and cosf()", HostWallClockNanos() - start, Bench_Iterations);
+
+  start = HostWallClockNanos();
+  for (i = 0; i < Bench_Iterations; i++)
+  {
+    fixedSink = pendulum.GetEnergyQ16().Raw();
+  }
+  Report("Pendulum::GetEnergyQ16", HostWallClockNanos() - start, Bench_Iterations);
+}
+
+/******************************************************//**
+ * @brief  Releases the pendulum near upright and compares the
+ * energy estimates with the plant energy while it swings freely
+ * @param  naturalFrequency sqrt(g/l) in rad/s
+ * @retval None
+ **********************************************************/
+static void FreeSwing(double naturalFrequency)
+{
+  double frequencySquared = naturalFrequency * naturalFrequency;
+  double sumFixed = 0.0;
+  double sumFloat = 0.0;
+  double maxFixed = 0.0;
+  uint32_t samples = (uint32_t)Bench_Swing_Seconds * 1000 / Bench_Sample_Ms;
+
+  /* Hold the pendulum still long enough for the encoder speed estimate to clear. It is placed
+   * again every millisecond, so it never falls far enough to produce an edge while held. */
+  for (uint8_t i = 0; i < 100; i++)
+  {
+    plant.SetPendulum(PI + Bench_Release_Deg * DEG_TO_RAD, 0.0);
+    simulator.RunFor(Sim_Ticks_Per_Ms);
+  }
+  plant.SetPendulum(PI + Bench_Release_Deg * DEG_TO_RAD, 0.0);
+  double startEnergy = frequencySquared * (cos(Bench_Release_Deg * DEG_TO_RAD) - 1.0);
+
+  double plantEnergy = startEnergy;
+  for (uint32_t i = 0; i < samples; i++)
+  {
+    simulator.RunFor((uint64_t)Bench_Sample_Ms * Sim_Ticks_Per_Ms);
+    double velocity = plant.GetAngularVelocity();
+    plantEnergy = 0.5 * velocity * velocity + frequencySquared * (cos(plant.GetAngleFromUpright()) - 1.0);
+
+    pendulumState_t state = pendulum.GetUprightStateRad();
+    double floatEnergy = 0.5 * state.velocity * state.velocity + frequencySquared * (cos(state.position) - 1.0);
+    double fixedEnergy = pendulum.GetEnergyQ16().ToFloat();
+
+    sumFloat += (floatEnergy - plantEnergy) * (floatEnergy - plantEnergy);
+    sumFixed += (fixedEnergy - plantEnergy) * (fixedEnergy - plantEnergy);
+    maxFixed = fabs(fixedEnergy - plantEnergy) > maxFixed ? fabs(fixedEnergy - plantEnergy) : maxFixed;
+  }
+
+  printf("  released %.0f deg from upright: plant energy %.3f -> %.3f rad^2/s^2 (hanging %.3f)\n",
+         Bench_Release_Deg, startEnergy, plantEnergy, -2.0 * frequencySquared);
+  printf("  RMS error against the plant: float state and cos() %.4f, GetEnergyQ16 %.4f (peak %.4f)\n",
+         sqrt(sumFloat / samples), sqrt(sumFixed / samples), maxFixed);
+}
+
+int main()
+{
+  simulator.Begin();
+  model.Begin(1);
+  model.AttachToSimulator(&simulator);
+  plant.Begin(&simulator, &model);
+  plantParams_t params = plant.GetParams();
+  double naturalFrequency = sqrt(params.gravity / params.pendulumLength);
+
+  pendulum.Begin<1000 / Bench_Sample_Ms>();
+  pendulum.SetNaturalFrequency(naturalFrequency);
+
+  printf("Cosine table, one entry per count of the 360 PPR encoder\n");
+  CheckTable<slowPendulum_t>("1x");
+  CheckTable<fastPendulum_t>("4x");
+
+  printf("Host cost per call (the target runs cos() in soft-float, see Bench_Pendulum_Getters in firmware.ino)\n");
+  TimeCalls(naturalFrequency);
+
+  printf("Energy per moment of inertia, 4x decoding, natural frequency %.2f rad/s, sampled every %d ms\n",
+         naturalFrequency, Bench_Sample_Ms);
+  FreeSwing(naturalFrequency);
+
+  plant.End();
+  model.End();
+  simulator.End();
+  return 0;
+}
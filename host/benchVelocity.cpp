@@ -0,0 +1,287 @@
+/******************************************************//**
+ * @file    benchVelocity.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Compares the QuadratureEncoder velocity estimators: the
+ *          pulse timing / pulse counting IIR against the M/T method
+ *          and the least-squares edge fit, on edge streams from
+ *          QuadratureEdgeGenerator. Reports the velocity error against
+ *          the true rate and the handler cost, and the lag and noise
+ *          of each estimator on pendulum swings.
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "quadratureEdgeGenerator.h"
+#include "quadratureEncoder.h"
+#include <stdio.h>
+
+/// Encoder on the rig
+#define Bench_Encoder_Ppr       (360)
+
+/// Velocity is read like a 1kHz control loop would, after the estimate settles
+#define Bench_Read_Period_Us    (1000)
+#define Bench_Settle_Seconds    (0.25)
+
+/// Lag search on the swings, readings kept for it
+#define Bench_Max_Lag_Ms        (80.0)
+#define Bench_Lag_Step_Ms       (0.25)
+#define Bench_Max_Readings      (8192)
+
+/// Velocity error of one stream
+typedef struct {
+  double sumError;
+  double sumSquaredError;
+  double maxError;
+  double maxStep;             //Largest change between two consecutive readings
+  int32_t lastVelocity;
+  uint32_t readings;
+} velocityError_t;
+
+static HostSimulator simulator;
+static QuadratureEncoder encoder;
+static QuadratureEdgeGenerator generator;
+static velocityError_t error;
+static uint64_t streamStart;
+static uint64_t streamEnd;
+static double readTime[Bench_Max_Readings];
+static int32_t readVelocity[Bench_Max_Readings];
+static unsigned long windowTimes[Velocity_Max_Window];
+static const char *estimatorNames[] = {"IIR", "M/T", "LSQ"};
+
+/******************************************************//**
+ * @brief  Simulator event reading the velocity and comparing it
+ * with the rate the generator is producing
+ * @param  context Unused
+ * @retval None
+ **********************************************************/
+static void ReadVelocity(void *context)
+{
+  uint64_t now = simulator.GetTime();
+  if (now >= streamEnd)
+  {
+    return;
+  }
+
+  double time = (double)(now - streamStart) / Sim_Ticks_Per_Second;
+  encoderSnapshot_t state = encoder.GetState();
+  int32_t velocity = state.velocity;
+  if (time >= Bench_Settle_Seconds)
+  {
+    if (error.readings < Bench_Max_Readings)
+    {
+      readTime[error.readings] = time;
+      readVelocity[error.readings] = velocity;
+    }
+    /* Four edges per pulse, one count per pulse in 1x and one per edge in 4x */
+    double truth = generator.GetRate(time) / 4.0 * encoder.GetDecodeMode();
+    double difference = velocity - truth;
+    double step = fabs((double)(velocity - error.lastVelocity));
+
+    error.sumError += difference;
+    error.sumSquaredError += difference * difference;
+    error.maxError = fabs(difference) > error.maxError ? fabs(difference) : error.maxError;
+    error.maxStep = step > error.maxStep ? step : error.maxStep;
+    error.readings++;
+  }
+  error.lastVelocity = velocity;
+  simulator.ScheduleIn((uint64_t)Bench_Read_Period_Us * Sim_Ticks_Per_Us, ReadVelocity, context);
+}
+
+/******************************************************//**
+ * @brief  Plays one stream with one estimator and prints the
+ * velocity error and handler cost
+ * @param  name Stream name
+ * @param  config Stream description
+ * @param  estimator Velocity estimator under test
+ * @retval None
+ **********************************************************/
+static void Compare(const char *name, const edgeStreamConfig_t &config, velocityEstimator_t estimator)
+{
+  /* Let the previous estimate time out so every stream starts from rest */
+  encoder.SetVelocityEstimator(estimator);
+  simulator.RunFor(Sim_Ticks_Per_Second);
+
+  memset(&error, 0, sizeof(error));
+  streamStart = simulator.GetTime();
+  streamEnd = streamStart + (uint64_t)(config.duration * Sim_Ticks_Per_Second);
+  simulator.ScheduleIn(0, ReadVelocity, NULL);
+  edgeStreamResult_t result = generator.Run(config);
+
+  double mean = error.readings ? error.sumError / error.readings : 0.0;
+  double rms = error.readings ? sqrt(error.sumSquaredError / error.readings) : 0.0;
+  printf("  %-20s %-4s mean %8.2f  rms %8.2f  max %8.1f  max step %7.1f  load %5.1f%%  isr %5.1f us  host %6.1f ns\n",
+         name, estimatorNames[estimator], mean, rms, error.maxError, error.maxStep,
+         result.cpuLoad * 100.0, result.isrTargetUs, result.isrHostNs);
+}
+
+/******************************************************//**
+ * @brief  Runs every stream with every estimator
+ * @param  mode Decode mode given to QuadratureEncoder::Begin
+ * @param  source Timestamp clock given to QuadratureEncoder::Begin
+ * @param  timerConfig Sample rate given to QuadratureEncoder::Begin
+ * @param  rateHz Sample rate of timerConfig, for the heading
+ * @retval None
+ **********************************************************/
+static void RunSuite(decodeMode_t mode, timestampSource_t source, sampleTimerConfig_t timerConfig, uint16_t rateHz)
+{
+  static const uint16_t rates[] = {20, 60, 120, 130, 140, 200, 500, 2000};
+  char name[32];
+  edgeStreamConfig_t config;
+
+  encoder.Begin(Bench_Encoder_Ppr, mode, source, timerConfig);
+  encoder.SetVelocityWindow(Velocity_Max_Window, windowTimes);
+  printf("%ux decoding, %s timestamps, %u Hz samples, velocity error in counts/s\n", (unsigned)mode,
+         source == TIMESTAMP_TIMER2 ? "Timer 2" : "micros()", (unsigned)rateHz);
+
+  config.profile = EDGE_PROFILE_CONSTANT;
+  config.rate1 = 0.0;
+  config.period = 1.0;
+  config.duration = 2.0;
+  config.jitter = 0.1;
+  config.glitchRate = 0.0;
+  config.glitchNs = 0;
+  config.seed = 7;
+  for (uint8_t i = 0; i < sizeof(rates) / sizeof(rates[0]); i++)
+  {
+    config.rate0 = 4.0 * rates[i];
+    snprintf(name, sizeof(name), "%u pps", rates[i]);
+    Compare(name, config, VELOCITY_IIR);
+    Compare(name, config, VELOCITY_MT);
+    Compare(name, config, VELOCITY_LSQ);
+  }
+
+  /* Accelerate through the IIR switching threshold */
+  config.profile = EDGE_PROFILE_RAMP;
+  config.rate0 = 4.0 * 20;
+  config.rate1 = 4.0 * 400;
+  config.duration = 4.0;
+  Compare("ramp 20-400 pps", config, VELOCITY_IIR);
+  Compare("ramp 20-400 pps", config, VELOCITY_MT);
+  Compare("ramp 20-400 pps", config, VELOCITY_LSQ);
+
+  /* A swing: reverses through zero twice a period */
+  config.profile = EDGE_PROFILE_SINE;
+  config.rate0 = 4.0 * 300;
+  config.period = 1.1;
+  config.duration = 4.4;
+  Compare("swing +-300 pps", config, VELOCITY_IIR);
+  Compare("swing +-300 pps", config, VELOCITY_MT);
+  Compare("swing +-300 pps", config, VELOCITY_LSQ);
+}
+
+/******************************************************//**
+ * @brief  Plays a swing and finds the delay of the true rate that
+ * the readings follow best. The error left at that delay is the
+ * noise of the estimator, the delay its lag.
+ * @param  name Stream name
+ * @param  config Sine stream description
+ * @param  estimator Velocity estimator under test
+ * @param  window Edges of the least-squares fit
+ * @retval None
+ **********************************************************/
+static void SwingLag(const char *name, const edgeStreamConfig_t &config, velocityEstimator_t estimator, uint8_t window)
+{
+  double countsPerEdge = encoder.GetDecodeMode() / 4.0;
+  double bestSum = -1.0;
+  double bestLag = 0.0;
+  char label[16];
+
+  encoder.SetVelocityWindow(window, windowTimes);
+  encoder.SetVelocityEstimator(estimator);
+  simulator.RunFor(Sim_Ticks_Per_Second);
+  memset(&error, 0, sizeof(error));
+  streamStart = simulator.GetTime();
+  streamEnd = streamStart + (uint64_t)(config.duration * Sim_Ticks_Per_Second);
+  simulator.ScheduleIn(0, ReadVelocity, NULL);
+  generator.Run(config);
+
+  uint32_t readings = error.readings < Bench_Max_Readings ? error.readings : Bench_Max_Readings;
+  for (double lag = 0.0; lag <= Bench_Max_Lag_Ms; lag += Bench_Lag_Step_Ms)
+  {
+    double sum = 0.0;
+    for (uint32_t i = 0; i < readings; i++)
+    {
+      double difference = readVelocity[i] - generator.GetRate(readTime[i] - lag * 1.0e-3) * countsPerEdge;
+      sum += difference * difference;
+    }
+    if (bestSum < 0.0 || sum < bestSum)
+    {
+      bestSum = sum;
+      bestLag = lag;
+    }
+  }
+
+  if (estimator == VELOCITY_LSQ)
+  {
+    snprintf(label, sizeof(label), "LSQ %u", window);
+  }
+  else
+  {
+    snprintf(label, sizeof(label), "%s", estimatorNames[estimator]);
+  }
+  printf("  %-20s %-6s lag %5.2f ms  noise %7.2f counts/s\n", name, label, bestLag, sqrt(bestSum / readings));
+}
+
+/******************************************************//**
+ * @brief  Swings of several amplitudes, each through every
+ * estimator and least-squares windows of 4, 8 and 16 edges
+ * @param  mode Decode mode given to QuadratureEncoder::Begin
+ * @param  source Timestamp clock given to QuadratureEncoder::Begin
+ * @retval None
+ **********************************************************/
+static void RunSwings(decodeMode_t mode, timestampSource_t source)
+{
+  static const uint16_t amplitudes[] = {60, 150, 300, 600};
+  static const uint8_t windows[] = {4, 8, 16};
+  char name[32];
+  edgeStreamConfig_t config;
+
+  encoder.Begin(Bench_Encoder_Ppr, mode, source);
+  printf("%ux decoding, %s timestamps, lag and noise on swings, 1.1 s period\n", (unsigned)mode,
+         source == TIMESTAMP_TIMER2 ? "Timer 2" : "micros()");
+
+  config.profile = EDGE_PROFILE_SINE;
+  config.rate1 = 0.0;
+  config.period = 1.1;
+  config.duration = 4.4;
+  config.jitter = 0.1;
+  config.glitchRate = 0.0;
+  config.glitchNs = 0;
+  config.seed = 7;
+  for (uint8_t i = 0; i < sizeof(amplitudes) / sizeof(amplitudes[0]); i++)
+  {
+    config.rate0 = 4.0 * amplitudes[i];
+    snprintf(name, sizeof(name), "swing +-%u pps", amplitudes[i]);
+    SwingLag(name, config, VELOCITY_IIR, Velocity_Max_Window);
+    SwingLag(name, config, VELOCITY_MT, Velocity_Max_Window);
+    for (uint8_t j = 0; j < sizeof(windows) / sizeof(windows[0]); j++)
+    {
+      SwingLag(name, config, VELOCITY_LSQ, windows[j]);
+    }
+  }
+}
+
+int main()
+{
+  simulator.Begin();
+  generator.Begin(&simulator);
+
+  RunSuite(DECODE_1X, TIMESTAMP_MICROS, SampleTimer<Sample_Timer_Default_Hz>::Config(), Sample_Timer_Default_Hz);
+  RunSuite(DECODE_4X, TIMESTAMP_TIMER2, SampleTimer<Sample_Timer_Default_Hz>::Config(), Sample_Timer_Default_Hz);
+  /* The sample rates of a control loop */
+  RunSuite(DECODE_1X, TIMESTAMP_MICROS, SampleTimer<500>::Config(), 500);
+  RunSuite(DECODE_4X, TIMESTAMP_TIMER2, SampleTimer<500>::Config(), 500);
+  RunSuite(DECODE_1X, TIMESTAMP_MICROS, SampleTimer<1000>::Config(), 1000);
+  RunSuite(DECODE_4X, TIMESTAMP_TIMER2, SampleTimer<1000>::Config(), 1000);
+  RunSwings(DECODE_1X, TIMESTAMP_MICROS);
+  RunSwings(DECODE_4X, TIMESTAMP_TIMER2);
+
+  generator.End();
+  simulator.End();
+  return 0;
+}
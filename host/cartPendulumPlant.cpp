@@ -0,0 +1,354 @@
+/******************************************************//**
+ * @file    cartPendulumPlant.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Rigid-body model of the cart and pendulum for the host
+ *          simulator
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "cartPendulumPlant.h"
+#include "quadratureEncoder.h"
+#include <math.h>
+
+/******************************************************//**
+ * @brief  Constructor for the plant, loads the default rig
+ * @param  None
+ * @retval None
+ **********************************************************/
+CartPendulumPlant::CartPendulumPlant()
+{
+  params.pendulumLength = Plant_Pendulum_Length_M;
+  params.damping = Plant_Damping_Per_S;
+  params.gravity = Plant_Gravity_M_S2;
+  params.metersPerStep = Plant_Meters_Per_Step;
+  params.pulsesPerRotation = Plant_Pulses_Per_Rotation;
+  params.tickUs = Plant_Tick_Us;
+  simulator = NULL;
+  model = NULL;
+  running = false;
+  angle = 0.0;
+  angularVelocity = 0.0;
+  cartSteps = 0;
+  cartVelocity = 0.0;
+  pendingDeltaV = 0.0;
+  lastStepTime = 0;
+  lastStepInterval = 0;
+  lastStepDirection = 0;
+  encoderEdges = 0;
+  ResetMetrics(0.0);
+}
+
+/******************************************************//**
+ * @brief  Replaces the physical parameters, call before Begin
+ * @param  newParams Parameters of the rig
+ * @retval None
+ **********************************************************/
+void CartPendulumPlant::SetParams(const plantParams_t &newParams)
+{
+  params = newParams;
+}
+
+/******************************************************//**
+ * @brief  Returns the physical parameters
+ * @param  None
+ * @retval Parameters of the rig
+ **********************************************************/
+plantParams_t CartPendulumPlant::GetParams()
+{
+  return params;
+}
+
+/******************************************************//**
+ * @brief  Starts the plant with the pendulum hanging at rest and
+ * the encoder lines at the 11 rest level. Call Pendulum::Begin
+ * after this so the encoder home is the hanging position.
+ * @param  simulator Simulator the integration runs in
+ * @param  model L6474 model whose shield 0 drives the cart
+ * @retval None
+ **********************************************************/
+void CartPendulumPlant::Begin(HostSimulator *simulator, L6474Model *model)
+{
+  this->simulator = simulator;
+  this->model = model;
+  angle = 0.0;
+  angularVelocity = 0.0;
+  cartSteps = 0;
+  cartVelocity = 0.0;
+  pendingDeltaV = 0.0;
+  lastStepTime = simulator->GetTime();
+  lastStepInterval = 0;
+  lastStepDirection = 0;
+  encoderEdges = 0;
+  HostSetPinLevel(Quadrature_Pendulum_B_Pin, HIGH);
+  HostSetPinLevel(Quadrature_Pendulum_A_Pin, HIGH);
+
+  model->AttachStepHook(StepPulse, this);
+  if (!running)
+  {
+    running = true;
+    simulator->ScheduleIn((uint64_t)params.tickUs * Sim_Ticks_Per_Us, Tick, this);
+  }
+  ResetMetrics(settlingBand);
+}
+
+/******************************************************//**
+ * @brief  Stops the integration and the STEP pulse listening
+ * @param  None
+ * @retval None
+ **********************************************************/
+void CartPendulumPlant::End()
+{
+  running = false;
+  if (model != NULL)
+  {
+    model->AttachStepHook(NULL, NULL);
+  }
+}
+
+/******************************************************//**
+ * @brief  Places the pendulum by hand. The encoder edges for the
+ * move are produced at once.
+ * @param  newAngle Angle from hanging in radians (CCW is +)
+ * @param  newVelocity Angular velocity in radians/s
+ * @retval None
+ **********************************************************/
+void CartPendulumPlant::SetPendulum(double newAngle, double newVelocity)
+{
+  angle = newAngle;
+  angularVelocity = newVelocity;
+  UpdateEncoder();
+}
+
+/******************************************************//**
+ * @brief  Returns the pendulum angle from hanging, unwrapped
+ * @param  None
+ * @retval angle in radians (CCW is +)
+ **********************************************************/
+double CartPendulumPlant::GetAngle()
+{
+  return angle;
+}
+
+/******************************************************//**
+ * @brief  Returns the pendulum angle from upright
+ * @param  None
+ * @retval angle in radians in (-pi, pi]
+ **********************************************************/
+double CartPendulumPlant::GetAngleFromUpright()
+{
+  double error = fmod(angle - M_PI, 2.0 * M_PI);
+  if (error > M_PI)
+  {
+    error -= 2.0 * M_PI;
+  }
+  else if (error <= -M_PI)
+  {
+    error += 2.0 * M_PI;
+  }
+  return error;
+}
+
+/******************************************************//**
+ * @brief  Returns the pendulum angular velocity
+ * @param  None
+ * @retval velocity in radians/s (CCW is +)
+ **********************************************************/
+double CartPendulumPlant::GetAngularVelocity()
+{
+  return angularVelocity;
+}
+
+/******************************************************//**
+ * @brief  Returns the cart position
+ * @param  None
+ * @retval position in meters from the start (FORWARD is +)
+ **********************************************************/
+double CartPendulumPlant::GetCartPosition()
+{
+  return cartSteps * params.metersPerStep;
+}
+
+/******************************************************//**
+ * @brief  Returns the cart velocity
+ * @param  None
+ * @retval velocity in m/s (FORWARD is +)
+ **********************************************************/
+double CartPendulumPlant::GetCartVelocity()
+{
+  return cartVelocity;
+}
+
+/******************************************************//**
+ * @brief  Returns the number of quadrature edges produced
+ * @param  None
+ * @retval signed edge count, four per encoder pulse
+ **********************************************************/
+int32_t CartPendulumPlant::GetEncoderEdges()
+{
+  return encoderEdges;
+}
+
+/******************************************************//**
+ * @brief  Restarts the balance loop metrics
+ * @param  band Angle from upright in radians the pendulum must
+ * stay within to count as settled
+ * @retval None
+ **********************************************************/
+void CartPendulumPlant::ResetMetrics(double band)
+{
+  settlingBand = band;
+  metricsStart = simulator != NULL ? simulator->GetTime() : 0;
+  lastOutsideBand = metricsStart;
+  outsideBand = false;
+  sumSquaredError = 0.0;
+  maxAngleError = 0.0;
+  metricsCartSteps = cartSteps;
+  maxCartSteps = 0;
+  samples = 0;
+}
+
+/******************************************************//**
+ * @brief  Returns the balance loop metrics since ResetMetrics
+ * @param  None
+ * @retval settling time, RMS and peak angle error, cart excursion
+ **********************************************************/
+plantMetrics_t CartPendulumPlant::GetMetrics()
+{
+  plantMetrics_t metrics;
+  metrics.settlingTime = outsideBand ? -1.0 : (double)(lastOutsideBand - metricsStart) / Sim_Ticks_Per_Second;
+  metrics.rmsAngleError = samples != 0 ? sqrt(sumSquaredError / samples) : 0.0;
+  metrics.maxAngleError = maxAngleError;
+  metrics.maxCartExcursion = maxCartSteps * params.metersPerStep;
+  metrics.samples = samples;
+  return metrics;
+}
+
+/******************************************************//**
+ * @brief  Advances the pendulum by one integration step with
+ * semi-implicit Euler. Cart velocity changes are applied as
+ * impulses since the stepper moves the cart kinematically:
+ * theta'' = -(g/l)sin(theta) - b*theta' + (x''/l)cos(theta)
+ * @param  None
+ * @retval None
+ **********************************************************/
+void CartPendulumPlant::Integrate()
+{
+  double dt = params.tickUs * 1.0e-6;
+  uint64_t now = simulator->GetTime();
+
+  /* The cart stops when the step train stops */
+  uint64_t timeout = lastStepInterval * 2;
+  if (timeout == 0 || timeout > (uint64_t)Plant_Step_Timeout_Us * Sim_Ticks_Per_Us)
+  {
+    timeout = (uint64_t)Plant_Step_Timeout_Us * Sim_Ticks_Per_Us;
+  }
+  if (cartVelocity != 0.0 && now - lastStepTime > timeout)
+  {
+    pendingDeltaV -= cartVelocity;
+    cartVelocity = 0.0;
+  }
+
+  angularVelocity += (-(params.gravity / params.pendulumLength) * sin(angle) - params.damping * angularVelocity) * dt +
+                     cos(angle) * pendingDeltaV / params.pendulumLength;
+  pendingDeltaV = 0.0;
+  angle += angularVelocity * dt;
+}
+
+/******************************************************//**
+ * @brief  Drives the encoder lines until the edge count matches
+ * the pendulum angle. Edges follow the BA sequence 11, 01, 00, 10
+ * while turning CCW.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void CartPendulumPlant::UpdateEncoder()
+{
+  int32_t target = (int32_t)floor(angle * 4.0 * params.pulsesPerRotation / (2.0 * M_PI));
+  while (encoderEdges != target)
+  {
+    encoderEdges += encoderEdges < target ? 1 : -1;
+    uint8_t phase = encoderEdges & 0x03;
+    HostSetPinLevel(Quadrature_Pendulum_B_Pin, (phase == 0 || phase == 3) ? HIGH : LOW);
+    HostSetPinLevel(Quadrature_Pendulum_A_Pin, (phase == 0 || phase == 1) ? HIGH : LOW);
+  }
+}
+
+/******************************************************//**
+ * @brief  Accumulates the balance loop metrics
+ * @param  None
+ * @retval None
+ **********************************************************/
+void CartPendulumPlant::UpdateMetrics()
+{
+  double error = fabs(GetAngleFromUpright());
+  int32_t excursion = cartSteps - metricsCartSteps;
+  excursion = excursion < 0 ? -excursion : excursion;
+
+  sumSquaredError += error * error;
+  maxAngleError = error > maxAngleError ? error : maxAngleError;
+  maxCartSteps = excursion > maxCartSteps ? excursion : maxCartSteps;
+  outsideBand = error > settlingBand;
+  if (outsideBand)
+  {
+    lastOutsideBand = simulator->GetTime();
+  }
+  samples++;
+}
+
+/******************************************************//**
+ * @brief  Simulator event running one integration step
+ * @param  context CartPendulumPlant instance
+ * @retval None
+ **********************************************************/
+void CartPendulumPlant::Tick(void *context)
+{
+  CartPendulumPlant *plant = (CartPendulumPlant *)context;
+  if (!plant->running)
+  {
+    return;
+  }
+
+  plant->Integrate();
+  plant->UpdateEncoder();
+  plant->UpdateMetrics();
+  plant->simulator->ScheduleIn((uint64_t)plant->params.tickUs * Sim_Ticks_Per_Us, Tick, plant);
+}
+
+/******************************************************//**
+ * @brief  L6474 model hook moving the cart by one step. The cart
+ * velocity is the step length over the last step interval.
+ * @param  deviceId Shield that received the STEP pulse
+ * @param  direction +1 for FORWARD, -1 for BACKWARD
+ * @param  context CartPendulumPlant instance
+ * @retval None
+ **********************************************************/
+void CartPendulumPlant::StepPulse(uint8_t deviceId, int8_t direction, void *context)
+{
+  CartPendulumPlant *plant = (CartPendulumPlant *)context;
+  if (deviceId != 0)
+  {
+    return;
+  }
+
+  uint64_t now = plant->simulator->GetTime();
+  uint64_t interval = now - plant->lastStepTime;
+  uint64_t timeout = (uint64_t)Plant_Step_Timeout_Us * Sim_Ticks_Per_Us;
+  if (direction != plant->lastStepDirection || interval > timeout || interval == 0)
+  {
+    interval = timeout;
+  }
+
+  double newVelocity = direction * plant->params.metersPerStep * Sim_Ticks_Per_Second / (double)interval;
+  plant->pendingDeltaV += newVelocity - plant->cartVelocity;
+  plant->cartVelocity = newVelocity;
+  plant->cartSteps += direction;
+  plant->lastStepInterval = interval;
+  plant->lastStepTime = now;
+  plant->lastStepDirection = direction;
+}
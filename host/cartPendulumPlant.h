@@ -0,0 +1,110 @@
+/******************************************************//**
+ * @file    cartPendulumPlant.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Rigid-body model of the cart and pendulum for the host
+ *          simulator. The cart moves one step per STEP pulse the
+ *          L6474 model receives on shield 0 and the pendulum angle
+ *          is fed back to the firmware as A/B quadrature edges.
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __CART_PENDULUM_PLANT_H_INCLUDED
+#define __CART_PENDULUM_PLANT_H_INCLUDED
+
+#include "l6474Model.h"
+
+/// Default plant: a 30cm pendulum on a belt driven cart (60mm per
+/// motor turn, 1.8 degree motor in 1/4 step mode) read by the 360 PPR LPD3806
+#define Plant_Pendulum_Length_M      (0.30)
+#define Plant_Damping_Per_S          (0.05)
+#define Plant_Gravity_M_S2           (9.81)
+#define Plant_Meters_Per_Step        (0.060 / 800.0)
+#define Plant_Pulses_Per_Rotation    (360)
+#define Plant_Tick_Us                (20)
+
+/// A cart that received no STEP pulse for this long is at rest
+#define Plant_Step_Timeout_Us        (50000)
+
+/// Physical parameters of the rig
+typedef struct {
+  double pendulumLength;       //Effective length I/(m*d) of the pendulum in meters
+  double damping;              //Viscous damping of the pivot in 1/s
+  double gravity;              //Gravity in m/s^2
+  double metersPerStep;        //Cart travel per STEP pulse, positive for FORWARD
+  uint16_t pulsesPerRotation;  //Encoder pulses per rotation, four edges each
+  uint32_t tickUs;             //Integration step in microseconds
+} plantParams_t;
+
+/// Balance loop performance since ResetMetrics
+typedef struct {
+  double settlingTime;         //Seconds until the angle stayed inside the band, negative if it is still outside
+  double rmsAngleError;        //RMS angle from upright in radians
+  double maxAngleError;        //Largest angle from upright in radians
+  double maxCartExcursion;     //Largest distance of the cart from its position at ResetMetrics in meters
+  uint32_t samples;            //Integration steps accumulated
+} plantMetrics_t;
+
+/// CartPendulumPlant library class
+class CartPendulumPlant
+{
+  public:
+    CartPendulumPlant();                                  //Constructor, loads the default parameters
+    void SetParams(const plantParams_t &newParams);       //Replace the physical parameters (before Begin)
+    plantParams_t GetParams();                            //Return the physical parameters
+    void Begin(HostSimulator *simulator, L6474Model *model); //Start integrating and listening to STEP pulses
+    void End();                                           //Stop integrating
+
+    void SetPendulum(double angle, double velocity);      //Place the pendulum (angle from hanging, CCW is +)
+
+    double GetAngle();                                    //Pendulum angle from hanging in radians, unwrapped
+    double GetAngleFromUpright();                         //Pendulum angle from upright in (-pi, pi]
+    double GetAngularVelocity();                          //Pendulum velocity in radians/s
+    double GetCartPosition();                             //Cart position in meters from its start
+    double GetCartVelocity();                             //Cart velocity in m/s estimated from the STEP pulses
+    int32_t GetEncoderEdges();                            //Quadrature edges produced, signed
+
+    void ResetMetrics(double settlingBand);               //Start measuring with an angle band in radians
+    plantMetrics_t GetMetrics();                          //Return the metrics since ResetMetrics
+
+  private:
+    void Integrate();
+    void UpdateEncoder();
+    void UpdateMetrics();
+    static void Tick(void *context);
+    static void StepPulse(uint8_t deviceId, int8_t direction, void *context);
+
+    // member variables
+    plantParams_t params;
+    HostSimulator *simulator;
+    L6474Model *model;
+    bool running;                 //Tick event is scheduled
+
+    double angle;                 //Pendulum angle from hanging, CCW is +
+    double angularVelocity;       //Pendulum angular velocity
+    int32_t cartSteps;            //Cart position in steps
+    double cartVelocity;          //Cart velocity from the last step interval
+    double pendingDeltaV;         //Cart velocity change not yet applied to the pendulum
+    uint64_t lastStepTime;        //Virtual time of the last STEP pulse
+    uint64_t lastStepInterval;    //Ticks between the last two STEP pulses
+    int8_t lastStepDirection;     //Direction of the last STEP pulse
+
+    int32_t encoderEdges;         //Edges produced, the phase is the two low bits
+
+    double settlingBand;          //Angle band for the settling time
+    uint64_t metricsStart;        //Virtual time of ResetMetrics
+    uint64_t lastOutsideBand;     //Last time the angle was outside the band
+    bool outsideBand;             //The last sample was outside the band
+    double sumSquaredError;
+    double maxAngleError;
+    int32_t metricsCartSteps;     //Cart position at ResetMetrics
+    int32_t maxCartSteps;
+    uint32_t samples;
+};
+
+#endif /* #ifndef __CART_PENDULUM_PLANT_H_INCLUDED */
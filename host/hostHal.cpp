@@ -0,0 +1,633 @@
+/******************************************************//**
+ * @file    hostHal.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Host (Linux) implementation of the Arduino core calls,
+ *          AVR registers and interrupt dispatch used by the firmware
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "hostHal.h"
+#include <stdio.h>
+#include <time.h>
+
+/// AVR register definitions (see include/avr/io.h)
+volatile uint8_t EICRA, EIMSK, EIFR;
+volatile uint8_t PCICR, PCIFR, PCMSK0, PCMSK1, PCMSK2;
+volatile uint8_t PINB, DDRB, PORTB, PINC, DDRC, PORTC, PIND, DDRD, PORTD;
+volatile uint8_t TCCR0A, TCCR0B, TCNT0, OCR0A, OCR0B, TIMSK0, TIFR0;
+volatile uint8_t TCCR1A, TCCR1B, TCCR1C, TIMSK1, TIFR1;
+volatile uint16_t TCNT1, ICR1, OCR1A, OCR1B;
+volatile uint8_t TCCR2A, TCCR2B, TCNT2, OCR2A, OCR2B, ASSR, TIMSK2, TIFR2;
+
+HardwareSerial Serial;
+
+/// Handlers defined by the firmware with ISR(). Vectors the firmware does not
+/// define resolve to NULL through the weak reference.
+extern "C" void PCINT0_vect(void) __attribute__((weak));
+extern "C" void PCINT1_vect(void) __attribute__((weak));
+extern "C" void PCINT2_vect(void) __attribute__((weak));
+extern "C" void TIMER2_COMPA_vect(void) __attribute__((weak));
+extern "C" void TIMER2_OVF_vect(void) __attribute__((weak));
+extern "C" void TIMER1_OVF_vect(void) __attribute__((weak));
+extern "C" void TIMER0_OVF_vect(void) __attribute__((weak));
+
+static void WallClockDelay(unsigned long us);
+
+static void (*externalIntFunc[2])(void) = {NULL, NULL};
+static hostPinWriteHook_t pinWriteHooks[NUM_DIGITAL_PINS];
+static hostMicrosSource_t microsSource = HostWallClockMicros;
+static hostDelaySink_t delaySink = WallClockDelay;
+static volatile bool globalInterruptEnable = true;
+static volatile bool interruptHold = false;
+static volatile uint32_t pendingVectors = 0;
+static uint32_t serviceCount[HOST_VECT_COUNT];
+
+/******************************************************//**
+ * @brief  Maps an Arduino pin number onto its port registers
+ * the same way the Uno pin tables do.
+ * @param  pin Arduino digital pin (0..19)
+ * @param  pinReg Set to the PINx register of the port
+ * @param  portReg Set to the PORTx register of the port
+ * @retval Bit mask of the pin within the port, 0 if the pin is invalid
+ **********************************************************/
+static uint8_t PinToPort(uint8_t pin, volatile uint8_t **pinReg, volatile uint8_t **portReg)
+{
+  if (pin < 8)
+  {
+    *pinReg = &PIND;
+    *portReg = &PORTD;
+    return _BV(pin);
+  }
+  else if (pin < 14)
+  {
+    *pinReg = &PINB;
+    *portReg = &PORTB;
+    return _BV(pin - 8);
+  }
+  else if (pin < NUM_DIGITAL_PINS)
+  {
+    *pinReg = &PINC;
+    *portReg = &PORTC;
+    return _BV(pin - 14);
+  }
+  return 0;
+}
+
+/******************************************************//**
+ * @brief  Calls the handler behind a vector.
+ * @param  vector Interrupt vector to run
+ * @retval None
+ **********************************************************/
+static void InvokeVector(uint8_t vector)
+{
+  void (*handler)(void) = NULL;
+
+  /* Executing the vector clears the interrupt flag, as on the AVR */
+  switch (vector)
+  {
+    case HOST_VECT_INT0:
+      EIFR &= ~_BV(INTF0);
+      handler = externalIntFunc[0];
+      break;
+    case HOST_VECT_INT1:
+      EIFR &= ~_BV(INTF1);
+      handler = externalIntFunc[1];
+      break;
+    case HOST_VECT_PCINT0:
+      PCIFR &= ~_BV(PCIF0);
+      handler = PCINT0_vect;
+      break;
+    case HOST_VECT_PCINT1:
+      PCIFR &= ~_BV(PCIF1);
+      handler = PCINT1_vect;
+      break;
+    case HOST_VECT_PCINT2:
+      PCIFR &= ~_BV(PCIF2);
+      handler = PCINT2_vect;
+      break;
+    case HOST_VECT_TIMER2_COMPA:
+      TIFR2 &= ~_BV(OCF2A);
+      handler = TIMER2_COMPA_vect;
+      break;
+    case HOST_VECT_TIMER2_OVF:
+      TIFR2 &= ~_BV(TOV2);
+      handler = TIMER2_OVF_vect;
+      break;
+    case HOST_VECT_TIMER1_OVF:
+      TIFR1 &= ~_BV(TOV1);
+      handler = TIMER1_OVF_vect;
+      break;
+    case HOST_VECT_TIMER0_OVF:
+      TIFR0 &= ~_BV(TOV0);
+      handler = TIMER0_OVF_vect;
+      break;
+    default:
+      break;
+  }
+
+  if (handler != NULL)
+  {
+    handler();
+  }
+}
+
+/******************************************************//**
+ * @brief  Services latched interrupt requests in priority order
+ * while the I bit is set. Like the AVR, the I bit is cleared on
+ * entry to a handler and set again on return, so a handler that
+ * calls interrupts() can be nested. Nothing is serviced while a
+ * model holds the requests.
+ * @param  None
+ * @retval None
+ **********************************************************/
+static void ServicePending()
+{
+  while (globalInterruptEnable && !interruptHold && pendingVectors)
+  {
+    uint8_t vector = __builtin_ctz(pendingVectors);
+    pendingVectors &= ~(1UL << vector);
+
+    if (!HostIsInterruptEnabled((hostVector_t)vector))
+    {
+      continue;
+    }
+
+    globalInterruptEnable = false;
+    serviceCount[vector]++;
+    InvokeVector(vector);
+    globalInterruptEnable = true;
+  }
+}
+
+/******************************************************//**
+ * @brief  Blocks for the requested time against the wall clock.
+ * @param  us Delay in microseconds
+ * @retval None
+ **********************************************************/
+static void WallClockDelay(unsigned long us)
+{
+  struct timespec request;
+  request.tv_sec = us / 1000000UL;
+  request.tv_nsec = (us % 1000000UL) * 1000UL;
+  nanosleep(&request, NULL);
+}
+
+/******************************************************//**
+ * @brief  Drives a pin from outside of the firmware, such as an
+ * encoder output. The level is visible through digitalRead and
+ * the PINx register. Pins 2 and 3 raise INT0/INT1 when the edge
+ * matches the sense mode selected with attachInterrupt. Any change
+ * of a pin selected in PCMSKn raises the pin change interrupt of
+ * its port, PCINT2 for 0..7, PCINT0 for 8..13 and PCINT1 for A0..A5. Pins 4
+ * and 5 are T0 and T1 and clock their timer when its clock select
+ * picks the external pin on that edge.
+ * @param  pin Arduino digital pin
+ * @param  level HIGH or LOW
+ * @retval None
+ **********************************************************/
+void HostSetPinLevel(uint8_t pin, uint8_t level)
+{
+  volatile uint8_t *pinReg;
+  volatile uint8_t *portReg;
+  uint8_t mask = PinToPort(pin, &pinReg, &portReg);
+  if (!mask)
+  {
+    return;
+  }
+
+  uint8_t previous = (*pinReg & mask) ? HIGH : LOW;
+  level ? (*pinReg |= mask) : (*pinReg &= ~mask);
+
+  /* CSn2:0 of 6 counts falling edges on Tn and 7 rising edges */
+  uint8_t clockSelect = pin == 4 ? (TCCR0B & 0x07) : (pin == 5 ? (TCCR1B & 0x07) : 0);
+  if (previous != level && ((clockSelect == 0x06 && !level) || (clockSelect == 0x07 && level)))
+  {
+    if (pin == 4)
+    {
+      TCNT0++;
+    }
+    else
+    {
+      TCNT1++;
+    }
+  }
+
+  if (previous != level && (*digitalPinToPCMSK(pin) & _BV(digitalPinToPCMSKbit(pin))))
+  {
+    HostRaiseInterrupt((hostVector_t)(HOST_VECT_PCINT0 + digitalPinToPCICRbit(pin)));
+  }
+
+  int8_t interruptNum = digitalPinToInterrupt(pin);
+  if (interruptNum == NOT_AN_INTERRUPT || !(EIMSK & _BV(interruptNum)))
+  {
+    return;
+  }
+
+  bool fire;
+  switch ((EICRA >> (2 * interruptNum)) & 0x03)
+  {
+    case CHANGE:
+      fire = previous != level;
+      break;
+    case FALLING:
+      fire = previous && !level;
+      break;
+    case RISING:
+      fire = !previous && level;
+      break;
+    default: // LOW level
+      fire = !level;
+      break;
+  }
+
+  if (fire)
+  {
+    HostRaiseInterrupt(interruptNum == 0 ? HOST_VECT_INT0 : HOST_VECT_INT1);
+  }
+}
+
+/******************************************************//**
+ * @brief  Returns the level of a pin as digitalRead sees it
+ * @param  pin Arduino digital pin
+ * @retval HIGH or LOW
+ **********************************************************/
+uint8_t HostGetPinLevel(uint8_t pin)
+{
+  volatile uint8_t *pinReg;
+  volatile uint8_t *portReg;
+  uint8_t mask = PinToPort(pin, &pinReg, &portReg);
+  return (mask && (*pinReg & mask)) ? HIGH : LOW;
+}
+
+/******************************************************//**
+ * @brief  Registers a hook called after each digitalWrite to
+ * the pin, used by device models to watch chip select, direction
+ * and reset lines.
+ * @param  pin Arduino digital pin
+ * @param  hook Callback, or NULL to detach
+ * @retval None
+ **********************************************************/
+void HostAttachPinWriteHook(uint8_t pin, hostPinWriteHook_t hook)
+{
+  if (pin < NUM_DIGITAL_PINS)
+  {
+    pinWriteHooks[pin] = hook;
+  }
+}
+
+/******************************************************//**
+ * @brief  Latches an interrupt request for the vector and sets
+ * its flag in EIFR/PCIFR/TIFRn. It is
+ * serviced immediately when the I bit is set, otherwise as soon
+ * as interrupts() re-enables it. Requests for a vector masked in
+ * its enable register are dropped when serviced.
+ * @param  vector Interrupt vector to raise
+ * @retval None
+ **********************************************************/
+void HostRaiseInterrupt(hostVector_t vector)
+{
+  switch (vector)
+  {
+    case HOST_VECT_INT0:
+      EIFR |= _BV(INTF0);
+      break;
+    case HOST_VECT_INT1:
+      EIFR |= _BV(INTF1);
+      break;
+    case HOST_VECT_PCINT0:
+      PCIFR |= _BV(PCIF0);
+      break;
+    case HOST_VECT_PCINT1:
+      PCIFR |= _BV(PCIF1);
+      break;
+    case HOST_VECT_PCINT2:
+      PCIFR |= _BV(PCIF2);
+      break;
+    case HOST_VECT_TIMER2_COMPA:
+      TIFR2 |= _BV(OCF2A);
+      break;
+    case HOST_VECT_TIMER2_OVF:
+      TIFR2 |= _BV(TOV2);
+      break;
+    case HOST_VECT_TIMER1_OVF:
+      TIFR1 |= _BV(TOV1);
+      break;
+    case HOST_VECT_TIMER0_OVF:
+      TIFR0 |= _BV(TOV0);
+      break;
+    default:
+      break;
+  }
+  pendingVectors |= (1UL << vector);
+  ServicePending();
+}
+
+/******************************************************//**
+ * @brief  Checks whether a request for the vector is latched and
+ * waiting to be serviced
+ * @param  vector Interrupt vector
+ * @retval true if the request is pending
+ **********************************************************/
+bool HostIsInterruptPending(hostVector_t vector)
+{
+  return (pendingVectors & (1UL << vector)) != 0;
+}
+
+/******************************************************//**
+ * @brief  Services the highest priority latched request even if
+ * the I bit is clear. Used by models that keep interrupts off and
+ * decide themselves when the CPU gets to each handler.
+ * @param  None
+ * @retval Vector serviced, HOST_VECT_COUNT if none was pending
+ **********************************************************/
+hostVector_t HostServiceNextInterrupt(void)
+{
+  while (pendingVectors)
+  {
+    uint8_t vector = __builtin_ctz(pendingVectors);
+    pendingVectors &= ~(1UL << vector);
+
+    if (HostIsInterruptEnabled((hostVector_t)vector))
+    {
+      bool wasEnabled = globalInterruptEnable;
+      globalInterruptEnable = false;
+      serviceCount[vector]++;
+      InvokeVector(vector);
+      globalInterruptEnable = wasEnabled;
+      return (hostVector_t)vector;
+    }
+  }
+  return HOST_VECT_COUNT;
+}
+
+/******************************************************//**
+ * @brief  Holds latched requests for a model that services them
+ * with HostServiceNextInterrupt when its CPU gets to them. Unlike
+ * clearing the I bit, firmware main loop code can still use
+ * noInterrupts() and interrupts() around its critical sections.
+ * @param  hold true to only latch requests, false to service them
+ * as the I bit allows again
+ * @retval None
+ **********************************************************/
+void HostHoldInterrupts(bool hold)
+{
+  interruptHold = hold;
+  ServicePending();
+}
+
+/******************************************************//**
+ * @brief  Returns whether a model holds the latched requests
+ * @param  None
+ * @retval true while HostHoldInterrupts(true) is in effect
+ **********************************************************/
+bool HostInterruptsHeld(void)
+{
+  return interruptHold;
+}
+
+/******************************************************//**
+ * @brief  Checks the enable bit of the vector in EIMSK/PCICR/TIMSKn
+ * @param  vector Interrupt vector
+ * @retval true if the vector is unmasked
+ **********************************************************/
+bool HostIsInterruptEnabled(hostVector_t vector)
+{
+  switch (vector)
+  {
+    case HOST_VECT_INT0:
+      return EIMSK & _BV(INT0);
+    case HOST_VECT_INT1:
+      return EIMSK & _BV(INT1);
+    case HOST_VECT_PCINT0:
+      return PCICR & _BV(PCIE0);
+    case HOST_VECT_PCINT1:
+      return PCICR & _BV(PCIE1);
+    case HOST_VECT_PCINT2:
+      return PCICR & _BV(PCIE2);
+    case HOST_VECT_TIMER2_COMPA:
+      return TIMSK2 & _BV(OCIE2A);
+    case HOST_VECT_TIMER2_OVF:
+      return TIMSK2 & _BV(TOIE2);
+    case HOST_VECT_TIMER1_OVF:
+      return TIMSK1 & _BV(TOIE1);
+    case HOST_VECT_TIMER0_OVF:
+      return TIMSK0 & _BV(TOIE0);
+    default:
+      return false;
+  }
+}
+
+/******************************************************//**
+ * @brief  Returns the state of the global interrupt enable
+ * @param  None
+ * @retval true if interrupts are enabled
+ **********************************************************/
+bool HostGlobalInterruptsEnabled(void)
+{
+  return globalInterruptEnable;
+}
+
+/******************************************************//**
+ * @brief  Returns the number of times a vector was serviced
+ * @param  vector Interrupt vector
+ * @retval service count
+ **********************************************************/
+uint32_t HostGetInterruptCount(hostVector_t vector)
+{
+  return vector < HOST_VECT_COUNT ? serviceCount[vector] : 0;
+}
+
+/******************************************************//**
+ * @brief  Clears the service counters of all vectors
+ * @param  None
+ * @retval None
+ **********************************************************/
+void HostResetInterruptCounts(void)
+{
+  memset(serviceCount, 0, sizeof(serviceCount));
+}
+
+/******************************************************//**
+ * @brief  Replaces the time base behind micros(), millis(),
+ * delay() and delayMicroseconds(). Passing NULL restores the
+ * wall clock.
+ * @param  newMicrosSource Returns the current time in microseconds
+ * @param  newDelaySink Consumes a blocking delay in microseconds
+ * @retval None
+ **********************************************************/
+void HostSetTimeSource(hostMicrosSource_t newMicrosSource, hostDelaySink_t newDelaySink)
+{
+  microsSource = newMicrosSource != NULL ? newMicrosSource : HostWallClockMicros;
+  delaySink = newDelaySink != NULL ? newDelaySink : WallClockDelay;
+}
+
+/******************************************************//**
+ * @brief  Returns monotonic wall time since the first call
+ * @param  None
+ * @retval time in nanoseconds
+ **********************************************************/
+uint64_t HostWallClockNanos(void)
+{
+  static uint64_t start = 0;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  uint64_t nanos = (uint64_t)now.tv_sec * 1000000000ULL + (uint64_t)now.tv_nsec;
+  if (start == 0)
+  {
+    start = nanos;
+  }
+  return nanos - start;
+}
+
+/******************************************************//**
+ * @brief  Returns monotonic wall time since the first call
+ * @param  None
+ * @retval time in microseconds
+ **********************************************************/
+unsigned long HostWallClockMicros(void)
+{
+  return (unsigned long)(HostWallClockNanos() / 1000ULL);
+}
+
+/******************************************************//**
+ * Arduino core
+ **********************************************************/
+void pinMode(uint8_t pin, uint8_t mode)
+{
+  volatile uint8_t *pinReg;
+  volatile uint8_t *portReg;
+  uint8_t mask = PinToPort(pin, &pinReg, &portReg);
+  if (!mask)
+  {
+    return;
+  }
+  volatile uint8_t *ddrReg = (portReg == &PORTD) ? &DDRD : (portReg == &PORTB) ? &DDRB : &DDRC;
+
+  if (mode == OUTPUT)
+  {
+    *ddrReg |= mask;
+  }
+  else
+  {
+    *ddrReg &= ~mask;
+    if (mode == INPUT_PULLUP)
+    {
+      /* nothing drives the pin yet, so the pull-up holds it high */
+      *portReg |= mask;
+      *pinReg |= mask;
+    }
+    else
+    {
+      *portReg &= ~mask;
+    }
+  }
+}
+
+void digitalWrite(uint8_t pin, uint8_t val)
+{
+  volatile uint8_t *pinReg;
+  volatile uint8_t *portReg;
+  uint8_t mask = PinToPort(pin, &pinReg, &portReg);
+  if (!mask)
+  {
+    return;
+  }
+
+  if (val)
+  {
+    *portReg |= mask;
+    *pinReg |= mask;
+  }
+  else
+  {
+    *portReg &= ~mask;
+    *pinReg &= ~mask;
+  }
+
+  if (pinWriteHooks[pin] != NULL)
+  {
+    pinWriteHooks[pin](pin, val ? HIGH : LOW);
+  }
+}
+
+int digitalRead(uint8_t pin)
+{
+  return HostGetPinLevel(pin);
+}
+
+unsigned long micros(void)
+{
+  return microsSource();
+}
+
+unsigned long millis(void)
+{
+  return microsSource() / 1000UL;
+}
+
+void delay(unsigned long ms)
+{
+  delaySink(ms * 1000UL);
+}
+
+void delayMicroseconds(unsigned int us)
+{
+  delaySink(us);
+}
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode)
+{
+  if (interruptNum < 2)
+  {
+    externalIntFunc[interruptNum] = userFunc;
+    EICRA = (EICRA & ~(0x03 << (2 * interruptNum))) | ((mode & 0x03) << (2 * interruptNum));
+    EIMSK |= _BV(interruptNum);
+  }
+}
+
+void detachInterrupt(uint8_t interruptNum)
+{
+  if (interruptNum < 2)
+  {
+    EIMSK &= ~_BV(interruptNum);
+    externalIntFunc[interruptNum] = NULL;
+  }
+}
+
+void sei(void)
+{
+  globalInterruptEnable = true;
+  ServicePending();
+}
+
+void cli(void)
+{
+  globalInterruptEnable = false;
+}
+
+/******************************************************//**
+ * Serial
+ **********************************************************/
+void HardwareSerial::begin(unsigned long baud) { (void)baud; }
+void HardwareSerial::end() { fflush(stdout); }
+size_t HardwareSerial::print(const char *str) { return printf("%s", str); }
+size_t HardwareSerial::print(char c) { return printf("%c", c); }
+size_t HardwareSerial::print(int n) { return printf("%d", n); }
+size_t HardwareSerial::print(unsigned int n) { return printf("%u", n); }
+size_t HardwareSerial::print(long n) { return printf("%ld", n); }
+size_t HardwareSerial::print(unsigned long n) { return printf("%lu", n); }
+size_t HardwareSerial::print(double n, int digits) { return printf("%.*f", digits, n); }
+size_t HardwareSerial::println(void) { return printf("\r\n"); }
+size_t HardwareSerial::println(const char *str) { return print(str) + println(); }
+size_t HardwareSerial::println(char c) { return print(c) + println(); }
+size_t HardwareSerial::println(int n) { return print(n) + println(); }
+size_t HardwareSerial::println(unsigned int n) { return print(n) + println(); }
+size_t HardwareSerial::println(long n) { return print(n) + println(); }
+size_t HardwareSerial::println(unsigned long n) { return print(n) + println(); }
+size_t HardwareSerial::println(double n, int digits) { return print(n, digits) + println(); }
@@ -0,0 +1,79 @@
+/******************************************************//**
+ * @file    hostHal.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Control side of the host HAL. The firmware only sees
+ *          Arduino.h, SPI.h and the AVR registers; benchmarks and
+ *          simulators use these calls to drive pins, raise interrupts,
+ *          replace the clock and attach SPI devices.
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __HOST_HAL_H_INCLUDED
+#define __HOST_HAL_H_INCLUDED
+
+#include <Arduino.h>
+
+/// Interrupt vectors the host HAL dispatches, in ATmega328P priority order
+typedef enum {
+  HOST_VECT_INT0 = 0,
+  HOST_VECT_INT1,
+  HOST_VECT_PCINT0,
+  HOST_VECT_PCINT1,
+  HOST_VECT_PCINT2,
+  HOST_VECT_TIMER2_COMPA,
+  HOST_VECT_TIMER2_OVF,
+  HOST_VECT_TIMER1_OVF,
+  HOST_VECT_TIMER0_OVF,
+  HOST_VECT_COUNT
+} hostVector_t;
+
+/// Callback for observing a digitalWrite on a pin
+typedef void (*hostPinWriteHook_t)(uint8_t pin, uint8_t level);
+/// Callback for the device on the other end of the SPI bus
+typedef uint8_t (*hostSpiTransfer_t)(uint8_t data);
+/// Callback providing the current time in microseconds
+typedef unsigned long (*hostMicrosSource_t)(void);
+/// Callback consuming a blocking delay in microseconds
+typedef void (*hostDelaySink_t)(unsigned long us);
+
+/// @defgroup host1 Pins
+///@{
+void HostSetPinLevel(uint8_t pin, uint8_t level);                //Drive an input pin from outside, fires INT0/INT1 and PCINTn on a matching edge
+uint8_t HostGetPinLevel(uint8_t pin);                            //Read the level of any pin
+void HostAttachPinWriteHook(uint8_t pin, hostPinWriteHook_t hook);//Observe digitalWrite calls on a pin (NULL to detach)
+///@}
+
+/// @defgroup host2 Interrupts
+///@{
+void HostRaiseInterrupt(hostVector_t vector);       //Latch an interrupt request and service it if allowed
+bool HostIsInterruptEnabled(hostVector_t vector);   //True if the vector is unmasked in its enable register
+bool HostGlobalInterruptsEnabled(void);             //State of the I bit
+bool HostIsInterruptPending(hostVector_t vector);   //True if a request for the vector is latched
+hostVector_t HostServiceNextInterrupt(void);        //Service the highest priority latched request regardless of the I bit
+void HostHoldInterrupts(bool hold);                 //Only latch requests, even with the I bit set, for models that dispatch them
+bool HostInterruptsHeld(void);                      //True while a model holds the requests
+uint32_t HostGetInterruptCount(hostVector_t vector);//Number of times the vector has been serviced
+void HostResetInterruptCounts(void);                //Clear all service counters
+///@}
+
+/// @defgroup host3 Time
+///@{
+void HostSetTimeSource(hostMicrosSource_t microsSource, //Replace micros()/delay() (NULL restores wall clock)
+                       hostDelaySink_t delaySink);
+unsigned long HostWallClockMicros(void);                //Microseconds of wall time since the HAL started
+uint64_t HostWallClockNanos(void);                      //Nanoseconds of wall time since the HAL started
+///@}
+
+/// @defgroup host4 SPI
+///@{
+void HostAttachSpiDevice(hostSpiTransfer_t transfer);   //Attach the device answering SPI.transfer (NULL to detach)
+uint32_t HostGetSpiByteCount(void);                     //Number of bytes clocked since start
+///@}
+
+#endif /* #ifndef __HOST_HAL_H_INCLUDED */
@@ -0,0 +1,468 @@
+/******************************************************//**
+ * @file    hostSimulator.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Virtual-time discrete-event scheduler for the host HAL
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "hostSimulator.h"
+
+/// static member definitions
+class HostSimulator* HostSimulator::instancePtr = NULL;
+
+/// Clock select (CSn2:0) to prescaler for timer 0 and timer 1, 0 = stopped or external clock
+static const uint16_t prescalerTimer0_1[8] = {0, 1, 8, 64, 256, 1024, 0, 0};
+/// Clock select (CS22:0) to prescaler for timer 2
+static const uint16_t prescalerTimer2[8] = {0, 1, 8, 32, 64, 128, 256, 1024};
+/// Vector raised by each timer source
+static const hostVector_t timerVector[SIM_TIMER_COUNT] = {
+  HOST_VECT_TIMER2_COMPA,
+  HOST_VECT_TIMER2_OVF,
+  HOST_VECT_TIMER1_OVF,
+  HOST_VECT_TIMER0_OVF
+};
+
+/******************************************************//**
+ * @brief  Constructor for the simulator. Virtual time starts
+ * at 0 with the micros() granularity of a 16MHz Uno.
+ * @param  None
+ * @retval None
+ **********************************************************/
+HostSimulator::HostSimulator()
+{
+  now = 0;
+  microsResolution = 4;
+  sequence = 0;
+  eventCount = 0;
+  numberOfEvents = 0;
+  for (uint8_t i = 0; i < SIM_TIMER_COUNT; i++)
+  {
+    timers[i].period = 0;
+    timers[i].nextFire = 0;
+    timers[i].running = false;
+    timers[i].hook = NULL;
+    timers[i].hookContext = NULL;
+  }
+  instancePtr = this;
+}
+
+/******************************************************//**
+ * @brief  Installs virtual time as the time base behind
+ * micros(), millis() and delay(). Call before the firmware
+ * Begin() methods so their timestamps are virtual.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void HostSimulator::Begin()
+{
+  instancePtr = this;
+  HostSetTimeSource(VirtualMicros, VirtualDelay);
+  SyncTimers();
+}
+
+/******************************************************//**
+ * @brief  Gives the time base back to the wall clock
+ * @param  None
+ * @retval None
+ **********************************************************/
+void HostSimulator::End()
+{
+  HostSetTimeSource(NULL, NULL);
+}
+
+/******************************************************//**
+ * @brief  Sets the granularity of micros(). The Uno core counts
+ * Timer 0 overflows at clk/64, so micros() moves in 4us steps.
+ * @param  resolutionUs granularity in microseconds (1 for exact)
+ * @retval None
+ **********************************************************/
+void HostSimulator::SetMicrosResolution(uint8_t resolutionUs)
+{
+  microsResolution = resolutionUs > 0 ? resolutionUs : 1;
+}
+
+/******************************************************//**
+ * @brief  Returns the current virtual time
+ * @param  None
+ * @retval time in CPU clock cycles
+ **********************************************************/
+uint64_t HostSimulator::GetTime()
+{
+  return now;
+}
+
+/******************************************************//**
+ * @brief  Returns the current virtual time without the micros()
+ * granularity applied
+ * @param  None
+ * @retval time in microseconds
+ **********************************************************/
+unsigned long HostSimulator::GetTimeMicros()
+{
+  return (unsigned long)(now / Sim_Ticks_Per_Us);
+}
+
+/******************************************************//**
+ * @brief  Returns the period a timer source is currently firing at
+ * @param  timer Timer source
+ * @retval period in CPU clock cycles, 0 if stopped
+ **********************************************************/
+uint64_t HostSimulator::GetTimerPeriod(simTimer_t timer)
+{
+  SyncTimers();
+  return timers[timer].running ? timers[timer].period : 0;
+}
+
+/******************************************************//**
+ * @brief  Returns the number of scheduled events dispatched
+ * @param  None
+ * @retval event count
+ **********************************************************/
+uint32_t HostSimulator::GetEventCount()
+{
+  return eventCount;
+}
+
+/******************************************************//**
+ * @brief  Schedules a handler to run at an absolute virtual time.
+ * Events at the same time run in the order they were scheduled.
+ * @param  time Virtual time in ticks, clamped to now
+ * @param  handler Function to call
+ * @param  context Passed to the handler
+ * @retval false if the event queue is full
+ **********************************************************/
+bool HostSimulator::Schedule(uint64_t time, simEventHandler_t handler, void *context)
+{
+  if (numberOfEvents >= Sim_Max_Events)
+  {
+    return false;
+  }
+
+  simEvent_t event;
+  event.time = time < now ? now : time;
+  event.sequence = sequence++;
+  event.handler = handler;
+  event.context = context;
+  PushEvent(event);
+  return true;
+}
+
+/******************************************************//**
+ * @brief  Schedules a handler to run after a delay
+ * @param  delay Delay in ticks from now
+ * @param  handler Function to call
+ * @param  context Passed to the handler
+ * @retval false if the event queue is full
+ **********************************************************/
+bool HostSimulator::ScheduleIn(uint64_t delay, simEventHandler_t handler, void *context)
+{
+  return Schedule(now + delay, handler, context);
+}
+
+/******************************************************//**
+ * @brief  Advances virtual time to the given time. Timer vectors
+ * and scheduled events that fall due are dispatched in time order,
+ * and the timer setup is re-read after each one so frequency
+ * changes made by the firmware take effect. A timer due at the
+ * same tick as an event goes first, so the event sees the counter
+ * wrap together with its interrupt flag as on the target.
+ * @param  time Virtual time in ticks to stop at
+ * @retval None
+ **********************************************************/
+void HostSimulator::RunUntil(uint64_t time)
+{
+  SyncTimers();
+
+  for (;;)
+  {
+    int8_t nextTimer = -1;
+    uint64_t next = numberOfEvents ? events[0].time : UINT64_MAX;
+
+    for (uint8_t i = 0; i < SIM_TIMER_COUNT; i++)
+    {
+      if (timers[i].running && timers[i].nextFire <= next)
+      {
+        next = timers[i].nextFire;
+        nextTimer = i;
+      }
+    }
+
+    if (next > time)
+    {
+      break;
+    }
+
+    now = next;
+    if (nextTimer >= 0)
+    {
+      /* Like the double buffered TOP registers on the AVR, a period change made
+       * by the handler applies from the cycle after the one starting now */
+      timers[nextTimer].nextFire = now + timers[nextTimer].period;
+      SyncCounters();
+      if (timers[nextTimer].hook != NULL)
+      {
+        timers[nextTimer].hook(timers[nextTimer].hookContext);
+      }
+      HostRaiseInterrupt(timerVector[nextTimer]);
+    }
+    else
+    {
+      simEvent_t event;
+      PopEvent(&event);
+      eventCount++;
+      SyncCounters();
+      event.handler(event.context);
+    }
+    SyncTimers();
+  }
+
+  if (time > now)
+  {
+    now = time;
+    SyncCounters();
+  }
+}
+
+/******************************************************//**
+ * @brief  Advances virtual time by a duration
+ * @param  duration Duration in ticks
+ * @retval None
+ **********************************************************/
+void HostSimulator::RunFor(uint64_t duration)
+{
+  RunUntil(now + duration);
+}
+
+/******************************************************//**
+ * @brief  Registers a hook called once per cycle of a timer
+ * source, before its interrupt is raised, whether or not the
+ * interrupt is enabled. Device models use it to follow the
+ * waveform a timer drives onto an output compare pin.
+ * @param  timer Timer source
+ * @param  hook Callback, or NULL to detach
+ * @param  context Passed to the hook
+ * @retval None
+ **********************************************************/
+void HostSimulator::AttachTimerHook(simTimer_t timer, simEventHandler_t hook, void *context)
+{
+  timers[timer].hook = hook;
+  timers[timer].hookContext = context;
+}
+
+/******************************************************//**
+ * @brief  Gets the pointer to the HostSimulator instance
+ * @param  None
+ * @retval Pointer to the instance of HostSimulator
+ **********************************************************/
+class HostSimulator* HostSimulator::GetInstancePtr()
+{
+  return instancePtr;
+}
+
+/******************************************************//**
+ * @brief  Re-reads the timer registers. A timer that was just
+ * started fires one period from now, a stopped timer is removed
+ * and a running timer picks up the new period on its next cycle.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void HostSimulator::SyncTimers()
+{
+  for (uint8_t i = 0; i < SIM_TIMER_COUNT; i++)
+  {
+    uint64_t period = ComputeTimerPeriod((simTimer_t)i);
+    if (period == 0)
+    {
+      timers[i].running = false;
+    }
+    else if (!timers[i].running)
+    {
+      timers[i].running = true;
+      timers[i].nextFire = now + period;
+    }
+    timers[i].period = period;
+  }
+}
+
+/******************************************************//**
+ * @brief  Sets TCNT2 to the count the timer has reached at the
+ * current virtual time, so firmware reading the counter as a
+ * timestamp sees it advance. Only the single slope modes (normal,
+ * CTC and fast PWM) are followed.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void HostSimulator::SyncCounters()
+{
+  uint16_t prescaler = prescalerTimer2[TCCR2B & 0x07];
+  uint8_t wgm = ((TCCR2B >> WGM22) & 0x01) << 2 | (TCCR2A & 0x03);
+  simTimer_t timer = wgm == 2 ? SIM_TIMER_2_COMPA : SIM_TIMER_2_OVF;
+
+  if (prescaler == 0 || !timers[timer].running || (wgm != 0 && wgm != 2 && wgm != 3 && wgm != 7))
+  {
+    return;
+  }
+
+  uint64_t cycleStart = timers[timer].nextFire - timers[timer].period;
+  TCNT2 = (uint8_t)((now - cycleStart) / prescaler);
+}
+
+/******************************************************//**
+ * @brief  Computes the interval between interrupts of a timer
+ * source from its waveform generation mode, TOP value and clock
+ * select, following the ATmega328P datasheet timer chapters.
+ * @param  timer Timer source
+ * @retval period in CPU clock cycles, 0 if the source never fires
+ **********************************************************/
+uint64_t HostSimulator::ComputeTimerPeriod(simTimer_t timer)
+{
+  uint32_t counts = 0;
+  uint16_t prescaler;
+  uint8_t wgm;
+
+  switch (timer)
+  {
+    case SIM_TIMER_2_COMPA:
+    case SIM_TIMER_2_OVF:
+      prescaler = prescalerTimer2[TCCR2B & 0x07];
+      wgm = ((TCCR2B >> WGM22) & 0x01) << 2 | (TCCR2A & 0x03);
+      switch (wgm)
+      {
+        case 0: counts = 256; break;                         // normal
+        case 1: counts = 510; break;                         // phase correct, TOP 0xFF
+        case 2: counts = timer == SIM_TIMER_2_COMPA ? OCR2A + 1 : 0; break; // CTC, TOP OCR2A
+        case 3: counts = 256; break;                         // fast PWM, TOP 0xFF
+        case 5: counts = 2 * (uint32_t)OCR2A; break;         // phase correct, TOP OCR2A
+        case 7: counts = OCR2A + 1; break;                   // fast PWM, TOP OCR2A
+        default: break;
+      }
+      break;
+
+    case SIM_TIMER_1_OVF:
+      prescaler = prescalerTimer0_1[TCCR1B & 0x07];
+      wgm = ((TCCR1B >> WGM12) & 0x03) << 2 | (TCCR1A & 0x03);
+      switch (wgm)
+      {
+        case 0: counts = 65536; break;                       // normal
+        case 1: counts = 2 * 255; break;                     // phase correct, 8-bit
+        case 2: counts = 2 * 511; break;                     // phase correct, 9-bit
+        case 3: counts = 2 * 1023; break;                    // phase correct, 10-bit
+        case 5: counts = 256; break;                         // fast PWM, 8-bit
+        case 6: counts = 512; break;                         // fast PWM, 9-bit
+        case 7: counts = 1024; break;                        // fast PWM, 10-bit
+        case 8:                                              // phase and frequency correct, TOP ICR1
+        case 10: counts = 2 * (uint32_t)ICR1; break;         // phase correct, TOP ICR1
+        case 9:                                              // phase and frequency correct, TOP OCR1A
+        case 11: counts = 2 * (uint32_t)OCR1A; break;        // phase correct, TOP OCR1A
+        case 14: counts = ICR1 + 1; break;                   // fast PWM, TOP ICR1
+        case 15: counts = OCR1A + 1; break;                  // fast PWM, TOP OCR1A
+        default: break;                                      // CTC never reaches MAX
+      }
+      break;
+
+    case SIM_TIMER_0_OVF:
+      prescaler = prescalerTimer0_1[TCCR0B & 0x07];
+      wgm = ((TCCR0B >> WGM02) & 0x01) << 2 | (TCCR0A & 0x03);
+      switch (wgm)
+      {
+        case 0: counts = 256; break;
+        case 1: counts = 510; break;
+        case 3: counts = 256; break;
+        case 5: counts = 2 * (uint32_t)OCR0A; break;
+        case 7: counts = OCR0A + 1; break;
+        default: break;
+      }
+      break;
+
+    default:
+      return 0;
+  }
+
+  return (uint64_t)counts * prescaler;
+}
+
+/******************************************************//**
+ * @brief  Inserts an event into the min-heap ordered by time
+ * then sequence
+ * @param  event Event to insert
+ * @retval None
+ **********************************************************/
+void HostSimulator::PushEvent(const simEvent_t &event)
+{
+  uint8_t i = numberOfEvents++;
+  while (i > 0)
+  {
+    uint8_t parent = (i - 1) / 2;
+    if (events[parent].time < event.time ||
+        (events[parent].time == event.time && events[parent].sequence < event.sequence))
+    {
+      break;
+    }
+    events[i] = events[parent];
+    i = parent;
+  }
+  events[i] = event;
+}
+
+/******************************************************//**
+ * @brief  Removes the earliest event from the min-heap
+ * @param  event Receives the removed event
+ * @retval None
+ **********************************************************/
+void HostSimulator::PopEvent(simEvent_t *event)
+{
+  *event = events[0];
+  simEvent_t last = events[--numberOfEvents];
+  uint8_t i = 0;
+
+  for (;;)
+  {
+    uint8_t child = 2 * i + 1;
+    if (child >= numberOfEvents)
+    {
+      break;
+    }
+    if (child + 1 < numberOfEvents &&
+        (events[child + 1].time < events[child].time ||
+         (events[child + 1].time == events[child].time && events[child + 1].sequence < events[child].sequence)))
+    {
+      child++;
+    }
+    if (last.time < events[child].time ||
+        (last.time == events[child].time && last.sequence < events[child].sequence))
+    {
+      break;
+    }
+    events[i] = events[child];
+    i = child;
+  }
+  events[i] = last;
+}
+
+/******************************************************//**
+ * @brief  micros() replacement reading virtual time
+ * @param  None
+ * @retval time in microseconds at the configured granularity
+ **********************************************************/
+unsigned long HostSimulator::VirtualMicros(void)
+{
+  unsigned long us = instancePtr->GetTimeMicros();
+  return us - us % instancePtr->microsResolution;
+}
+
+/******************************************************//**
+ * @brief  delay() replacement advancing virtual time, so the
+ * sketch keeps servicing interrupts while it waits
+ * @param  us Delay in microseconds
+ * @retval None
+ **********************************************************/
+void HostSimulator::VirtualDelay(unsigned long us)
+{
+  instancePtr->RunFor((uint64_t)us * Sim_Ticks_Per_Us);
+}
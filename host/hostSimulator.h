@@ -0,0 +1,102 @@
+/******************************************************//**
+ * @file    hostSimulator.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Virtual-time discrete-event scheduler for the host HAL.
+ *          Fires the timer vectors at the period the firmware
+ *          programmed into the AVR registers and runs scheduled
+ *          events (encoder edges, samplers...) at exact times.
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __HOST_SIMULATOR_H_INCLUDED
+#define __HOST_SIMULATOR_H_INCLUDED
+
+#include "hostHal.h"
+
+/// Virtual time runs in CPU clock cycles so timer periods are exact
+#define Sim_Ticks_Per_Us      (F_CPU / 1000000L)
+#define Sim_Ticks_Per_Ms      (F_CPU / 1000L)
+#define Sim_Ticks_Per_Second  (F_CPU)
+
+/// Maximum number of pending scheduled events
+#define Sim_Max_Events        (64)
+
+/// Handler of a scheduled event, called with the context given to Schedule
+typedef void (*simEventHandler_t)(void *context);
+
+/// Timer interrupt sources the simulator clocks from the register setup
+typedef enum {
+  SIM_TIMER_2_COMPA = 0,
+  SIM_TIMER_2_OVF,
+  SIM_TIMER_1_OVF,
+  SIM_TIMER_0_OVF,
+  SIM_TIMER_COUNT
+} simTimer_t;
+
+/// Scheduled event
+typedef struct {
+  uint64_t time;
+  uint32_t sequence;
+  simEventHandler_t handler;
+  void *context;
+} simEvent_t;
+
+/// Periodic timer interrupt source
+typedef struct {
+  uint64_t period;
+  uint64_t nextFire;
+  bool running;
+  simEventHandler_t hook;
+  void *hookContext;
+} simTimerState_t;
+
+/// HostSimulator library class
+class HostSimulator
+{
+  public:
+    HostSimulator();                                  //Constructor
+    void Begin();                                     //Make virtual time the HAL time base
+    void End();                                       //Restore the wall clock time base
+    void SetMicrosResolution(uint8_t resolutionUs);   //Granularity of micros() (4us on a 16MHz Uno)
+
+    uint64_t GetTime();                               //Current virtual time in ticks
+    unsigned long GetTimeMicros();                    //Current virtual time in microseconds (full resolution)
+    uint64_t GetTimerPeriod(simTimer_t timer);        //Period of a running timer source in ticks, 0 if stopped
+    uint32_t GetEventCount();                         //Number of scheduled events dispatched so far
+
+    bool Schedule(uint64_t time, simEventHandler_t handler, void *context);      //Run handler at an absolute time
+    bool ScheduleIn(uint64_t delay, simEventHandler_t handler, void *context);   //Run handler after a delay
+    void RunUntil(uint64_t time);                     //Advance virtual time, dispatching everything due
+    void RunFor(uint64_t duration);                   //Advance virtual time by a duration
+    void AttachTimerHook(simTimer_t timer,            //Observe every cycle of a timer source (waveform outputs)
+                         simEventHandler_t hook, void *context);
+
+    static class HostSimulator *GetInstancePtr();
+
+  private:
+    void SyncTimers();
+    void SyncCounters();
+    uint64_t ComputeTimerPeriod(simTimer_t timer);
+    void PushEvent(const simEvent_t &event);
+    void PopEvent(simEvent_t *event);
+    static unsigned long VirtualMicros(void);
+    static void VirtualDelay(unsigned long us);
+
+    // member variables
+    uint64_t now;                                   //Virtual time in CPU clock cycles
+    uint8_t microsResolution;                       //micros() granularity in microseconds
+    uint32_t sequence;                              //Tie breaker so events at the same time run in order
+    uint32_t eventCount;                            //Number of events dispatched
+    uint8_t numberOfEvents;                         //Number of events in the heap
+    simEvent_t events[Sim_Max_Events];              //Binary min-heap of pending events
+    simTimerState_t timers[SIM_TIMER_COUNT];        //State of the register driven timer sources
+    static class HostSimulator *instancePtr;        //Pointer so the HAL time callbacks can reach the instance
+};
+
+#endif /* #ifndef __HOST_SIMULATOR_H_INCLUDED */
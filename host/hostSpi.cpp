@@ -0,0 +1,62 @@
+/******************************************************//**
+ * @file    hostSpi.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Host implementation of the Arduino SPI library
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include <SPI.h>
+#include "hostHal.h"
+
+SPIClass SPI;
+
+static hostSpiTransfer_t spiDevice = NULL;
+static uint32_t spiByteCount = 0;
+
+/******************************************************//**
+ * @brief  Attaches the device model that answers SPI transfers.
+ * Without a device every transfer reads back 0x00.
+ * @param  transfer Called with each byte sent, returns the byte received
+ * @retval None
+ **********************************************************/
+void HostAttachSpiDevice(hostSpiTransfer_t transfer)
+{
+  spiDevice = transfer;
+}
+
+/******************************************************//**
+ * @brief  Returns the number of bytes transferred on the bus
+ * @param  None
+ * @retval byte count
+ **********************************************************/
+uint32_t HostGetSpiByteCount(void)
+{
+  return spiByteCount;
+}
+
+void SPIClass::begin()
+{
+  pinMode(SS, OUTPUT);
+  digitalWrite(SS, HIGH);
+  pinMode(SCK, OUTPUT);
+  pinMode(MOSI, OUTPUT);
+}
+
+void SPIClass::end() {}
+void SPIClass::beginTransaction(SPISettings settings) { (void)settings; }
+void SPIClass::endTransaction() {}
+void SPIClass::setBitOrder(uint8_t bitOrder) { (void)bitOrder; }
+void SPIClass::setDataMode(uint8_t dataMode) { (void)dataMode; }
+void SPIClass::setClockDivider(uint8_t clockDiv) { (void)clockDiv; }
+
+uint8_t SPIClass::transfer(uint8_t data)
+{
+  spiByteCount++;
+  return spiDevice != NULL ? spiDevice(data) : 0;
+}
@@ -0,0 +1,122 @@
+/******************************************************//**
+ * @file    Arduino.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Host (Linux) stand-in for the Arduino Uno core so the
+ *          firmware compiles and runs unmodified on a workstation
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __HOST_ARDUINO_H_INCLUDED
+#define __HOST_ARDUINO_H_INCLUDED
+
+#include <inttypes.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <avr/io.h>
+#include <avr/interrupt.h>
+#include <avr/pgmspace.h>
+
+/// Marks a build against the host HAL rather than the AVR core
+#define HOST_HAL (1)
+
+#ifndef F_CPU
+#define F_CPU 16000000L
+#endif
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT        0x0
+#define OUTPUT       0x1
+#define INPUT_PULLUP 0x2
+
+#define CHANGE  1
+#define FALLING 2
+#define RISING  3
+
+#define PI         3.1415926535897932384626433832795
+#define HALF_PI    1.5707963267948966192313216916398
+#define TWO_PI     6.283185307179586476925286766559
+#define DEG_TO_RAD 0.017453292519943295769236907684886
+#define RAD_TO_DEG 57.295779513082320876798154814105
+
+#define LSBFIRST 0
+#define MSBFIRST 1
+
+#define NOT_AN_INTERRUPT -1
+
+/// Uno pin assignments used by the SPI peripheral
+#define SS   (10)
+#define MOSI (11)
+#define MISO (12)
+#define SCK  (13)
+
+/// Number of digital pins on the Uno (0..13 plus A0..A5 as 14..19)
+#define NUM_DIGITAL_PINS (20)
+
+#define digitalPinToInterrupt(p) ((p) == 2 ? 0 : ((p) == 3 ? 1 : NOT_AN_INTERRUPT))
+
+/// Pin to port and pin change interrupt mapping of the Uno core (pins_arduino.h)
+#define NOT_A_PORT 0
+#define PB 2
+#define PC 3
+#define PD 4
+#define digitalPinToPort(p)     ((p) < 8 ? PD : ((p) < 14 ? PB : ((p) < NUM_DIGITAL_PINS ? PC : NOT_A_PORT)))
+#define digitalPinToBitMask(p)  _BV((p) < 8 ? (p) : ((p) < 14 ? (p) - 8 : (p) - 14))
+#define portInputRegister(P)    ((P) == PD ? &PIND : ((P) == PB ? &PINB : ((P) == PC ? &PINC : (volatile uint8_t *)0)))
+#define digitalPinToPCICR(p)    ((p) < NUM_DIGITAL_PINS ? &PCICR : (volatile uint8_t *)0)
+#define digitalPinToPCICRbit(p) ((p) <= 7 ? 2 : ((p) <= 13 ? 0 : 1))
+#define digitalPinToPCMSK(p)    ((p) <= 7 ? &PCMSK2 : ((p) <= 13 ? &PCMSK0 : &PCMSK1))
+#define digitalPinToPCMSKbit(p) ((p) <= 7 ? (p) : ((p) <= 13 ? (p) - 8 : (p) - 14))
+
+#define interrupts()   sei()
+#define noInterrupts() cli()
+
+typedef bool boolean;
+typedef uint8_t byte;
+
+void pinMode(uint8_t pin, uint8_t mode);
+void digitalWrite(uint8_t pin, uint8_t val);
+int digitalRead(uint8_t pin);
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(unsigned long ms);
+void delayMicroseconds(unsigned int us);
+
+void attachInterrupt(uint8_t interruptNum, void (*userFunc)(void), int mode);
+void detachInterrupt(uint8_t interruptNum);
+
+/// Minimal Serial replacement that writes to stdout
+class HardwareSerial
+{
+  public:
+    void begin(unsigned long baud);
+    void end();
+    size_t print(const char *str);
+    size_t print(char c);
+    size_t print(int n);
+    size_t print(unsigned int n);
+    size_t print(long n);
+    size_t print(unsigned long n);
+    size_t print(double n, int digits = 2);
+    size_t println(void);
+    size_t println(const char *str);
+    size_t println(char c);
+    size_t println(int n);
+    size_t println(unsigned int n);
+    size_t println(long n);
+    size_t println(unsigned long n);
+    size_t println(double n, int digits = 2);
+};
+
+extern HardwareSerial Serial;
+
+#endif /* #ifndef __HOST_ARDUINO_H_INCLUDED */
@@ -0,0 +1,60 @@
+/******************************************************//**
+ * @file    SPI.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Host stand-in for the Arduino SPI library. Bytes are
+ *          handed to the device attached with HostAttachSpiDevice
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __HOST_SPI_H_INCLUDED
+#define __HOST_SPI_H_INCLUDED
+
+#include <Arduino.h>
+
+#define SPI_CLOCK_DIV4   0x00
+#define SPI_CLOCK_DIV16  0x01
+#define SPI_CLOCK_DIV64  0x02
+#define SPI_CLOCK_DIV128 0x03
+#define SPI_CLOCK_DIV2   0x04
+#define SPI_CLOCK_DIV8   0x05
+#define SPI_CLOCK_DIV32  0x06
+
+#define SPI_MODE0 0x00
+#define SPI_MODE1 0x04
+#define SPI_MODE2 0x08
+#define SPI_MODE3 0x0C
+
+/// Transaction settings, kept only so sketches written against them compile
+class SPISettings
+{
+  public:
+    SPISettings() : clock(4000000), bitOrder(MSBFIRST), dataMode(SPI_MODE0) {}
+    SPISettings(uint32_t clock, uint8_t bitOrder, uint8_t dataMode) :
+      clock(clock), bitOrder(bitOrder), dataMode(dataMode) {}
+    uint32_t clock;
+    uint8_t bitOrder;
+    uint8_t dataMode;
+};
+
+class SPIClass
+{
+  public:
+    void begin();
+    void end();
+    void beginTransaction(SPISettings settings);
+    void endTransaction();
+    void setBitOrder(uint8_t bitOrder);
+    void setDataMode(uint8_t dataMode);
+    void setClockDivider(uint8_t clockDiv);
+    uint8_t transfer(uint8_t data);
+};
+
+extern SPIClass SPI;
+
+#endif /* #ifndef __HOST_SPI_H_INCLUDED */
@@ -0,0 +1,27 @@
+/******************************************************//**
+ * @file    interrupt.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Host stand-in for avr/interrupt.h. ISR() declares
+ *          a plain C function the host HAL dispatches by name
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __HOST_AVR_INTERRUPT_H_INCLUDED
+#define __HOST_AVR_INTERRUPT_H_INCLUDED
+
+#include <avr/io.h>
+
+/// Defines an interrupt handler the host HAL can find through a weak reference
+#define ISR(vector, ...) extern "C" void vector(void); void vector(void)
+
+/// Global interrupt enable and disable (the I bit of SREG)
+void sei(void);
+void cli(void);
+
+#endif /* #ifndef __HOST_AVR_INTERRUPT_H_INCLUDED */
@@ -0,0 +1,166 @@
+/******************************************************//**
+ * @file    io.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Host stand-in for the ATmega328P special function
+ *          registers used by the firmware
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __HOST_AVR_IO_H_INCLUDED
+#define __HOST_AVR_IO_H_INCLUDED
+
+#include <inttypes.h>
+
+/// Register access macros as provided by avr/sfr_defs.h
+#define _BV(bit)        (1 << (bit))
+#define _SFR_BYTE(sfr)  (sfr)
+
+/* The registers are plain memory on the host. Nothing happens when they are
+ * written, the host HAL and the simulator read them back to decide which
+ * interrupt sources are enabled and how fast the timers run. */
+
+/// External interrupts
+extern volatile uint8_t EICRA;
+extern volatile uint8_t EIMSK;
+extern volatile uint8_t EIFR;
+
+/// Pin change interrupts
+extern volatile uint8_t PCICR;
+extern volatile uint8_t PCIFR;
+extern volatile uint8_t PCMSK0;
+extern volatile uint8_t PCMSK1;
+extern volatile uint8_t PCMSK2;
+
+/// I/O ports (B = digital 8..13, C = analog 0..5, D = digital 0..7)
+extern volatile uint8_t PINB;
+extern volatile uint8_t DDRB;
+extern volatile uint8_t PORTB;
+extern volatile uint8_t PINC;
+extern volatile uint8_t DDRC;
+extern volatile uint8_t PORTC;
+extern volatile uint8_t PIND;
+extern volatile uint8_t DDRD;
+extern volatile uint8_t PORTD;
+
+/// Timer/Counter 0
+extern volatile uint8_t TCCR0A;
+extern volatile uint8_t TCCR0B;
+extern volatile uint8_t TCNT0;
+extern volatile uint8_t OCR0A;
+extern volatile uint8_t OCR0B;
+extern volatile uint8_t TIMSK0;
+extern volatile uint8_t TIFR0;
+
+/// Timer/Counter 1
+extern volatile uint8_t TCCR1A;
+extern volatile uint8_t TCCR1B;
+extern volatile uint8_t TCCR1C;
+extern volatile uint16_t TCNT1;
+extern volatile uint16_t ICR1;
+extern volatile uint16_t OCR1A;
+extern volatile uint16_t OCR1B;
+extern volatile uint8_t TIMSK1;
+extern volatile uint8_t TIFR1;
+
+/// Timer/Counter 2
+extern volatile uint8_t TCCR2A;
+extern volatile uint8_t TCCR2B;
+extern volatile uint8_t TCNT2;
+extern volatile uint8_t OCR2A;
+extern volatile uint8_t OCR2B;
+extern volatile uint8_t ASSR;
+extern volatile uint8_t TIMSK2;
+extern volatile uint8_t TIFR2;
+
+/// EICRA bits
+#define ISC00   0
+#define ISC01   1
+#define ISC10   2
+#define ISC11   3
+
+/// EIMSK / EIFR bits
+#define INT0    0
+#define INT1    1
+#define INTF0   0
+#define INTF1   1
+
+/// PCICR / PCIFR bits
+#define PCIE0   0
+#define PCIE1   1
+#define PCIE2   2
+#define PCIF0   0
+#define PCIF1   1
+#define PCIF2   2
+
+/// TCCR0A / TCCR0B bits
+#define WGM00   0
+#define WGM01   1
+#define COM0B0  4
+#define COM0B1  5
+#define COM0A0  6
+#define COM0A1  7
+#define CS00    0
+#define CS01    1
+#define CS02    2
+#define WGM02   3
+
+/// TIMSK0 / TIFR0 bits
+#define TOIE0   0
+#define OCIE0A  1
+#define OCIE0B  2
+#define TOV0    0
+#define OCF0A   1
+#define OCF0B   2
+
+/// TCCR1A / TCCR1B bits
+#define WGM10   0
+#define WGM11   1
+#define COM1B0  4
+#define COM1B1  5
+#define COM1A0  6
+#define COM1A1  7
+#define CS10    0
+#define CS11    1
+#define CS12    2
+#define WGM12   3
+#define WGM13   4
+#define ICES1   6
+#define ICNC1   7
+
+/// TIMSK1 / TIFR1 bits
+#define TOIE1   0
+#define OCIE1A  1
+#define OCIE1B  2
+#define ICIE1   5
+#define TOV1    0
+#define OCF1A   1
+#define OCF1B   2
+#define ICF1    5
+
+/// TCCR2A / TCCR2B bits
+#define WGM20   0
+#define WGM21   1
+#define COM2B0  4
+#define COM2B1  5
+#define COM2A0  6
+#define COM2A1  7
+#define CS20    0
+#define CS21    1
+#define CS22    2
+#define WGM22   3
+
+/// TIMSK2 / TIFR2 bits
+#define TOIE2   0
+#define OCIE2A  1
+#define OCIE2B  2
+#define TOV2    0
+#define OCF2A   1
+#define OCF2B   2
+
+#endif /* #ifndef __HOST_AVR_IO_H_INCLUDED */
@@ -0,0 +1,29 @@
+/******************************************************//**
+ * @file    pgmspace.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Host stand-in for avr/pgmspace.h. The host has one
+ *          address space, so PROGMEM data is ordinary const data
+ *          and the pgm_read macros are plain loads
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __HOST_AVR_PGMSPACE_H_INCLUDED
+#define __HOST_AVR_PGMSPACE_H_INCLUDED
+
+#include <inttypes.h>
+
+/// Places data in flash on the target, nothing on the host
+#define PROGMEM
+
+/// Reads from flash on the target
+#define pgm_read_byte(address)  (*(const uint8_t *)(address))
+#define pgm_read_word(address)  (*(const uint16_t *)(address))
+#define pgm_read_dword(address) (*(const uint32_t *)(address))
+
+#endif /* #ifndef __HOST_AVR_PGMSPACE_H_INCLUDED */
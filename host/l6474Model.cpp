@@ -0,0 +1,688 @@
+/******************************************************//**
+ * @file    l6474Model.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Register-level model of a daisy chain of L6474 stepper
+ *          drivers on the host SPI bus
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "l6474Model.h"
+
+/// STATUS flags that are active low, set while no fault is latched
+#define L6474_MODEL_STATUS_ACTIVE_LOW  (L6474_STATUS_UVLO | L6474_STATUS_TH_WRN | L6474_STATUS_TH_SD | L6474_STATUS_OCD)
+
+/// static member definitions
+class L6474Model* L6474Model::instancePtr = NULL;
+
+/// DIR pin of each device
+static const uint8_t directionPins[MAX_NUMBER_OF_SHIELDS] = {L6474_DIR_1_Pin, L6474_DIR_2_Pin, L6474_DIR_3_Pin};
+
+/******************************************************//**
+ * @brief  Constructor for the model. Devices start with their
+ * power-up register values.
+ * @param  None
+ * @retval None
+ **********************************************************/
+L6474Model::L6474Model()
+{
+  numberOfDevices = 1;
+  selected = false;
+  burstBytes = 0;
+  attached = false;
+  flagAsserted = false;
+  stepHook = NULL;
+  stepHookContext = NULL;
+  ResetDevices();
+  ResetSpiStats();
+  instancePtr = this;
+}
+
+/******************************************************//**
+ * @brief  Attaches the model to the SPI bus, the SS chip select,
+ * the reset pin and the FLAG pin of the host HAL
+ * @param  nbDevices Number of L6474 in the daisy chain (1 to 3)
+ * @retval None
+ **********************************************************/
+void L6474Model::Begin(uint8_t nbDevices)
+{
+  numberOfDevices = nbDevices < 1 ? 1 : (nbDevices > MAX_NUMBER_OF_SHIELDS ? MAX_NUMBER_OF_SHIELDS : nbDevices);
+  instancePtr = this;
+  ResetDevices();
+  HostAttachSpiDevice(SpiTransfer);
+  HostAttachPinWriteHook(SS, ChipSelect);
+  HostAttachPinWriteHook(L6474_Reset_Pin, ResetPin);
+  attached = true;
+  flagAsserted = false;
+  HostSetPinLevel(L6474_FLAG_Pin, HIGH);
+}
+
+/******************************************************//**
+ * @brief  Detaches the model from the host HAL and releases the
+ * FLAG pin
+ * @param  None
+ * @retval None
+ **********************************************************/
+void L6474Model::End()
+{
+  HostAttachSpiDevice(NULL);
+  HostAttachPinWriteHook(SS, NULL);
+  HostAttachPinWriteHook(L6474_Reset_Pin, NULL);
+  attached = false;
+  if (flagAsserted)
+  {
+    flagAsserted = false;
+    HostSetPinLevel(L6474_FLAG_Pin, HIGH);
+  }
+}
+
+/******************************************************//**
+ * @brief  Takes STEP pulses from the simulated timers that drive
+ * the step clock pins: timer 1 (OC1A, pin 9) for shield 0, timer 2
+ * (OC2B, pin 3) for shield 1 and timer 0 (OC0A, pin 6) for shield 2.
+ * Each PWM period is one pulse.
+ * @param  simulator Simulator clocking the timers
+ * @retval None
+ **********************************************************/
+void L6474Model::AttachToSimulator(HostSimulator *simulator)
+{
+  simulator->AttachTimerHook(SIM_TIMER_1_OVF, StepClock0, this);
+  simulator->AttachTimerHook(SIM_TIMER_2_OVF, StepClock1, this);
+  simulator->AttachTimerHook(SIM_TIMER_0_OVF, StepClock2, this);
+}
+
+/******************************************************//**
+ * @brief  Registers a function called after every STEP pulse with
+ * the device and the direction it moved
+ * @param  hook Function to call, NULL to detach
+ * @param  context Pointer handed back to the hook
+ * @retval None
+ **********************************************************/
+void L6474Model::AttachStepHook(l6474ModelStepHook_t hook, void *context)
+{
+  stepHook = hook;
+  stepHookContext = context;
+}
+
+/******************************************************//**
+ * @brief  Applies one STEP pulse. ABS_POS moves one step of the
+ * selected resolution and EL_POS moves by the matching fraction
+ * of an electrical cycle (128 per full step) in the direction
+ * given by the DIR pin.
+ * @param  deviceId Device (from 0 to 2)
+ * @retval None
+ **********************************************************/
+void L6474Model::Step(uint8_t deviceId)
+{
+  if (deviceId >= numberOfDevices)
+  {
+    return;
+  }
+
+  l6474ModelDevice_t *device = &devices[deviceId];
+  int8_t direction = HostGetPinLevel(directionPins[deviceId]) == FORWARD ? 1 : -1;
+  uint8_t stepSel = device->stepMode & L6474_STEP_MODE_STEP_SEL;
+  uint16_t elStep = 128 >> (stepSel > 4 ? 4 : stepSel);
+
+  if (direction > 0)
+  {
+    device->absPos = (device->absPos + 1) & L6474_ABS_POS_VALUE_MASK;
+    device->elPos = (device->elPos + elStep) & 0x1FF;
+    device->status |= L6474_STATUS_DIR;
+  }
+  else
+  {
+    device->absPos = (device->absPos - 1) & L6474_ABS_POS_VALUE_MASK;
+    device->elPos = (device->elPos - elStep) & 0x1FF;
+    device->status &= ~L6474_STATUS_DIR;
+  }
+  device->stepCount++;
+
+  if (stepHook != NULL)
+  {
+    stepHook(deviceId, direction, stepHookContext);
+  }
+}
+
+/******************************************************//**
+ * @brief  Puts every device back to the power-up register values
+ * of the L6474 datasheet with the bridges in high impedance
+ * @param  None
+ * @retval None
+ **********************************************************/
+void L6474Model::ResetDevices()
+{
+  for (uint8_t i = 0; i < MAX_NUMBER_OF_SHIELDS; i++)
+  {
+    l6474ModelDevice_t *device = &devices[i];
+    device->absPos = 0;
+    device->elPos = 0;
+    device->mark = 0;
+    device->tval = 0x29;
+    device->tFast = 0x19;
+    device->tonMin = 0x29;
+    device->toffMin = 0x29;
+    device->adcOut = 0;
+    device->ocdTh = 0x08;
+    device->stepMode = 0x07;
+    device->alarmEn = 0xFF;
+    device->config = 0x2E88;
+    device->status = L6474_MODEL_STATUS_ACTIVE_LOW | L6474_STATUS_HIZ;
+    device->command = MODEL_CMD_NOP;
+    device->param = 0;
+    device->argumentBytes = 0;
+    device->argument = 0;
+    device->responseLength = 0;
+    device->responseIndex = 0;
+    device->shiftRegister = 0;
+    device->stepCount = 0;
+  }
+}
+
+/******************************************************//**
+ * @brief  Reads a register directly
+ * @param  deviceId Device (from 0 to 2)
+ * @param  param Register address (L6474_ABS_POS, L6474_MARK,...)
+ * @retval Register value, 0 for reserved addresses
+ **********************************************************/
+uint32_t L6474Model::GetRegister(uint8_t deviceId, uint8_t param)
+{
+  l6474ModelDevice_t *device = &devices[deviceId % MAX_NUMBER_OF_SHIELDS];
+  switch (param)
+  {
+    case L6474_ABS_POS:   return device->absPos;
+    case L6474_EL_POS:    return device->elPos;
+    case L6474_MARK:      return device->mark;
+    case L6474_TVAL:      return device->tval;
+    case L6474_T_FAST:    return device->tFast;
+    case L6474_TON_MIN:   return device->tonMin;
+    case L6474_TOFF_MIN:  return device->toffMin;
+    case L6474_ADC_OUT:   return device->adcOut;
+    case L6474_OCD_TH:    return device->ocdTh;
+    case L6474_STEP_MODE: return device->stepMode;
+    case L6474_ALARM_EN:  return device->alarmEn;
+    case L6474_CONFIG:    return device->config;
+    case L6474_STATUS:    return device->status;
+    default:              return 0;
+  }
+}
+
+/******************************************************//**
+ * @brief  Writes a register directly, masked to its width.
+ * STATUS and ADC_OUT can be written here to inject conditions;
+ * a condition whose alarm is enabled pulls FLAG low at once.
+ * @param  deviceId Device (from 0 to 2)
+ * @param  param Register address (L6474_ABS_POS, L6474_MARK,...)
+ * @param  value Value to write
+ * @retval None
+ **********************************************************/
+void L6474Model::SetRegister(uint8_t deviceId, uint8_t param, uint32_t value)
+{
+  WriteRegister(&devices[deviceId % MAX_NUMBER_OF_SHIELDS], param, value);
+  UpdateFlag();
+}
+
+/******************************************************//**
+ * @brief  Writes a register, masked to its width. The FLAG pin
+ * follows once the burst is latched.
+ * @param  device Device to write
+ * @param  param Register address (L6474_ABS_POS, L6474_MARK,...)
+ * @param  value Value to write
+ * @retval None
+ **********************************************************/
+void L6474Model::WriteRegister(l6474ModelDevice_t *device, uint8_t param, uint32_t value)
+{
+  switch (param)
+  {
+    case L6474_ABS_POS:   device->absPos = value & L6474_ABS_POS_VALUE_MASK; break;
+    case L6474_EL_POS:    device->elPos = value & 0x1FF; break;
+    case L6474_MARK:      device->mark = value & L6474_ABS_POS_VALUE_MASK; break;
+    case L6474_TVAL:      device->tval = value & 0x7F; break;
+    case L6474_T_FAST:    device->tFast = value; break;
+    case L6474_TON_MIN:   device->tonMin = value & 0x7F; break;
+    case L6474_TOFF_MIN:  device->toffMin = value & 0x7F; break;
+    case L6474_ADC_OUT:   device->adcOut = value & 0x1F; break;
+    case L6474_OCD_TH:    device->ocdTh = value & 0x0F; break;
+    case L6474_STEP_MODE: device->stepMode = value; break;
+    case L6474_ALARM_EN:  device->alarmEn = value; break;
+    case L6474_CONFIG:    device->config = value; break;
+    case L6474_STATUS:    device->status = value; break;
+    default:              break;
+  }
+}
+
+/******************************************************//**
+ * @brief  Returns ABS_POS sign extended from its 22 bits
+ * @param  deviceId Device (from 0 to 2)
+ * @retval position in steps
+ **********************************************************/
+int32_t L6474Model::GetPosition(uint8_t deviceId)
+{
+  uint32_t absPos = devices[deviceId % MAX_NUMBER_OF_SHIELDS].absPos;
+  return (absPos & L6474_ABS_POS_SIGN_BIT_MASK) ? (int32_t)(absPos | ~L6474_ABS_POS_VALUE_MASK) : (int32_t)absPos;
+}
+
+/******************************************************//**
+ * @brief  Returns the number of STEP pulses a device received
+ * @param  deviceId Device (from 0 to 2)
+ * @retval step count
+ **********************************************************/
+uint32_t L6474Model::GetStepCount(uint8_t deviceId)
+{
+  return devices[deviceId % MAX_NUMBER_OF_SHIELDS].stepCount;
+}
+
+/******************************************************//**
+ * @brief  Returns whether the power bridge of a device is on
+ * @param  deviceId Device (from 0 to 2)
+ * @retval true if ENABLE was the last bridge command
+ **********************************************************/
+bool L6474Model::IsEnabled(uint8_t deviceId)
+{
+  return !(devices[deviceId % MAX_NUMBER_OF_SHIELDS].status & L6474_STATUS_HIZ);
+}
+
+/******************************************************//**
+ * @brief  Returns whether the FLAG pin is pulled low
+ * @param  None
+ * @retval true while a device has a latched alarm enabled in ALARM_EN
+ **********************************************************/
+bool L6474Model::IsFlagAsserted()
+{
+  return flagAsserted;
+}
+
+/******************************************************//**
+ * @brief  Returns the SPI traffic attributed to a command type.
+ * A burst belongs to the command that one of the devices started
+ * or is still receiving arguments for or answering.
+ * @param  command Command type
+ * @retval calls, bursts and bytes of the command
+ **********************************************************/
+l6474ModelSpiStats_t L6474Model::GetSpiStats(l6474ModelCommand_t command)
+{
+  return spiStats[command < MODEL_CMD_COUNT ? command : MODEL_CMD_WRONG];
+}
+
+/******************************************************//**
+ * @brief  Returns the SPI traffic of all command types
+ * @param  None
+ * @retval calls, bursts and bytes
+ **********************************************************/
+l6474ModelSpiStats_t L6474Model::GetSpiTotals()
+{
+  l6474ModelSpiStats_t totals = {0, 0, 0};
+  for (uint8_t i = 0; i < MODEL_CMD_COUNT; i++)
+  {
+    totals.calls += spiStats[i].calls;
+    totals.bursts += spiStats[i].bursts;
+    totals.bytes += spiStats[i].bytes;
+  }
+  return totals;
+}
+
+/******************************************************//**
+ * @brief  Returns the number of bursts that did not shift
+ * exactly one byte per device in the chain
+ * @param  None
+ * @retval error count
+ **********************************************************/
+uint32_t L6474Model::GetChainErrors()
+{
+  return chainErrors;
+}
+
+/******************************************************//**
+ * @brief  Clears the SPI traffic statistics
+ * @param  None
+ * @retval None
+ **********************************************************/
+void L6474Model::ResetSpiStats()
+{
+  memset(spiStats, 0, sizeof(spiStats));
+  chainErrors = 0;
+}
+
+/******************************************************//**
+ * @brief  Gets the pointer to the L6474Model instance
+ * @param  None
+ * @retval Pointer to the instance of L6474Model
+ **********************************************************/
+class L6474Model* L6474Model::GetInstancePtr()
+{
+  return instancePtr;
+}
+
+/******************************************************//**
+ * @brief  Returns a printable name for a command type
+ * @param  command Command type
+ * @retval name
+ **********************************************************/
+const char *L6474Model::GetCommandName(l6474ModelCommand_t command)
+{
+  switch (command)
+  {
+    case MODEL_CMD_NOP:        return "NOP";
+    case MODEL_CMD_SET_PARAM:  return "SET_PARAM";
+    case MODEL_CMD_GET_PARAM:  return "GET_PARAM";
+    case MODEL_CMD_ENABLE:     return "ENABLE";
+    case MODEL_CMD_DISABLE:    return "DISABLE";
+    case MODEL_CMD_GET_STATUS: return "GET_STATUS";
+    default:                   return "WRONG_CMD";
+  }
+}
+
+/******************************************************//**
+ * @brief  Chip select rising edge: every device latches the byte
+ * in its shift register and acts on it, then the burst is added
+ * to the statistics of the command it belongs to.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void L6474Model::Latch()
+{
+  l6474ModelCommand_t burstCommand = MODEL_CMD_NOP;
+  uint32_t callsStarted = 0;
+
+  if (burstBytes != numberOfDevices)
+  {
+    chainErrors++;
+  }
+
+  for (uint8_t i = 0; i < numberOfDevices; i++)
+  {
+    l6474ModelDevice_t *device = &devices[i];
+    bool busy = device->argumentBytes != 0 || device->responseIndex < device->responseLength;
+
+    ProcessByte(device, device->shiftRegister);
+
+    if (busy || device->command != MODEL_CMD_NOP)
+    {
+      burstCommand = device->command;
+      callsStarted += busy ? 0 : 1;
+    }
+  }
+
+  if (burstCommand == MODEL_CMD_NOP)
+  {
+    callsStarted = 1;
+  }
+  spiStats[burstCommand].calls += callsStarted;
+  spiStats[burstCommand].bursts++;
+  spiStats[burstCommand].bytes += burstBytes;
+}
+
+/******************************************************//**
+ * @brief  Acts on one latched byte: shifts out the next response
+ * byte, collects a SET_PARAM argument or decodes a new command
+ * @param  device Device that latched the byte
+ * @param  data Latched byte
+ * @retval None
+ **********************************************************/
+void L6474Model::ProcessByte(l6474ModelDevice_t *device, uint8_t data)
+{
+  if (device->responseIndex < device->responseLength)
+  {
+    /* the byte shifted in while answering is ignored */
+    device->responseIndex++;
+    return;
+  }
+
+  if (device->argumentBytes != 0)
+  {
+    device->argument = (device->argument << 8) | data;
+    if (--device->argumentBytes == 0)
+    {
+      if (device->param == L6474_STATUS || device->param == L6474_ADC_OUT)
+      {
+        device->status |= L6474_STATUS_NOTPERF_CMD;
+      }
+      else
+      {
+        WriteRegister(device, device->param, device->argument);
+      }
+    }
+    return;
+  }
+
+  device->responseLength = 0;
+  device->responseIndex = 0;
+
+  switch (data)
+  {
+    case L6474_ENABLE:
+      device->command = MODEL_CMD_ENABLE;
+      device->status &= ~L6474_STATUS_HIZ;
+      return;
+    case L6474_DISABLE:
+      device->command = MODEL_CMD_DISABLE;
+      device->status |= L6474_STATUS_HIZ;
+      return;
+    case L6474_GET_STATUS:
+      /* answer with the latched flags, then release them */
+      device->command = MODEL_CMD_GET_STATUS;
+      LoadResponse(device, device->status, 2);
+      device->status |= L6474_MODEL_STATUS_ACTIVE_LOW;
+      device->status &= ~(L6474_STATUS_NOTPERF_CMD | L6474_STATUS_WRONG_CMD);
+      return;
+    default:
+      break;
+  }
+
+  device->param = data & 0x1F;
+  switch (data & 0xE0)
+  {
+    case L6474_GET_PARAM:
+      device->command = MODEL_CMD_GET_PARAM;
+      LoadResponse(device, GetRegister(device - devices, device->param), GetParamLength(device->param));
+      break;
+    case L6474_SET_PARAM:
+      if (device->param == 0)
+      {
+        device->command = MODEL_CMD_NOP;
+      }
+      else
+      {
+        device->command = MODEL_CMD_SET_PARAM;
+        device->argumentBytes = GetParamLength(device->param);
+        device->argument = 0;
+      }
+      break;
+    default:
+      device->command = MODEL_CMD_WRONG;
+      device->status |= L6474_STATUS_WRONG_CMD;
+      break;
+  }
+}
+
+/******************************************************//**
+ * @brief  Drives the open drain FLAG output shared by the chain:
+ * low while any device has a latched condition whose alarm is
+ * enabled, released by GET_STATUS. Falling FLAG raises INT0.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void L6474Model::UpdateFlag()
+{
+  bool asserted = false;
+  for (uint8_t i = 0; i < numberOfDevices; i++)
+  {
+    asserted |= (GetActiveAlarms(&devices[i]) & devices[i].alarmEn) != 0;
+  }
+
+  if (attached && asserted != flagAsserted)
+  {
+    flagAsserted = asserted;
+    HostSetPinLevel(L6474_FLAG_Pin, asserted ? LOW : HIGH);
+  }
+}
+
+/******************************************************//**
+ * @brief  Returns the ALARM_EN bits of the conditions latched in
+ * STATUS. UVLO, TH_WRN, TH_SD and OCD are active low.
+ * @param  device Device to check
+ * @retval L6474_ALARM_EN_t bits
+ **********************************************************/
+uint8_t L6474Model::GetActiveAlarms(const l6474ModelDevice_t *device)
+{
+  uint16_t status = device->status;
+  uint8_t alarms = 0;
+  alarms |= (status & L6474_STATUS_OCD) ? 0 : L6474_ALARM_EN_OVERCURRENT;
+  alarms |= (status & L6474_STATUS_TH_SD) ? 0 : L6474_ALARM_EN_THERMAL_SHUTDOWN;
+  alarms |= (status & L6474_STATUS_TH_WRN) ? 0 : L6474_ALARM_EN_THERMAL_WARNING;
+  alarms |= (status & L6474_STATUS_UVLO) ? 0 : L6474_ALARM_EN_UNDERVOLTAGE;
+  alarms |= (status & (L6474_STATUS_WRONG_CMD | L6474_STATUS_NOTPERF_CMD)) ? L6474_ALARM_EN_WRONG_NPERF_CMD : 0;
+  return alarms;
+}
+
+/******************************************************//**
+ * @brief  Queues the bytes a device shifts out on the next bursts
+ * @param  device Device answering
+ * @param  value Value to send, MSB first
+ * @param  length Number of bytes (1 to 3)
+ * @retval None
+ **********************************************************/
+void L6474Model::LoadResponse(l6474ModelDevice_t *device, uint32_t value, uint8_t length)
+{
+  for (uint8_t i = 0; i < length; i++)
+  {
+    device->response[i] = (uint8_t)(value >> (8 * (length - 1 - i)));
+  }
+  device->responseLength = length;
+  device->responseIndex = 0;
+}
+
+/******************************************************//**
+ * @brief  Returns the number of argument/response bytes of a
+ * register, matching the lengths CmdGetParam/CmdSetParam use
+ * @param  param Register address
+ * @retval length in bytes
+ **********************************************************/
+uint8_t L6474Model::GetParamLength(uint8_t param)
+{
+  switch (param)
+  {
+    case L6474_ABS_POS:
+    case L6474_MARK:
+      return 3;
+    case L6474_EL_POS:
+    case L6474_CONFIG:
+    case L6474_STATUS:
+      return 2;
+    default:
+      return 1;
+  }
+}
+
+/******************************************************//**
+ * @brief  SPI device hook. The chain is one long shift register:
+ * the byte sent enters device 0 and the byte received leaves the
+ * last device, so after one byte per device each device holds
+ * the byte addressed to it.
+ * @param  data Byte sent by the microcontroller
+ * @retval Byte received by the microcontroller
+ **********************************************************/
+uint8_t L6474Model::SpiTransfer(uint8_t data)
+{
+  L6474Model *model = instancePtr;
+  if (model == NULL || !model->selected)
+  {
+    return 0xFF;
+  }
+
+  uint8_t last = model->numberOfDevices - 1;
+  uint8_t received = model->devices[last].shiftRegister;
+  for (uint8_t i = last; i > 0; i--)
+  {
+    model->devices[i].shiftRegister = model->devices[i - 1].shiftRegister;
+  }
+  model->devices[0].shiftRegister = data;
+  model->burstBytes++;
+  return received;
+}
+
+/******************************************************//**
+ * @brief  SS pin hook. The falling edge loads each shift register
+ * with the device's next output byte, the rising edge latches.
+ * @param  pin SS
+ * @param  level New pin level
+ * @retval None
+ **********************************************************/
+void L6474Model::ChipSelect(uint8_t pin, uint8_t level)
+{
+  L6474Model *model = instancePtr;
+  (void)pin;
+  if (model == NULL)
+  {
+    return;
+  }
+
+  if (level == LOW && !model->selected)
+  {
+    model->selected = true;
+    model->burstBytes = 0;
+    for (uint8_t i = 0; i < model->numberOfDevices; i++)
+    {
+      l6474ModelDevice_t *device = &model->devices[i];
+      device->shiftRegister = device->responseIndex < device->responseLength ?
+                              device->response[device->responseIndex] : 0x00;
+    }
+  }
+  else if (level == HIGH && model->selected)
+  {
+    model->selected = false;
+    model->Latch();
+    model->UpdateFlag();
+  }
+}
+
+/******************************************************//**
+ * @brief  Reset pin hook, holding the pin low resets all devices
+ * @param  pin L6474_Reset_Pin
+ * @param  level New pin level
+ * @retval None
+ **********************************************************/
+void L6474Model::ResetPin(uint8_t pin, uint8_t level)
+{
+  (void)pin;
+  if (instancePtr != NULL && level == LOW)
+  {
+    instancePtr->ResetDevices();
+    instancePtr->UpdateFlag();
+  }
+}
+
+/******************************************************//**
+ * @brief  Timer hooks turning a PWM period into a STEP pulse
+ * while the compare output drives the step clock pin
+ * @param  context L6474Model instance
+ * @retval None
+ **********************************************************/
+void L6474Model::StepClock0(void *context)
+{
+  if (TCCR1A & _BV(COM1A1))
+  {
+    ((L6474Model *)context)->Step(0);
+  }
+}
+
+void L6474Model::StepClock1(void *context)
+{
+  if (TCCR2A & _BV(COM2B1))
+  {
+    ((L6474Model *)context)->Step(1);
+  }
+}
+
+void L6474Model::StepClock2(void *context)
+{
+  if (TCCR0A & _BV(COM0A0))
+  {
+    ((L6474Model *)context)->Step(2);
+  }
+}
@@ -0,0 +1,138 @@
+/******************************************************//**
+ * @file    l6474Model.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Register-level model of a daisy chain of L6474 stepper
+ *          drivers on the host SPI bus. Decodes the bytes clocked
+ *          out by L6474::WriteBytes, keeps the ABS_POS, EL_POS and
+ *          STATUS registers up to date from STEP pulses and counts
+ *          the SPI traffic of every command.
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __L6474_MODEL_H_INCLUDED
+#define __L6474_MODEL_H_INCLUDED
+
+#include "hostSimulator.h"
+#include "l6474.h"
+
+/// Time to clock one byte at SPI_CLOCK_DIV4 (4MHz), as set in L6474::Begin
+#define L6474_Model_Spi_Byte_Ns     (2000)
+
+/// Commands the model tells apart for the traffic statistics
+typedef enum {
+  MODEL_CMD_NOP = 0,
+  MODEL_CMD_SET_PARAM,
+  MODEL_CMD_GET_PARAM,
+  MODEL_CMD_ENABLE,
+  MODEL_CMD_DISABLE,
+  MODEL_CMD_GET_STATUS,
+  MODEL_CMD_WRONG,
+  MODEL_CMD_COUNT
+} l6474ModelCommand_t;
+
+/// SPI traffic attributed to one command type
+typedef struct {
+  uint32_t calls;   //Commands started
+  uint32_t bursts;  //Chip select cycles (one byte per device each)
+  uint32_t bytes;   //Bytes clocked on the bus
+} l6474ModelSpiStats_t;
+
+/// Observer of STEP pulses, direction is +1 for FORWARD and -1 for BACKWARD
+typedef void (*l6474ModelStepHook_t)(uint8_t deviceId, int8_t direction, void *context);
+
+/// State of one L6474 in the chain
+typedef struct {
+  /// registers
+  uint32_t absPos;
+  uint16_t elPos;
+  uint32_t mark;
+  uint8_t tval;
+  uint8_t tFast;
+  uint8_t tonMin;
+  uint8_t toffMin;
+  uint8_t adcOut;
+  uint8_t ocdTh;
+  uint8_t stepMode;
+  uint8_t alarmEn;
+  uint16_t config;
+  uint16_t status;
+
+  /// SPI protocol state
+  l6474ModelCommand_t command;  //Command in progress
+  uint8_t param;                //Register addressed by the command in progress
+  uint8_t argumentBytes;        //SET_PARAM bytes still to receive
+  uint32_t argument;            //SET_PARAM value received so far
+  uint8_t response[3];          //GET_PARAM/GET_STATUS bytes to shift out, MSB first
+  uint8_t responseLength;       //Number of bytes in response
+  uint8_t responseIndex;        //Next response byte to shift out
+  uint8_t shiftRegister;        //Byte in the device shift register during a burst
+
+  uint32_t stepCount;           //STEP pulses received
+} l6474ModelDevice_t;
+
+/// L6474Model library class
+class L6474Model
+{
+  public:
+    L6474Model();                                          //Constructor
+    void Begin(uint8_t nbDevices);                         //Attach to the SPI bus, SS and reset pins
+    void End();                                            //Detach from the host HAL
+    void AttachToSimulator(HostSimulator *simulator);      //Take STEP pulses from the timers driving the PWM pins
+    void AttachStepHook(l6474ModelStepHook_t hook,         //Observe every STEP pulse (plant models)
+                        void *context);
+
+    void Step(uint8_t deviceId);                           //Apply one STEP pulse in the direction of the DIR pin
+    void ResetDevices();                                   //Put every device back to its power-up register values
+
+    uint32_t GetRegister(uint8_t deviceId, uint8_t param); //Read a register without SPI traffic
+    void SetRegister(uint8_t deviceId, uint8_t param,      //Write a register without SPI traffic
+                     uint32_t value);
+    int32_t GetPosition(uint8_t deviceId);                 //ABS_POS as a signed step count
+    uint32_t GetStepCount(uint8_t deviceId);               //STEP pulses received since Begin
+    bool IsEnabled(uint8_t deviceId);                      //True when the power bridge is on (HiZ cleared)
+    bool IsFlagAsserted();                                 //True while a device pulls the FLAG pin low
+
+    l6474ModelSpiStats_t GetSpiStats(l6474ModelCommand_t command); //Traffic of one command type
+    l6474ModelSpiStats_t GetSpiTotals();                   //Traffic of all commands
+    uint32_t GetChainErrors();                             //Bursts whose length did not match the chain
+    void ResetSpiStats();                                  //Clear the traffic statistics
+
+    static class L6474Model *GetInstancePtr();
+    static const char *GetCommandName(l6474ModelCommand_t command);
+
+  private:
+    void Latch();
+    void ProcessByte(l6474ModelDevice_t *device, uint8_t data);
+    void LoadResponse(l6474ModelDevice_t *device, uint32_t value, uint8_t length);
+    void WriteRegister(l6474ModelDevice_t *device, uint8_t param, uint32_t value);
+    void UpdateFlag();
+    static uint8_t GetActiveAlarms(const l6474ModelDevice_t *device);
+    static uint8_t GetParamLength(uint8_t param);
+    static uint8_t SpiTransfer(uint8_t data);
+    static void ChipSelect(uint8_t pin, uint8_t level);
+    static void ResetPin(uint8_t pin, uint8_t level);
+    static void StepClock0(void *context);
+    static void StepClock1(void *context);
+    static void StepClock2(void *context);
+
+    // member variables
+    uint8_t numberOfDevices;                               //Devices in the daisy chain
+    bool selected;                                         //Chip select is asserted
+    uint8_t burstBytes;                                    //Bytes shifted in the current burst
+    bool attached;                                         //Begin was called, the model drives the FLAG pin
+    bool flagAsserted;                                     //FLAG pin level driven last, true for low
+    l6474ModelDevice_t devices[MAX_NUMBER_OF_SHIELDS];     //Device 0 is the one addressed as shield 0
+    l6474ModelSpiStats_t spiStats[MODEL_CMD_COUNT];        //Traffic per command type
+    uint32_t chainErrors;                                  //Bursts of the wrong length
+    l6474ModelStepHook_t stepHook;                         //Called after every STEP pulse
+    void *stepHookContext;                                 //Context given to stepHook
+    static class L6474Model *instancePtr;                  //Pointer so the HAL hooks can reach the instance
+};
+
+#endif /* #ifndef __L6474_MODEL_H_INCLUDED */
@@ -0,0 +1,766 @@
+/******************************************************//**
+ * @file    quadratureEdgeGenerator.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   A/B edge-stream generator for stress testing the
+ *          QuadratureEncoder interrupt handlers in virtual time
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "quadratureEdgeGenerator.h"
+#include <math.h>
+#include <string.h>
+
+/******************************************************//**
+ * @brief  Constructor for the generator, loads the default cost
+ * model with the CPU model enabled
+ * @param  None
+ * @retval None
+ **********************************************************/
+QuadratureEdgeGenerator::QuadratureEdgeGenerator()
+{
+  simulator = NULL;
+  target = NULL;
+  encoder = NULL;
+  pinA = Quadrature_Pulse_A_Pin;
+  pinB = Quadrature_Pulse_B_Pin;
+  vectorA = HOST_VECT_INT0;
+  vectorB = HOST_VECT_INT1;
+  cost.entry = Edge_Isr_Entry_Cycles;
+  cost.edge = Edge_Isr_Edge_Cycles;
+  cost.fastCount = Edge_Isr_Fast_Count_Cycles;
+  cost.slowCount = Edge_Isr_Slow_Count_Cycles;
+  cost.sample = Edge_Isr_Sample_Cycles;
+  cost.tick = Edge_Isr_Tick_Cycles;
+  cost.observer = Edge_Isr_Observer_Cycles;
+  cost.queue = Edge_Isr_Queue_Cycles;
+  cost.window = Edge_Isr_Window_Cycles;
+  cost.reversal = Edge_Isr_Reversal_Cycles;
+  cost.pinChange = Edge_Isr_Pin_Change_Cycles;
+  cpuModel = true;
+  phase = 0;
+  nextDirection = 0;
+  lineB = HIGH;
+  latchLevel = HIGH;
+  edgeFraction = 0.5;
+  randomState = 1;
+  dispatchScheduled = false;
+  cpuFreeTime = 0;
+}
+
+/******************************************************//**
+ * @brief  Attaches to the simulator and puts the encoder lines at
+ * the 11 rest level. A is wired to the T1 pin as well, and to the
+ * clock of the direction latch.
+ * @param  simulator Simulator providing virtual time
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::Begin(HostSimulator *simulator)
+{
+  this->simulator = simulator;
+  phase = 0;
+  lineB = HIGH;
+  latchLevel = HIGH;
+  HostSetPinLevel(Quadrature_Pulse_B_Pin, HIGH);
+  HostSetPinLevel(Quadrature_Pulse_A_Pin, HIGH);
+  HostSetPinLevel(Quadrature_Counter_Pin, HIGH);
+  simulator->AttachTimerHook(SIM_TIMER_2_COMPA, SampleTimerHook, this);
+}
+
+/******************************************************//**
+ * @brief  Detaches from the simulator
+ * @param  None
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::End()
+{
+  if (simulator != NULL)
+  {
+    simulator->AttachTimerHook(SIM_TIMER_2_COMPA, NULL, NULL);
+  }
+}
+
+/******************************************************//**
+ * @brief  Selects the encoder the streams play into. Its lines are
+ * driven to the levels of the current phase right away, and the
+ * edges request INT0/INT1 or the pin change interrupt of its port,
+ * whichever the encoder decodes them through. Hardware counting is
+ * only modelled for the encoder on pins 2 and 3.
+ * @param  newTarget Encoder, NULL for the one in slot 0 at each Run
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::SetEncoder(QuadratureEncoder *newTarget)
+{
+  target = newTarget;
+  if (target != NULL)
+  {
+    uint8_t state = phase & 0x03;
+    lineB = (state == 0 || state == 3) ? HIGH : LOW;
+    HostSetPinLevel(target->GetPulsePinB(), lineB);
+    HostSetPinLevel(target->GetPulsePinA(), (state == 0 || state == 1) ? HIGH : LOW);
+  }
+}
+
+/******************************************************//**
+ * @brief  Schedules the servicing of a request another source,
+ * such as a second encoder, latched while the CPU model holds the
+ * requests. Call after each HostSetPinLevel or HostRaiseInterrupt
+ * that happens outside the stream.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::NotifyRequest()
+{
+  if (HostInterruptsHeld())
+  {
+    RequestDispatch();
+  }
+}
+
+/******************************************************//**
+ * @brief  Replaces the handler cost model
+ * @param  newCost Cycles of each handler path
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::SetIsrCost(const edgeIsrCost_t &newCost)
+{
+  cost = newCost;
+}
+
+/******************************************************//**
+ * @brief  Returns the handler cost model
+ * @param  None
+ * @retval Cycles of each handler path
+ **********************************************************/
+edgeIsrCost_t QuadratureEdgeGenerator::GetIsrCost()
+{
+  return cost;
+}
+
+/******************************************************//**
+ * @brief  Selects whether handlers are delayed and spaced by their
+ * cost or run instantly on each edge like the plain HAL does
+ * @param  enabled true to model the CPU
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::SetCpuModel(bool enabled)
+{
+  cpuModel = enabled;
+}
+
+/******************************************************//**
+ * @brief  Plays an edge stream into the encoder pins and compares
+ * the firmware count with the same decoder reading the pins at the
+ * exact edge times. While the CPU model is on, the HAL holds the
+ * requests so they only latch, and the generator services them one
+ * at a time when the modelled CPU is free. Main loop code run from
+ * simulator events can still use noInterrupts()/interrupts().
+ * @param  newConfig Stream description
+ * @retval What the firmware made of the stream
+ **********************************************************/
+edgeStreamResult_t QuadratureEdgeGenerator::Run(const edgeStreamConfig_t &newConfig)
+{
+  encoder = target != NULL ? target : QuadratureEncoder::GetInstancePtr();
+  pinA = encoder->GetPulsePinA();
+  pinB = encoder->GetPulsePinB();
+  vectorA = LineVector(pinA);
+  vectorB = LineVector(pinB);
+
+  config = newConfig;
+  randomState = config.seed != 0 ? config.seed : 1;
+  startTime = simulator->GetTime();
+  endTime = startTime + (uint64_t)(config.duration * Sim_Ticks_Per_Second);
+  nextEdgeTime = 0.0;
+  edgeFraction = 0.5;
+  memset(&result, 0, sizeof(result));
+  result.firstMissTime = -1.0;
+  busyTicks = 0;
+  encoderBusyTicks = 0;
+  hostNanos = 0;
+
+  /* The B pin carries the direction latch while Timer 1 counts and B otherwise */
+  HostSetPinLevel(pinB, encoder->GetEdgeProcessing() == EDGE_PROCESS_COUNTER ? latchLevel : lineB);
+
+  referenceHistory = encoder->GetEncoderState();
+  referenceCount = 0;
+  firmwareCount = 0;
+  lastFirmwarePosition = encoder->GetCurrentPosition();
+  dispatchScheduled = false;
+  cpuFreeTime = startTime;
+
+  if (cpuModel)
+  {
+    HostHoldInterrupts(true);
+  }
+  ScheduleNextEdge();
+  if (config.glitchRate > 0.0)
+  {
+    simulator->ScheduleIn((uint64_t)(-log(1.0 - Random()) / config.glitchRate * Sim_Ticks_Per_Second), GlitchEvent, this);
+  }
+
+  /* Run past the end so the last requests are serviced */
+  simulator->RunUntil(endTime);
+  while (dispatchScheduled)
+  {
+    simulator->RunFor(Sim_Ticks_Per_Us * 10);
+  }
+  if (cpuModel)
+  {
+    HostHoldInterrupts(false);
+  }
+
+  /* Deferred edges wait for the main loop, decode what is left so the counts compare */
+  encoder->DecodeEdges();
+  FollowFirmwarePosition();
+  CheckDivergence();
+
+  result.expectedCounts = referenceCount;
+  result.firmwareCounts = firmwareCount;
+  result.missedCounts = referenceCount - firmwareCount;
+  result.cpuLoad = (double)busyTicks / (double)(simulator->GetTime() - startTime);
+  result.isrTargetUs = result.isrCalls ? (double)encoderBusyTicks / result.isrCalls / Sim_Ticks_Per_Us : 0.0;
+  result.isrHostNs = result.isrCalls ? (double)hostNanos / result.isrCalls : 0.0;
+  return result;
+}
+
+/******************************************************//**
+ * @brief  Returns the edge rate of the current profile
+ * @param  time Seconds into the stream
+ * @retval edges/s, positive for CCW
+ **********************************************************/
+double QuadratureEdgeGenerator::GetRate(double time)
+{
+  switch (config.profile)
+  {
+    case EDGE_PROFILE_RAMP:
+      return config.rate0 + (config.rate1 - config.rate0) * time / config.duration;
+    case EDGE_PROFILE_SINE:
+      return config.rate0 * sin(2.0 * M_PI * time / config.period);
+    default:
+      return config.rate0;
+  }
+}
+
+/******************************************************//**
+ * @brief  Schedules the next edge. The rate is integrated into a
+ * continuous position and an edge falls where the position crosses
+ * the next boundary either way, so slow passes through zero and
+ * reversals inside an edge interval come out as they would from
+ * a real disc. The edge is then moved by the jitter.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::ScheduleNextEdge()
+{
+  double time = nextEdgeTime;
+
+  for (;;)
+  {
+    if (time >= config.duration)
+    {
+      return;
+    }
+
+    double rate = GetRate(time);
+    if (fabs(rate) >= Edge_Min_Rate)
+    {
+      /* Time to the boundary ahead at the current rate */
+      double remaining = (rate > 0.0 ? 1.0 - edgeFraction : edgeFraction) / fabs(rate);
+      if (remaining <= Edge_Step_S)
+      {
+        time += remaining;
+        nextDirection = rate > 0.0 ? 1 : -1;
+        edgeFraction = rate > 0.0 ? 0.0 : 1.0;
+        break;
+      }
+      edgeFraction += rate * Edge_Step_S;
+    }
+    time += Edge_Step_S;
+  }
+
+  if (time > config.duration)
+  {
+    return;
+  }
+
+  double interval = 1.0 / fabs(GetRate(time));
+  nextEdgeTime = time;
+  time += (2.0 * Random() - 1.0) * config.jitter * interval;
+  time = time > config.duration ? config.duration : time;
+  time = time < 0.0 ? 0.0 : time;
+  simulator->Schedule(startTime + (uint64_t)(time * Sim_Ticks_Per_Second), EdgeEvent, this);
+}
+
+/******************************************************//**
+ * @brief  Drives one encoder line to a level if it is not there
+ * @param  pin pinA or pinB
+ * @param  level HIGH or LOW
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::SetLine(uint8_t pin, uint8_t level)
+{
+  if (LineLevel(pin) != level)
+  {
+    ApplyEdge(pin, level);
+  }
+}
+
+/******************************************************//**
+ * @brief  Returns the level of an encoder line, which for B is
+ * not on its pin while the direction latch is
+ * @param  pin pinA or pinB
+ * @retval HIGH or LOW
+ **********************************************************/
+uint8_t QuadratureEdgeGenerator::LineLevel(uint8_t pin)
+{
+  return pin == pinB ? lineB : HostGetPinLevel(pin);
+}
+
+/******************************************************//**
+ * @brief  Applies one edge to the pins. With the CPU model the
+ * request latches and a dispatch is scheduled, otherwise the
+ * handler runs inside HostSetPinLevel. In hardware counting A
+ * only clocks Timer 1 and the direction latch, and the pin of B
+ * changes when a falling edge of A latches a new direction.
+ * @param  pin pinA or pinB
+ * @param  level New level
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::ApplyEdge(uint8_t pin, uint8_t level)
+{
+  bool counter = encoder->GetEdgeProcessing() == EDGE_PROCESS_COUNTER;
+  int16_t positionBefore = encoder->GetCurrentPosition();
+  int32_t velocityBefore = encoder->GetCurrentVelocity();
+
+  result.edges++;
+
+  /* A also clocks Timer 1 and the direction latch on the encoder wired for hardware counting */
+  if (pin == pinA)
+  {
+    if (pinA == Quadrature_Pulse_A_Pin)
+    {
+      HostSetPinLevel(Quadrature_Counter_Pin, level);
+    }
+    latchLevel = level == LOW ? lineB : latchLevel;
+  }
+  else
+  {
+    lineB = level;
+  }
+
+  /* While Timer 1 counts, INT0 is off and only a change of the latch raises a request */
+  if (counter)
+  {
+    if (pin == pinA)
+    {
+      HostSetPinLevel(pinA, level);
+    }
+    if (HostGetPinLevel(pinB) == latchLevel)
+    {
+      FollowFirmwarePosition();
+      return;
+    }
+    pin = pinB;
+    level = latchLevel;
+  }
+
+  hostVector_t vector = pin == pinA ? vectorA : vectorB;
+  bool wasPending = HostIsInterruptPending(vector);
+  uint32_t servicedBefore = HostGetInterruptCount(vector);
+
+  uint64_t hostStart = HostWallClockNanos();
+  HostSetPinLevel(pin, level);
+  uint64_t nanos = HostWallClockNanos() - hostStart;
+
+  if (cpuModel)
+  {
+    if (wasPending && EdgeRaisesRequest(vector, level))
+    {
+      result.lostRequests++;
+    }
+    RequestDispatch();
+  }
+  else if (HostGetInterruptCount(vector) != servicedBefore)
+  {
+    AccountHandler(vector, positionBefore, velocityBefore, nanos);
+    CheckDivergence();
+  }
+}
+
+/******************************************************//**
+ * @brief  Returns the vector an edge of an encoder line requests
+ * @param  pin pinA or pinB
+ * @retval INT0/INT1 for an encoder on pins 2 and 3, otherwise the
+ * PCINTn vector of the port
+ **********************************************************/
+hostVector_t QuadratureEdgeGenerator::LineVector(uint8_t pin)
+{
+  if (!encoder->UsesPinChangeInterrupt())
+  {
+    return digitalPinToInterrupt(pin) == 0 ? HOST_VECT_INT0 : HOST_VECT_INT1;
+  }
+  return (hostVector_t)(HOST_VECT_PCINT0 + digitalPinToPCICRbit(pin));
+}
+
+/******************************************************//**
+ * @brief  Tells whether an edge latches a request under the
+ * sense control the firmware programmed into EICRA. Pin change
+ * interrupts latch on every edge.
+ * @param  vector Vector of the line
+ * @param  level New level of the pin
+ * @retval true if the edge raises the vector
+ **********************************************************/
+bool QuadratureEdgeGenerator::EdgeRaisesRequest(hostVector_t vector, uint8_t level)
+{
+  if (vector != HOST_VECT_INT0 && vector != HOST_VECT_INT1)
+  {
+    return true;
+  }
+
+  uint8_t sense = (EICRA >> (2 * (vector - HOST_VECT_INT0))) & 0x03;
+  switch (sense)
+  {
+    case 0x01:
+      return true;
+    case 0x02:
+      return level == LOW;
+    case 0x03:
+      return level == HIGH;
+    default:
+      return false;
+  }
+}
+
+/******************************************************//**
+ * @brief  Runs the firmware decoding rule on the levels of the
+ * encoder at one of its edges, without the glitches on the pins:
+ * a glitch over an edge of the other line would otherwise walk the
+ * reference the long way round the cycle. In 1x decoding, on a falling edge the BA state is
+ * pushed into the history and a pulse is counted when both lines
+ * are low and the other line fell last, as LeadPulseA/LeadPulseB
+ * do. In 4x decoding every edge is pushed and the transition from
+ * the previous state counts in its direction, as EdgeChange does.
+ * With Timer 1 counting, a falling edge of A counts the decode mode
+ * in the direction B gives the latch.
+ * @param  pin Line that changes
+ * @param  level New level
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::ReferenceDecode(uint8_t pin, uint8_t level)
+{
+  /* BA transitions [n-1][n] of a CCW turn: 11 to 01, 01 to 00, 00 to 10 and 10 to 11 */
+  static const int8_t transition[16] = {0, -1, 1, 0, 1, 0, 0, -1, -1, 0, 0, 1, 0, 1, -1, 0};
+  bool change = encoder->GetDecodeMode() == DECODE_4X;
+  if (encoder->GetEdgeProcessing() == EDGE_PROCESS_COUNTER)
+  {
+    if (pin == pinA && level == LOW)
+    {
+      referenceCount += ((phase & 0x03) == 3 ? INCRIMENT_CW : INCRIMENT_CCW) * encoder->GetDecodeMode();
+    }
+    return;
+  }
+  if (!change && level != LOW)
+  {
+    return;
+  }
+
+  uint8_t state = phase & 0x03;
+  uint8_t a = (state == 0 || state == 1) ? HIGH : LOW;
+  uint8_t b = (state == 0 || state == 3) ? HIGH : LOW;
+  referenceHistory = (referenceHistory << 2) | (b << 1) | a;
+
+  if (change)
+  {
+    referenceCount += transition[referenceHistory & 0x0F];
+  }
+  else if (!(referenceHistory & MASK_GET_STATE_0))
+  {
+    if (pin == pinA && (referenceHistory & MASK_B_TRANSITION_TO_A_COUNT))
+    {
+      referenceCount += INCRIMENT_CCW;
+    }
+    else if (pin == pinB && (referenceHistory & MASK_A_TRANSITION_TO_B_COUNT))
+    {
+      referenceCount += INCRIMENT_CW;
+    }
+  }
+}
+
+/******************************************************//**
+ * @brief  Schedules the servicing of latched requests once the
+ * modelled CPU has finished the handler it is running
+ * @param  None
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::RequestDispatch()
+{
+  if (dispatchScheduled)
+  {
+    return;
+  }
+
+  uint64_t now = simulator->GetTime();
+  uint64_t start = cpuFreeTime > now ? cpuFreeTime : now;
+  dispatchScheduled = true;
+  simulator->Schedule(start + cost.entry, DispatchEvent, this);
+}
+
+/******************************************************//**
+ * @brief  Services the highest priority latched request, reading
+ * the pins as they are now, and marks the CPU busy until the
+ * handler would return on the target
+ * @param  None
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::Dispatch()
+{
+  int16_t positionBefore = encoder->GetCurrentPosition();
+  int32_t velocityBefore = encoder->GetCurrentVelocity();
+
+  dispatchScheduled = false;
+  uint64_t hostStart = HostWallClockNanos();
+  hostVector_t vector = HostServiceNextInterrupt();
+  uint64_t nanos = HostWallClockNanos() - hostStart;
+  if (vector == HOST_VECT_COUNT)
+  {
+    return;
+  }
+
+  uint64_t handlerStart = simulator->GetTime() - cost.entry;
+  uint64_t busyBefore = busyTicks;
+  AccountHandler(vector, positionBefore, velocityBefore, nanos);
+  cpuFreeTime = handlerStart + (busyTicks - busyBefore);
+
+  for (uint8_t i = 0; i < HOST_VECT_COUNT; i++)
+  {
+    if (HostIsInterruptPending((hostVector_t)i))
+    {
+      RequestDispatch();
+      return;
+    }
+  }
+  CheckDivergence();
+}
+
+/******************************************************//**
+ * @brief  Adds the modelled cost and host time of a serviced
+ * handler and follows the firmware position
+ * @param  vector Vector serviced
+ * @param  positionBefore Encoder position before the handler
+ * @param  velocityBefore Encoder velocity before the handler
+ * @param  nanos Host wall time of the handler
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::AccountHandler(hostVector_t vector, int16_t positionBefore, int32_t velocityBefore, uint64_t nanos)
+{
+  int16_t position = encoder->GetCurrentPosition();
+  uint16_t cycles;
+
+  if (vector == vectorA || vector == vectorB)
+  {
+    if (encoder->GetEdgeProcessing() == EDGE_PROCESS_COUNTER)
+    {
+      cycles = cost.reversal;
+    }
+    else if (encoder->GetEdgeProcessing() == EDGE_PROCESS_DEFERRED)
+    {
+      cycles = cost.queue;
+    }
+    else if (position == positionBefore)
+    {
+      cycles = cost.edge;
+    }
+    else
+    {
+      /* The M/T estimator only counts in the edge handler and the least-squares
+       * window adds a few 32-bit sums */
+      int32_t threshold = encoder->GetFastCalcThreshold();
+      bool fast = encoder->GetVelocityEstimator() != VELOCITY_IIR || velocityBefore > threshold || velocityBefore < -threshold;
+      cycles = fast ? cost.fastCount : cost.slowCount;
+      cycles += encoder->GetVelocityEstimator() == VELOCITY_LSQ ? cost.window : 0;
+    }
+    cycles += encoder->UsesPinChangeInterrupt() ? cost.pinChange : 0;
+    result.isrCalls++;
+    encoderBusyTicks += cycles;
+    hostNanos += nanos;
+  }
+  else if (vector == HOST_VECT_TIMER2_COMPA)
+  {
+    /* As a timestamp clock only every GetSamplePeriod() / 256th compare match runs
+     * the step clock (128 at 61Hz), and every 8th the state observer */
+    bool timer2 = encoder->GetTimestampSource() == TIMESTAMP_TIMER2;
+    uint32_t match = encoder->GetTimestamp() >> 8;
+    cycles = (!timer2 || match % (encoder->GetSamplePeriod() >> 8) == 0) ? cost.sample : cost.tick;
+    if (encoder->GetObserverBandwidth() != 0 && (!timer2 || (match & 0x07) == 0))
+    {
+      cycles += cost.observer;
+    }
+  }
+  else if (vector >= HOST_VECT_PCINT0 && vector <= HOST_VECT_PCINT2)
+  {
+    /* An edge of another encoder sharing the CPU */
+    cycles = cost.pinChange + cost.fastCount;
+  }
+  else
+  {
+    cycles = cost.edge;
+  }
+  busyTicks += cycles;
+  FollowFirmwarePosition();
+}
+
+/******************************************************//**
+ * @brief  Adds the firmware position change since the last call
+ * to the net firmware count. Deferred edges move the position in
+ * the main loop, so the change covers everything since then.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::FollowFirmwarePosition()
+{
+  int16_t position = encoder->GetCurrentPosition();
+  int16_t ppr = encoder->GetPulsesPerRotation();
+
+  /* Unwrap the 0 to ppr-1 position into a net count */
+  int16_t delta = position - lastFirmwarePosition;
+  if (delta > ppr / 2)
+  {
+    delta -= ppr;
+  }
+  else if (delta < -ppr / 2)
+  {
+    delta += ppr;
+  }
+  firmwareCount += delta;
+  lastFirmwarePosition = position;
+}
+
+/******************************************************//**
+ * @brief  Compares the firmware with the reference while no
+ * request is waiting, so handler latency is not seen as a miss.
+ * Deferred edges also diverge until the main loop decodes them.
+ * @param  None
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::CheckDivergence()
+{
+  int32_t divergence = referenceCount - firmwareCount;
+  if (divergence < 0)
+  {
+    divergence = -divergence;
+  }
+
+  if (divergence > result.maxDivergence)
+  {
+    result.maxDivergence = divergence;
+  }
+  if (divergence != 0 && result.firstMissTime < 0.0)
+  {
+    result.firstMissTime = (double)(simulator->GetTime() - startTime) / Sim_Ticks_Per_Second;
+    result.firstMissRate = GetRate(result.firstMissTime);
+  }
+}
+
+/******************************************************//**
+ * @brief  xorshift32 random number
+ * @param  None
+ * @retval uniform value in [0, 1)
+ **********************************************************/
+double QuadratureEdgeGenerator::Random()
+{
+  randomState ^= randomState << 13;
+  randomState ^= randomState >> 17;
+  randomState ^= randomState << 5;
+  return (double)randomState / 4294967296.0;
+}
+
+/******************************************************//**
+ * @brief  Simulator event moving the encoder by one edge. Phases
+ * are the BA levels 11, 01, 00, 10 seen while turning CCW.
+ * @param  context QuadratureEdgeGenerator instance
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::EdgeEvent(void *context)
+{
+  QuadratureEdgeGenerator *generator = (QuadratureEdgeGenerator *)context;
+  uint8_t before = generator->phase & 0x03;
+  generator->phase += generator->nextDirection;
+
+  uint8_t state = generator->phase & 0x03;
+  uint8_t levelB = (state == 0 || state == 3) ? HIGH : LOW;
+  uint8_t levelA = (state == 0 || state == 1) ? HIGH : LOW;
+  bool changeB = (before == 0 || before == 3) != (levelB == HIGH);
+  generator->ReferenceDecode(changeB ? generator->pinB : generator->pinA, changeB ? levelB : levelA);
+  generator->SetLine(generator->pinB, levelB);
+  generator->SetLine(generator->pinA, levelA);
+  generator->ScheduleNextEdge();
+}
+
+/******************************************************//**
+ * @brief  Simulator event starting a glitch: one line flips for
+ * glitchNs, then the next glitch is scheduled
+ * @param  context QuadratureEdgeGenerator instance
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::GlitchEvent(void *context)
+{
+  QuadratureEdgeGenerator *generator = (QuadratureEdgeGenerator *)context;
+  HostSimulator *simulator = generator->simulator;
+  if (simulator->GetTime() >= generator->endTime)
+  {
+    return;
+  }
+
+  uint8_t pin = generator->Random() < 0.5 ? generator->pinA : generator->pinB;
+  generator->result.glitches++;
+  generator->ApplyEdge(pin, generator->LineLevel(pin) == HIGH ? LOW : HIGH);
+
+  uint64_t width = (uint64_t)generator->config.glitchNs * Sim_Ticks_Per_Us / 1000;
+  simulator->ScheduleIn(width != 0 ? width : 1, GlitchEndEvent, generator);
+  simulator->ScheduleIn((uint64_t)(-log(1.0 - generator->Random()) / generator->config.glitchRate * Sim_Ticks_Per_Second),
+                        GlitchEvent, generator);
+}
+
+/******************************************************//**
+ * @brief  Simulator event ending a glitch, putting both lines back
+ * to the levels of the current phase
+ * @param  context QuadratureEdgeGenerator instance
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::GlitchEndEvent(void *context)
+{
+  QuadratureEdgeGenerator *generator = (QuadratureEdgeGenerator *)context;
+  uint8_t state = generator->phase & 0x03;
+  generator->SetLine(generator->pinB, (state == 0 || state == 3) ? HIGH : LOW);
+  generator->SetLine(generator->pinA, (state == 0 || state == 1) ? HIGH : LOW);
+}
+
+/******************************************************//**
+ * @brief  Simulator event servicing latched requests
+ * @param  context QuadratureEdgeGenerator instance
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::DispatchEvent(void *context)
+{
+  ((QuadratureEdgeGenerator *)context)->Dispatch();
+}
+
+/******************************************************//**
+ * @brief  Timer hook: with the CPU model the TIMER2_COMPA request
+ * only latches, so it has to be dispatched like an edge
+ * @param  context QuadratureEdgeGenerator instance
+ * @retval None
+ **********************************************************/
+void QuadratureEdgeGenerator::SampleTimerHook(void *context)
+{
+  QuadratureEdgeGenerator *generator = (QuadratureEdgeGenerator *)context;
+  if (HostInterruptsHeld())
+  {
+    generator->RequestDispatch();
+  }
+}
@@ -0,0 +1,183 @@
+/******************************************************//**
+ * @file    quadratureEdgeGenerator.h
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   A/B edge-stream generator for stress testing the
+ *          QuadratureEncoder interrupt handlers in virtual time.
+ *          Streams follow a speed profile with reversals, timing
+ *          jitter and glitches, and a CPU model delays and spaces
+ *          the handlers by their estimated ATmega328P cost so the
+ *          pins are read when the target would read them.
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#ifndef __QUADRATURE_EDGE_GENERATOR_H_INCLUDED
+#define __QUADRATURE_EDGE_GENERATOR_H_INCLUDED
+
+#include "hostSimulator.h"
+#include "quadratureEncoder.h"
+
+/// Estimated ATmega328P cost of the encoder handlers in CPU cycles at 16MHz.
+/// Entry covers the interrupt response, the attachInterrupt dispatch and the
+/// register saves up to the pin read; ReadLines reads both pins from one read
+/// of the port within a few cycles. An encoder on a pin change interrupt adds
+/// the port handler looping over the two encoder slots and comparing the port
+/// with the levels of the last interrupt, and an edge of another encoder on
+/// the same CPU costs that and a fast count. The slow count includes the UpdateSpeed IIR,
+/// measured on the target at about 48us (see QuadratureEncoder::UpdateSpeed)
+/// less the two micros() calls it no longer makes. With Timer 2 as the
+/// timestamp clock, TIMER2_COMPA costs a tick on the compare matches that
+/// only extend the counter. A state observer update adds about ten 32-bit
+/// adds and shifts, two 32x32 and three 16x16 bit multiplies, and the
+/// variable shifts of its gains. A deferred edge only reads the pins and the
+/// timestamp into the ring. The least-squares velocity window adds two 32-bit
+/// sums and a multiply by the window length. With Timer 1 counting the
+/// pulses, only a reversal runs a handler, which adds up the counter twice with
+/// a 16-bit modulo each time.
+#define Edge_Isr_Entry_Cycles        (30)
+#define Edge_Isr_Edge_Cycles         (80)
+#define Edge_Isr_Fast_Count_Cycles   (180)
+#define Edge_Isr_Slow_Count_Cycles   (850)
+#define Edge_Isr_Sample_Cycles       (800)
+#define Edge_Isr_Tick_Cycles         (40)
+#define Edge_Isr_Observer_Cycles     (400)
+#define Edge_Isr_Queue_Cycles        (130)
+#define Edge_Isr_Window_Cycles       (60)
+#define Edge_Isr_Reversal_Cycles     (600)
+#define Edge_Isr_Pin_Change_Cycles   (24)
+
+/// Rate below which the stream is considered stopped, in edges/s, and the
+/// step the rate is integrated with between edges, in seconds
+#define Edge_Min_Rate                (1.0)
+#define Edge_Step_S                  (1.0e-4)
+
+/// Speed profile of the stream
+typedef enum {
+  EDGE_PROFILE_CONSTANT = 0,  //rate0 for the whole stream
+  EDGE_PROFILE_RAMP,          //linear from rate0 to rate1
+  EDGE_PROFILE_SINE           //rate0 * sin(2 pi t / period), reverses twice per period
+} edgeProfile_t;
+
+/// Edge stream description. Rates are in edges per second, four per
+/// encoder pulse, positive for CCW.
+typedef struct {
+  edgeProfile_t profile;
+  double rate0;
+  double rate1;
+  double period;              //Sine period in seconds
+  double duration;            //Stream length in seconds
+  double jitter;              //Uniform edge time jitter as a fraction of the edge interval (0 to 0.5)
+  double glitchRate;          //Glitches per second, each a short pulse on A or B
+  uint32_t glitchNs;          //Glitch width in nanoseconds
+  uint32_t seed;              //Random seed for jitter and glitches
+} edgeStreamConfig_t;
+
+/// ATmega328P cost model of the handlers, in CPU cycles
+typedef struct {
+  uint16_t entry;             //From the request to the pin read
+  uint16_t edge;              //Whole handler when no count is made
+  uint16_t fastCount;         //Whole handler counting a pulse while speed is measured by pulse counting
+  uint16_t slowCount;         //Whole handler counting a pulse while speed is measured by pulse timing
+  uint16_t sample;            //TIMER2_COMPA handler running the step clock
+  uint16_t tick;              //TIMER2_COMPA handler only extending the Timer 2 timestamps
+  uint16_t observer;          //Added to TIMER2_COMPA by a state observer update
+  uint16_t queue;             //Whole handler queueing an edge in deferred processing
+  uint16_t window;            //Added to a count by the least-squares velocity window
+  uint16_t reversal;          //Whole direction latch handler in hardware counting
+  uint16_t pinChange;         //Added to every handler of an encoder on a pin change interrupt
+} edgeIsrCost_t;
+
+/// Result of a stream
+typedef struct {
+  uint32_t edges;             //Edges produced, glitches included
+  uint32_t glitches;          //Glitches produced
+  uint32_t isrCalls;          //Encoder handlers serviced
+  uint32_t lostRequests;      //Edges that found their request already latched
+  int32_t expectedCounts;     //Net counts of the same decoder with instant reads of the lines without glitches
+  int32_t firmwareCounts;     //Net counts the firmware made
+  int32_t missedCounts;       //expectedCounts - firmwareCounts at the end
+  int32_t maxDivergence;      //Largest |expected - firmware| during the stream
+  double firstMissTime;       //Seconds into the stream of the first divergence, negative if none
+  double firstMissRate;       //Edge rate when the first divergence appeared
+  double cpuLoad;             //Share of CPU time spent in the modelled handlers
+  double isrTargetUs;         //Mean modelled handler time per encoder edge on the target
+  double isrHostNs;           //Mean host wall time per encoder handler
+} edgeStreamResult_t;
+
+/// QuadratureEdgeGenerator library class
+class QuadratureEdgeGenerator
+{
+  public:
+    QuadratureEdgeGenerator();                              //Constructor, loads the default cost model
+    void Begin(HostSimulator *simulator);                   //Take over interrupt dispatch in the simulator
+    void End();                                             //Give interrupt dispatch back to the HAL
+    void SetEncoder(QuadratureEncoder *newTarget);          //Play the streams into this encoder (NULL: the one in slot 0)
+    void NotifyRequest();                                   //Service a request another source latched on the modelled CPU
+    void SetIsrCost(const edgeIsrCost_t &newCost);          //Replace the handler cost model
+    edgeIsrCost_t GetIsrCost();                             //Return the handler cost model
+    void SetCpuModel(bool enabled);                         //Off: handlers run instantly at each edge
+
+    edgeStreamResult_t Run(const edgeStreamConfig_t &config); //Play a stream and return what the firmware made of it
+    double GetRate(double time);                            //Edge rate of the current profile at a time in seconds
+
+  private:
+    void ScheduleNextEdge();
+    void ApplyEdge(uint8_t pin, uint8_t level);
+    void SetLine(uint8_t pin, uint8_t level);
+    uint8_t LineLevel(uint8_t pin);
+    hostVector_t LineVector(uint8_t pin);
+    bool EdgeRaisesRequest(hostVector_t vector, uint8_t level);
+    void ReferenceDecode(uint8_t pin, uint8_t level);
+    void RequestDispatch();
+    void Dispatch();
+    void AccountHandler(hostVector_t vector, int16_t positionBefore, int32_t velocityBefore, uint64_t nanos);
+    void FollowFirmwarePosition();
+    void CheckDivergence();
+    double Random();
+    static void EdgeEvent(void *context);
+    static void GlitchEvent(void *context);
+    static void GlitchEndEvent(void *context);
+    static void DispatchEvent(void *context);
+    static void SampleTimerHook(void *context);
+
+    // member variables
+    HostSimulator *simulator;
+    QuadratureEncoder *target;      //Encoder given to SetEncoder, NULL for the one in slot 0
+    QuadratureEncoder *encoder;     //Encoder the current stream plays into
+    uint8_t pinA;                   //Pin of its A line
+    uint8_t pinB;                   //Pin of its B line
+    hostVector_t vectorA;           //Vector an edge of A requests
+    hostVector_t vectorB;           //Vector an edge of B requests
+    edgeIsrCost_t cost;
+    bool cpuModel;                  //Model handler latency and duration
+    edgeStreamConfig_t config;
+    uint64_t startTime;             //Virtual time the stream started
+    uint64_t endTime;               //Virtual time the stream ends
+    double nextEdgeTime;            //Nominal time of the next edge in seconds, before jitter
+    int32_t phase;                  //Quadrature position in edges, BA levels 11, 01, 00, 10 while CCW
+    int8_t nextDirection;           //Direction of the scheduled edge
+    uint8_t lineB;                  //Level of B, which the direction latch replaces on its pin in hardware counting
+    uint8_t latchLevel;             //Direction latch output, B at the last falling edge of A
+    double edgeFraction;            //Position between the last two edge boundaries, 0 to 1
+    uint32_t randomState;
+
+    bool dispatchScheduled;         //A DispatchEvent is pending
+    uint64_t cpuFreeTime;           //Virtual time the current handler returns
+
+    uint8_t referenceHistory;       //Decoder state of the reference, as encoderState
+    int32_t referenceCount;         //Net counts of the reference decoder
+    int32_t firmwareCount;          //Net counts of the firmware, unwrapped
+    int16_t lastFirmwarePosition;   //Firmware position after the last handler
+
+    edgeStreamResult_t result;
+    uint64_t busyTicks;             //Modelled handler time
+    uint64_t encoderBusyTicks;      //Modelled encoder handler time
+    uint64_t hostNanos;             //Host wall time in the encoder handlers
+};
+
+#endif /* #ifndef __QUADRATURE_EDGE_GENERATOR_H_INCLUDED */
@@ -0,0 +1,244 @@
+/******************************************************//**
+ * @file    simBalance.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Closed-loop balance scenarios on the cart-pendulum
+ *          plant: a full-state feedback loop drives the firmware
+ *          StepperMotor from the Pendulum readings and the plant
+ *          reports settling time, RMS angle error and cart excursion
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "cartPendulumPlant.h"
+#include "stepperMotor.h"
+#include "pendulum.h"
+#include <stdio.h>
+
+/// Balance loop period and limits
+#define Balance_Loop_Ms           (5)
+#define Balance_Min_Speed_Pps     (100)
+#define Balance_Max_Speed_Pps     (L6474_MAX_PWM_FREQ)
+#define Balance_Acceleration_Pps2 (60000)
+
+/// Closed-loop poles of the balance loop, all placed at -Balance_Pole_Rad_S
+#define Balance_Pole_Rad_S        (3.0)
+
+/// Angle band for the settling time
+#define Balance_Settling_Band_Rad (1.0 * DEG_TO_RAD)
+
+/// Observer bandwidth when the loop closes on the observer state, in rad/s
+#define Balance_Observer_Rad_S    (60)
+
+/// Where the balance loop reads the pendulum state from
+typedef enum {
+  SENSOR_ENCODER = 0,   //Count position and IIR velocity
+  SENSOR_INTERPOLATED,  //Position interpolated between edges and IIR velocity
+  SENSOR_OBSERVER,      //Encoder state observer
+  SENSOR_IDEAL,         //The plant itself
+  SENSOR_COUNT
+} balanceSensor_t;
+
+/// Full-state feedback gains of the cart acceleration command
+typedef struct {
+  double angle;
+  double angularVelocity;
+  double position;
+  double velocity;
+} balanceGains_t;
+
+static HostSimulator simulator;
+static L6474Model model;
+static CartPendulumPlant plant;
+static StepperMotor stepperMotor(1.8f, STEP_QUARTER);
+static Pendulum<360, DECODE_4X> pendulum(TIMESTAMP_TIMER2);
+
+static balanceGains_t gains;
+static double commandedVelocity;
+static bool cartRunning;
+static direction_t cartDirection;
+static const double stepAngleRadian = 1.8 * DEG_TO_RAD / STEP_QUARTER;
+
+/******************************************************//**
+ * @brief  Places the four closed-loop poles of the linearised
+ * cart-pendulum, theta'' = (g/l)theta - x''/l, at -pole
+ * @param  pole Pole magnitude in rad/s
+ * @retval None
+ **********************************************************/
+static void ComputeGains(double pole)
+{
+  plantParams_t params = plant.GetParams();
+  double a = params.gravity / params.pendulumLength;
+  double p2 = pole * pole;
+
+  gains.position = p2 * p2 / a;
+  gains.velocity = 4.0 * p2 * pole / a;
+  gains.angularVelocity = params.pendulumLength * (4.0 * pole + gains.velocity);
+  gains.angle = params.pendulumLength * (6.0 * p2 + a + gains.position);
+}
+
+/******************************************************//**
+ * @brief  Turns a cart velocity command into L6474 RUN commands.
+ * Speeds below the minimum stop the cart and a direction change
+ * goes through a stop.
+ * @param  velocity Cart velocity in m/s (FORWARD is +)
+ * @retval None
+ **********************************************************/
+static void ApplyCartVelocity(double velocity)
+{
+  double metersPerStep = plant.GetParams().metersPerStep;
+  double pps = fabs(velocity) / metersPerStep;
+  direction_t direction = velocity > 0.0 ? CCW : CW;
+
+  if (cartRunning && (pps < Balance_Min_Speed_Pps || direction != cartDirection))
+  {
+    /* Ramp down to the minimum speed before stopping or reversing */
+    if (stepperMotor.GetCurrentSpeedRad() > Balance_Min_Speed_Pps * stepAngleRadian)
+    {
+      stepperMotor.SetMaxSpeedRad(Balance_Min_Speed_Pps * stepAngleRadian);
+      return;
+    }
+    stepperMotor.HardStop();
+    cartRunning = false;
+  }
+
+  if (pps < Balance_Min_Speed_Pps)
+  {
+    return;
+  }
+  stepperMotor.SetMaxSpeedRad(pps * stepAngleRadian);
+  if (!cartRunning)
+  {
+    stepperMotor.Run(direction);
+    cartRunning = true;
+    cartDirection = direction;
+  }
+}
+
+/******************************************************//**
+ * @brief  One iteration of the balance loop. The cart state comes
+ * from the L6474 and the pendulum state from the Pendulum readings,
+ * its state observer, or the plant itself to show what an ideal
+ * sensor would do.
+ * @param  sensor Where the pendulum state is read from
+ * @retval None
+ **********************************************************/
+static void BalanceLoop(balanceSensor_t sensor)
+{
+  double metersPerRadian = plant.GetParams().metersPerStep / stepAngleRadian;
+  double angle = plant.GetAngleFromUpright();
+  double angularVelocity = plant.GetAngularVelocity();
+  if (sensor == SENSOR_ENCODER)
+  {
+    pendulumState_t state = pendulum.GetUprightStateRad();
+    angle = state.position;
+    angularVelocity = state.velocity;
+  }
+  else if (sensor == SENSOR_INTERPOLATED)
+  {
+    pendulumState_t state = pendulum.GetInterpolatedUprightStateRad();
+    angle = state.position;
+    angularVelocity = state.velocity;
+  }
+  else if (sensor == SENSOR_OBSERVER)
+  {
+    angle = pendulum.GetObservedAngleFromUprightRad();
+    angularVelocity = pendulum.GetObservedVelocityRad();
+  }
+  double position = stepperMotor.GetAbsolutePositionRad() * metersPerRadian;
+  double velocity = cartRunning ? stepperMotor.GetCurrentSpeedRad() * metersPerRadian : 0.0;
+  velocity = cartDirection == CW ? -velocity : velocity;
+  double limit = Balance_Max_Speed_Pps * plant.GetParams().metersPerStep;
+
+  double acceleration = gains.angle * angle + gains.angularVelocity * angularVelocity +
+                        gains.position * position + gains.velocity * velocity;
+
+  commandedVelocity = velocity + acceleration * Balance_Loop_Ms * 1.0e-3;
+  commandedVelocity = commandedVelocity > limit ? limit : (commandedVelocity < -limit ? -limit : commandedVelocity);
+  ApplyCartVelocity(commandedVelocity);
+}
+
+/******************************************************//**
+ * @brief  Holds the pendulum near upright, releases it and runs
+ * the balance loop, with an optional push half way through
+ * @param  name Scenario name
+ * @param  tiltDeg Release angle from upright in degrees
+ * @param  pushRadS Angular velocity added by the push in rad/s
+ * @param  seconds Scenario length
+ * @param  sensor Where the loop reads the pendulum state from
+ * @retval None
+ **********************************************************/
+static void BalanceScenario(const char *name, double tiltDeg, double pushRadS, uint16_t seconds, balanceSensor_t sensor)
+{
+  static const char *sensorNames[SENSOR_COUNT] = {"encoder", "interp", "observer", "ideal"};
+  uint32_t loops = (uint32_t)seconds * 1000 / Balance_Loop_Ms;
+
+  /* Hold the pendulum still long enough for the encoder speed estimate to clear */
+  stepperMotor.HardStop();
+  cartRunning = false;
+  commandedVelocity = 0.0;
+  plant.SetPendulum(PI + tiltDeg * DEG_TO_RAD, 0.0);
+  simulator.RunFor(100ULL * Sim_Ticks_Per_Ms);
+  plant.SetPendulum(PI + tiltDeg * DEG_TO_RAD, 0.0);
+  stepperMotor.SetHome();
+
+  plant.ResetMetrics(Balance_Settling_Band_Rad);
+  double startPosition = plant.GetCartPosition();
+  for (uint32_t i = 0; i < loops; i++)
+  {
+    if (pushRadS != 0.0 && i == loops / 2)
+    {
+      plant.SetPendulum(plant.GetAngle(), plant.GetAngularVelocity() + pushRadS);
+    }
+    BalanceLoop(sensor);
+    simulator.RunFor((uint64_t)Balance_Loop_Ms * Sim_Ticks_Per_Ms);
+  }
+
+  plantMetrics_t metrics = plant.GetMetrics();
+  printf("  %-18s %-8s", name, sensorNames[sensor]);
+  if (metrics.settlingTime < 0.0)
+  {
+    printf(" settling      n/a");
+  }
+  else
+  {
+    printf(" settling %6.3f s", metrics.settlingTime);
+  }
+  printf("  rms %6.3f deg  peak %7.2f deg  cart max %6.1f mm  end %6.1f mm\n",
+         metrics.rmsAngleError * RAD_TO_DEG, metrics.maxAngleError * RAD_TO_DEG,
+         metrics.maxCartExcursion * 1000.0, (plant.GetCartPosition() - startPosition) * 1000.0);
+}
+
+int main()
+{
+  simulator.Begin();
+  model.Begin(1);
+  model.AttachToSimulator(&simulator);
+  plant.Begin(&simulator, &model);
+  stepperMotor.Begin();
+  pendulum.Begin<1000 / Balance_Loop_Ms>();
+  pendulum.SetObserverBandwidth(Balance_Observer_Rad_S);
+
+  stepperMotor.SetMinSpeedRad(Balance_Min_Speed_Pps * stepAngleRadian);
+  stepperMotor.SetAccelerationRad(Balance_Acceleration_Pps2 * stepAngleRadian);
+  stepperMotor.SetDecelerationRad(Balance_Acceleration_Pps2 * stepAngleRadian);
+  ComputeGains(Balance_Pole_Rad_S);
+
+  printf("Balance loop every %d ms, poles at -%.1f rad/s, settling band %.1f deg\n",
+         Balance_Loop_Ms, Balance_Pole_Rad_S, Balance_Settling_Band_Rad * RAD_TO_DEG);
+  for (uint8_t sensor = 0; sensor < SENSOR_COUNT; sensor++)
+  {
+    BalanceScenario("release at 2 deg", 2.0, 0.0, 10, (balanceSensor_t)sensor);
+    BalanceScenario("release at -5 deg", -5.0, 0.0, 10, (balanceSensor_t)sensor);
+    BalanceScenario("push 0.5 rad/s", 0.0, 0.5, 20, (balanceSensor_t)sensor);
+  }
+
+  plant.End();
+  model.End();
+  simulator.End();
+  return 0;
+}
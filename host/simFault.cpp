@@ -0,0 +1,155 @@
+/******************************************************//**
+ * @file    simFault.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   L6474 FLAG fault reporting with the pendulum encoder
+ *          on the port C pin change interrupt: every alarm
+ *          condition injected into the L6474 model while the motor
+ *          runs and the encoder turns is reported by
+ *          StepperMotor, and the encoder keeps its count
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "l6474Model.h"
+#include "stepperMotor.h"
+#include "pendulum.h"
+#include <stdio.h>
+
+/// Encoder speed while the faults are injected
+#define Sim_Encoder_Pps     (500)
+
+/// Condition injected into the STATUS register of shield 0
+typedef struct {
+  const char *name;
+  uint16_t set;               //STATUS bits set by the condition
+  uint16_t clear;             //Active low STATUS bits cleared by the condition
+  uint8_t expected;           //stepperFault_t bits StepperMotor should report
+} faultCase_t;
+
+static const faultCase_t faultCases[] = {
+  {"overcurrent",      0,                        L6474_STATUS_OCD,    FAULT_OVERCURRENT},
+  {"thermal warning",  0,                        L6474_STATUS_TH_WRN, FAULT_THERMAL_WARNING},
+  {"thermal shutdown", 0,                        L6474_STATUS_TH_SD,  FAULT_THERMAL_SHUTDOWN},
+  {"undervoltage",     0,                        L6474_STATUS_UVLO,   FAULT_UNDERVOLTAGE},
+  {"wrong command",    L6474_STATUS_WRONG_CMD,   0,                   FAULT_COMMAND},
+  {"not performable",  L6474_STATUS_NOTPERF_CMD, 0,                   FAULT_COMMAND}
+};
+
+static HostSimulator simulator;
+static L6474Model model;
+static StepperMotor stepperMotor(1.8f, STEP_QUARTER);
+static Pendulum<360, DECODE_4X> pendulum;
+static uint8_t encoderPhase;
+static int32_t encoderEdges;
+static uint32_t callbacks;
+
+/******************************************************//**
+ * @brief  Simulator event turning the pendulum encoder by one
+ * edge in the CCW direction
+ * @param  context Unused
+ * @retval None
+ **********************************************************/
+static void EncoderEdge(void *context)
+{
+  encoderPhase = (encoderPhase + 1) & 0x03;
+  encoderEdges++;
+  HostSetPinLevel(Quadrature_Pendulum_B_Pin, (encoderPhase == 0 || encoderPhase == 3) ? HIGH : LOW);
+  HostSetPinLevel(Quadrature_Pendulum_A_Pin, (encoderPhase == 0 || encoderPhase == 1) ? HIGH : LOW);
+  simulator.ScheduleIn(Sim_Ticks_Per_Second / (4UL * Sim_Encoder_Pps), EncoderEdge, context);
+}
+
+/******************************************************//**
+ * @brief  Fault callback, runs in the FLAG interrupt
+ * @param  faults stepperFault_t bits of this report
+ * @retval None
+ **********************************************************/
+static void FaultCallback(uint8_t faults)
+{
+  (void)faults;
+  callbacks++;
+}
+
+/******************************************************//**
+ * @brief  Latches a condition in the model and lets the motor and
+ * encoder run on
+ * @param  fault Condition to inject
+ * @retval true if FLAG was high again once the injection returned
+ **********************************************************/
+static bool Inject(const faultCase_t *fault)
+{
+  uint16_t status = model.GetRegister(0, L6474_STATUS);
+  model.SetRegister(0, L6474_STATUS, (status | fault->set) & ~fault->clear);
+  bool asserted = model.IsFlagAsserted();
+  simulator.RunFor(20UL * Sim_Ticks_Per_Ms);
+  return !asserted;
+}
+
+/******************************************************//**
+ * @brief  Injects every condition once and prints what
+ * StepperMotor reported for it
+ * @param  None
+ * @retval None
+ **********************************************************/
+static void InjectAll()
+{
+  for (uint8_t i = 0; i < sizeof(faultCases) / sizeof(faultCases[0]); i++)
+  {
+    const faultCase_t *fault = &faultCases[i];
+    stepperMotor.ClearFaults();
+    uint32_t before = callbacks;
+    bool released = Inject(fault);
+    uint8_t faults = stepperMotor.GetFaults();
+
+    printf("  %-17s reported 0x%02X (expected 0x%02X)  callbacks %lu  FLAG %s  %s\n",
+           fault->name, faults, fault->expected, (unsigned long)(callbacks - before),
+           model.IsFlagAsserted() ? "low" : "released",
+           (faults == fault->expected && released) ? "ok" : "FAIL");
+  }
+}
+
+int main()
+{
+  simulator.Begin();
+  model.Begin(1);
+  model.AttachToSimulator(&simulator);
+  stepperMotor.Begin();
+  stepperMotor.AttachFaultCallback(FaultCallback);
+  pendulum.Begin();
+
+  encoderPhase = 0;
+  encoderEdges = 0;
+  simulator.ScheduleIn(0, EncoderEdge, NULL);
+  stepperMotor.Run(CCW);
+  simulator.RunFor(100UL * Sim_Ticks_Per_Ms);
+
+  printf("Faults with every alarm enabled, motor running, encoder at %u pps\n", Sim_Encoder_Pps);
+  InjectAll();
+
+  printf("Thermal warning masked in ALARM_EN\n");
+  model.SetRegister(0, L6474_ALARM_EN, L6474_CONF_PARAM_ALARM_EN_SHIELD_0 & ~L6474_ALARM_EN_THERMAL_WARNING);
+  stepperMotor.ClearFaults();
+  bool released = Inject(&faultCases[1]);
+  printf("  thermal warning   reported 0x%02X, FLAG %s, STATUS TH_WRN %s  %s\n", stepperMotor.GetFaults(),
+         model.IsFlagAsserted() ? "low" : "high",
+         (model.GetRegister(0, L6474_STATUS) & L6474_STATUS_TH_WRN) ? "clear" : "latched",
+         (stepperMotor.GetFaults() == FAULT_NONE && released) ? "ok" : "FAIL");
+  model.SetRegister(0, L6474_ALARM_EN, L6474_CONF_PARAM_ALARM_EN_SHIELD_0);
+  simulator.RunFor(Sim_Ticks_Per_Ms);
+  printf("  alarm enabled again with the condition latched: reported 0x%02X  %s\n", stepperMotor.GetFaults(),
+         stepperMotor.GetFaults() == FAULT_THERMAL_WARNING ? "ok" : "FAIL");
+
+  stepperMotor.HardStop();
+  simulator.RunFor(10UL * Sim_Ticks_Per_Ms);
+  int32_t counted = (int32_t)(pendulum.GetAbsolutePositionDeg() * 4.0f + 0.5f);
+  printf("Encoder through the faults: %ld edges played, %ld counted, motor %ld steps, ABS_POS %ld\n",
+         (long)encoderEdges, (long)counted, (long)model.GetStepCount(0), (long)model.GetPosition(0));
+
+  model.End();
+  simulator.End();
+  return 0;
+}
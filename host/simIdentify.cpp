@@ -0,0 +1,211 @@
+/******************************************************//**
+ * @file    simIdentify.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Free decay identification on the cart-pendulum plant:
+ *          the hanging pendulum is pushed, Pendulum::UpdateFreeDecay
+ *          fits the swing from the encoder edges, and the natural
+ *          frequency, damping ratio and effective length are checked
+ *          against the plant. The swing is also logged the way the
+ *          Identify_Free_Swing switch of firmware.ino prints it and
+ *          replayed through FreeDecayEstimator. Given a file, the
+ *          log in it is fitted instead.
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "cartPendulumPlant.h"
+#include "pendulum.h"
+#include <stdio.h>
+#include <string.h>
+
+/// Control loop period that calls UpdateFreeDecay, and log period of firmware.ino
+#define Identify_Loop_Ms        (1)
+#define Identify_Log_Ms         (20)
+
+/// Push given to the hanging pendulum in rad/s
+#define Identify_Push_Rad_S     (2.5)
+
+/// Longest swing recorded
+#define Identify_Max_Seconds    (60)
+#define Identify_Max_Log        (Identify_Max_Seconds * 1000 / Identify_Log_Ms)
+
+typedef Pendulum<360, DECODE_4X> pendulum_t;
+
+static HostSimulator simulator;
+static L6474Model model;
+static CartPendulumPlant plant;
+static pendulum_t pendulum(TIMESTAMP_TIMER2);
+static float logSeconds[Identify_Max_Log];
+static float logDegrees[Identify_Max_Log];
+
+/******************************************************//**
+ * @brief  Prints one fit next to the plant parameters
+ * @param  name Fit name
+ * @param  ok true if the fit returned a result
+ * @param  result Fitted parameters
+ * @param  params Plant parameters, NULL for a log file
+ * @retval true if the fit is within 1% of the natural frequency and
+ * length and 20% of the damping ratio of the plant
+ **********************************************************/
+static bool PrintResult(const char *name, bool ok, const freeDecayResult_t &result, const plantParams_t *params)
+{
+  if (!ok)
+  {
+    printf("  %-24s too few half swings\n", name);
+    return false;
+  }
+  printf("  %-24s %2u half swings  wn %6.3f rad/s  zeta %7.5f  length %6.4f m", name, result.halfCycles,
+         result.naturalFrequency, result.dampingRatio, result.effectiveLength);
+  if (params == NULL)
+  {
+    printf("\n");
+    return true;
+  }
+
+  double naturalFrequency = sqrt(params->gravity / params->pendulumLength);
+  double dampingRatio = params->damping / (2.0 * naturalFrequency);
+  bool good = fabs(result.naturalFrequency / naturalFrequency - 1.0) < 0.01 &&
+              fabs(result.effectiveLength / params->pendulumLength - 1.0) < 0.01 &&
+              fabs(result.dampingRatio / dampingRatio - 1.0) < 0.2;
+  printf("  %s\n", good ? "ok" : "FAIL");
+  return good;
+}
+
+/******************************************************//**
+ * @brief  Pushes the hanging pendulum of one rig and identifies it
+ * from the encoder edges and from the log
+ * @param  name Rig name
+ * @param  length Pendulum length in meters
+ * @param  damping Pivot damping in 1/s
+ * @retval None
+ **********************************************************/
+static void Identify(const char *name, double length, double damping)
+{
+  plantParams_t params = plant.GetParams();
+  params.pendulumLength = length;
+  params.damping = damping;
+  plant.SetParams(params);
+
+  double naturalFrequency = sqrt(params.gravity / length);
+  printf("%s: length %.3f m, damping %.2f/s, wn %.3f rad/s, zeta %.5f, pushed at %.1f rad/s\n", name, length,
+         damping, naturalFrequency, damping / (2.0 * naturalFrequency), Identify_Push_Rad_S);
+
+  /* Hold the pendulum hanging long enough for the encoder speed estimate to clear */
+  for (uint8_t i = 0; i < 100; i++)
+  {
+    plant.SetPendulum(0.0, 0.0);
+    simulator.RunFor(Sim_Ticks_Per_Ms);
+  }
+  pendulum.SetRestPosition(0);
+  pendulum.StartFreeDecay();
+  plant.SetPendulum(0.0, Identify_Push_Rad_S);
+
+  freeDecayStatus_t status = FREE_DECAY_WAITING;
+  uint32_t logCount = 0;
+  uint32_t ms;
+  for (ms = 0; ms < (uint32_t)Identify_Max_Seconds * 1000; ms += Identify_Loop_Ms)
+  {
+    simulator.RunFor((uint64_t)Identify_Loop_Ms * Sim_Ticks_Per_Ms);
+    status = pendulum.UpdateFreeDecay();
+    if (ms % Identify_Log_Ms == 0 && logCount < Identify_Max_Log)
+    {
+      float degrees = pendulum.GetCurrentPositionDeg() - pendulum.GetRestPosition() * pendulum.DegreesPerCount();
+      logSeconds[logCount] = ms / 1000.0f;
+      logDegrees[logCount] = degrees > 180.0f ? degrees - 360.0f : (degrees <= -180.0f ? degrees + 360.0f : degrees);
+      logCount++;
+    }
+    if (status == FREE_DECAY_DONE || status == FREE_DECAY_FAILED)
+    {
+      break;
+    }
+  }
+
+  freeDecayResult_t result;
+  bool ok = pendulum.GetFreeDecayResult(result);
+  printf("  %s after %.2f s\n", status == FREE_DECAY_DONE ? "done" : "not done", ms / 1000.0);
+  PrintResult("encoder edges", ok, result, &params);
+
+  FreeDecayEstimator replay;
+  replay.Reset(pendulum.RadiansPerCount());
+  for (uint32_t i = 0; i < logCount; i++)
+  {
+    replay.AddSample(logSeconds[i], logDegrees[i] * DEG_TO_RAD);
+  }
+  ok = replay.GetResult(result);
+  char logName[32];
+  snprintf(logName, sizeof(logName), "log, %d ms samples", Identify_Log_Ms);
+  PrintResult(logName, ok, result, &params);
+}
+
+/******************************************************//**
+ * @brief  Fits a log of "seconds degrees-from-rest" lines, as
+ * printed by firmware.ino with Identify_Free_Swing set. Commas are
+ * read as spaces and lines that do not start with two numbers, such
+ * as the result lines, are skipped.
+ * @param  path Log file
+ * @retval 0 if the fit returned a result, else 1
+ **********************************************************/
+static int IdentifyLog(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  if (file == NULL)
+  {
+    printf("Cannot open %s\n", path);
+    return 1;
+  }
+
+  FreeDecayEstimator estimator;
+  estimator.Reset(pendulum_t::RadiansPerCount());
+  char line[128];
+  uint32_t samples = 0;
+  while (fgets(line, sizeof(line), file) != NULL)
+  {
+    for (char *c = line; *c != '\0'; c++)
+    {
+      *c = *c == ',' ? ' ' : *c;
+    }
+    float seconds;
+    float degrees;
+    if (sscanf(line, "%f %f", &seconds, &degrees) == 2)
+    {
+      estimator.AddSample(seconds, degrees * DEG_TO_RAD);
+      samples++;
+    }
+  }
+  fclose(file);
+
+  printf("%s: %lu samples, %.3f deg per count\n", path, (unsigned long)samples, pendulum_t::DegreesPerCount());
+  freeDecayResult_t result;
+  bool ok = estimator.GetResult(result);
+  PrintResult("log", ok, result, NULL);
+  return ok ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc > 1)
+  {
+    return IdentifyLog(argv[1]);
+  }
+
+  simulator.Begin();
+  model.Begin(1);
+  model.AttachToSimulator(&simulator);
+  plant.Begin(&simulator, &model);
+  pendulum.Begin();
+
+  printf("Free decay identification, fit from %d deg until the swing peaks below %d deg or %d half swings\n",
+         Pendulum_Free_Decay_Start_Deg, Pendulum_Free_Decay_End_Deg, Pendulum_Free_Decay_Max_Half_Cycles);
+  Identify("30 cm rig", Plant_Pendulum_Length_M, Plant_Damping_Per_S);
+  Identify("20 cm rig, stiff pivot", 0.20, 0.4);
+
+  plant.End();
+  model.End();
+  simulator.End();
+  return 0;
+}
@@ -0,0 +1,108 @@
+/******************************************************//**
+ * @file    simRest.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Rest position calibration on the cart-pendulum plant:
+ *          the encoder starts counting with the pendulum held away
+ *          from hanging, Pendulum::CalibrateRest learns where it
+ *          comes to rest, and the angle from upright is checked
+ *          against the plant with and without the calibration
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "cartPendulumPlant.h"
+#include "pendulum.h"
+#include <stdio.h>
+
+/// Pivot damping of the rig, higher than the default so a release settles within the timeout
+#define Rest_Damping_Per_S      (1.0)
+
+/// Tilt from upright the calibrated angle is checked at
+#define Rest_Check_Tilt_Deg     (3.0)
+
+static HostSimulator simulator;
+static L6474Model model;
+static CartPendulumPlant plant;
+static Pendulum<360, DECODE_4X> pendulum(TIMESTAMP_TIMER2);
+
+/******************************************************//**
+ * @brief  Difference between the Pendulum angle from upright and
+ * the plant one with the pendulum placed at a tilt from upright
+ * @param  None
+ * @retval error in degrees
+ **********************************************************/
+static double UprightError()
+{
+  plant.SetPendulum(PI + Rest_Check_Tilt_Deg * DEG_TO_RAD, 0.0);
+  return pendulum.GetAngleFromUprightDeg() - plant.GetAngleFromUpright() * RAD_TO_DEG;
+}
+
+/******************************************************//**
+ * @brief  Starts the encoder count with the pendulum held at an
+ * angle from hanging, releases it and calibrates the rest position.
+ * Both the encoder and the plant quantise to a count, so the angle
+ * from upright is expected within a count of the plant.
+ * @param  name Scenario name
+ * @param  heldDeg Angle from hanging the encoder starts counting at
+ * @param  timeoutMs Time CalibrateRest waits for the pendulum to settle
+ * @param  expectSettled true if the pendulum should settle within the timeout
+ * @retval None
+ **********************************************************/
+static void RestScenario(const char *name, double heldDeg, uint16_t timeoutMs, bool expectSettled)
+{
+  uint16_t counts = pendulum.CountsPerRotation();
+  plant.SetPendulum(heldDeg * DEG_TO_RAD, 0.0);
+  pendulum.SetHome();
+
+  unsigned long start = millis();
+  bool settled = pendulum.CalibrateRest(timeoutMs);
+  unsigned long elapsed = millis() - start;
+  int16_t rest = pendulum.GetRestPosition();
+
+  /* The rest position is where hanging falls in counts from the held angle */
+  int32_t expected = -(int32_t)floor(heldDeg * counts / 360.0) % counts;
+  expected = expected < 0 ? expected + counts : expected;
+
+  double calibratedError = UprightError();
+  pendulum.SetRestPosition(0);
+  double homeError = UprightError();
+  pendulum.SetRestPosition(rest);
+
+  bool ok = expectSettled ? (settled && abs(rest - expected) <= 1 && fabs(calibratedError) < 1.5 * pendulum.DegreesPerCount()) :
+                            (!settled && rest == 0);
+  printf("  %-22s %-7s %5.2f s  rest %7.2f deg (expected %7.2f)  upright error %8.2f deg home, %5.2f deg rest  %s\n",
+         name, settled ? "settled" : "timeout", elapsed / 1000.0, rest * pendulum.DegreesPerCount(),
+         expected * pendulum.DegreesPerCount(), homeError, calibratedError, ok ? "ok" : "FAIL");
+}
+
+int main()
+{
+  simulator.Begin();
+  model.Begin(1);
+  model.AttachToSimulator(&simulator);
+
+  plantParams_t params = plant.GetParams();
+  params.damping = Rest_Damping_Per_S;
+  plant.SetParams(params);
+  plant.Begin(&simulator, &model);
+  pendulum.Begin();
+
+  printf("Rest calibration: %d samples %d ms apart, spread %d deg, damping %.1f/s, checked %.0f deg from upright\n",
+         Pendulum_Rest_Samples, Pendulum_Rest_Interval_Ms, Pendulum_Rest_Spread_Deg, Rest_Damping_Per_S,
+         Rest_Check_Tilt_Deg);
+  RestScenario("started hanging", 0.0, Pendulum_Rest_Timeout_Ms, true);
+  RestScenario("started 0.8 deg off", 0.8, Pendulum_Rest_Timeout_Ms, true);
+  RestScenario("started 40 deg off", 40.0, Pendulum_Rest_Timeout_Ms, true);
+  RestScenario("started -150 deg off", -150.0, 20000, true);
+  RestScenario("40 deg, 2 s timeout", 40.0, 2000, false);
+
+  model.End();
+  plant.End();
+  simulator.End();
+  return 0;
+}
@@ -0,0 +1,227 @@
+/******************************************************//**
+ * @file    simTiming.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Faster-than-real-time scenarios for the timing
+ *          sensitive firmware paths: encoder speed estimation and
+ *          timeout (QuadratureEncoder::CheckSpeedTimeout) and the
+ *          step clock (L6474::StepClockHandler)
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "hostSimulator.h"
+#include "stepperMotor.h"
+#include "pendulum.h"
+#include <stdio.h>
+
+/// Constant speed quadrature source
+typedef struct {
+  uint32_t pulsesPerSecond;   //Counts per second, four edges per count
+  int8_t direction;           //+1 CCW, -1 CW, 0 stopped
+  uint8_t phase;              //BA levels 11, 01, 00, 10 while turning CCW
+  uint64_t lastEdgeTime;      //Virtual time of the most recent edge
+} spinner_t;
+
+static HostSimulator simulator;
+static StepperMotor stepperMotor(1.8f, STEP_QUARTER);
+static Pendulum<360> pendulum;
+static QuadratureEncoder *encoder;
+static spinner_t spinner;
+
+/******************************************************//**
+ * @brief  Event handler producing one quadrature edge and
+ * scheduling the next one while the spinner is moving
+ * @param  context spinner_t to advance
+ * @retval None
+ **********************************************************/
+static void SpinnerEdge(void *context)
+{
+  spinner_t *source = (spinner_t *)context;
+  if (source->direction == 0 || source->pulsesPerSecond == 0)
+  {
+    return;
+  }
+
+  source->phase = (source->phase + source->direction) & 0x03;
+  HostSetPinLevel(Quadrature_Pendulum_B_Pin, (source->phase == 0 || source->phase == 3) ? HIGH : LOW);
+  HostSetPinLevel(Quadrature_Pendulum_A_Pin, (source->phase == 0 || source->phase == 1) ? HIGH : LOW);
+  source->lastEdgeTime = simulator.GetTime();
+  simulator.ScheduleIn(Sim_Ticks_Per_Second / (4UL * source->pulsesPerSecond), SpinnerEdge, source);
+}
+
+/******************************************************//**
+ * @brief  Starts or changes the spinner speed and direction
+ * @param  pulsesPerSecond speed in counts per second
+ * @param  direction +1 CCW, -1 CW, 0 to stop
+ * @retval None
+ **********************************************************/
+static void SetSpinner(uint32_t pulsesPerSecond, int8_t direction)
+{
+  bool wasStopped = spinner.direction == 0;
+  spinner.pulsesPerSecond = pulsesPerSecond;
+  spinner.direction = direction;
+  if (wasStopped && direction != 0)
+  {
+    simulator.ScheduleIn(0, SpinnerEdge, &spinner);
+  }
+}
+
+/******************************************************//**
+ * @brief  Spins the encoder at a constant speed, then stops it
+ * and reports the speed estimate and how long the timeout takes
+ * to bring the reported velocity back to zero.
+ * @param  pulsesPerSecond true speed in counts per second
+ * @retval None
+ **********************************************************/
+static void EncoderScenario(uint32_t pulsesPerSecond)
+{
+  double sum = 0.0;
+  int32_t minimum = INT32_MAX;
+  int32_t maximum = INT32_MIN;
+  uint32_t samples = 0;
+
+  SetSpinner(pulsesPerSecond, 1);
+  simulator.RunFor(Sim_Ticks_Per_Second);
+  for (uint16_t i = 0; i < 1000; i++)
+  {
+    simulator.RunFor(Sim_Ticks_Per_Ms);
+    int32_t velocity = encoder->GetCurrentVelocity();
+    sum += velocity;
+    minimum = velocity < minimum ? velocity : minimum;
+    maximum = velocity > maximum ? velocity : maximum;
+    samples++;
+  }
+
+  SetSpinner(0, 0);
+  uint64_t stopTime = spinner.lastEdgeTime;
+  while (encoder->GetCurrentVelocity() != 0 && simulator.GetTime() - stopTime < 10ULL * Sim_Ticks_Per_Second)
+  {
+    simulator.RunFor(Sim_Ticks_Per_Us * 100);
+  }
+
+  printf("  %6lu pps: mean %8.1f  min %6ld  max %6ld  zero after %8.2f ms\n",
+         (unsigned long)pulsesPerSecond, sum / samples, (long)minimum, (long)maximum,
+         (double)(simulator.GetTime() - stopTime) / Sim_Ticks_Per_Ms);
+  simulator.RunFor(100UL * Sim_Ticks_Per_Ms);
+}
+
+/******************************************************//**
+ * @brief  Runs a move and checks one step clock interrupt was
+ * taken for each commanded step
+ * @param  degrees relative move in degrees
+ * @retval None
+ **********************************************************/
+static void StepperScenario(float degrees)
+{
+  uint32_t commanded = (uint32_t)(fabs(degrees) / (1.8f / STEP_QUARTER));
+  uint64_t start = simulator.GetTime();
+
+  HostResetInterruptCounts();
+  stepperMotor.MoveDeg(degrees);
+  while (stepperMotor.GetCurrentSpeedDeg() > 0.0f && simulator.GetTime() - start < 60ULL * Sim_Ticks_Per_Second)
+  {
+    simulator.RunFor(Sim_Ticks_Per_Ms);
+    if (L6474::GetInstancePtr()->GetShieldState(0) == INACTIVE)
+    {
+      break;
+    }
+  }
+
+  printf("  move %7.1f deg: %6lu steps commanded, %6lu step interrupts, %8.2f ms\n",
+         degrees, (unsigned long)commanded, (unsigned long)HostGetInterruptCount(HOST_VECT_TIMER1_OVF),
+         (double)(simulator.GetTime() - start) / Sim_Ticks_Per_Ms);
+}
+
+/******************************************************//**
+ * @brief  One virtual minute of the sketch: the cart goes back
+ * and forth every two seconds while the pendulum swings and the
+ * main loop polls it every millisecond.
+ * @param  None
+ * @retval None
+ **********************************************************/
+static void MinuteScenario()
+{
+  uint64_t wallStart = HostWallClockNanos();
+  uint64_t start = simulator.GetTime();
+  volatile float sink = 0.0f;
+
+  HostResetInterruptCounts();
+  for (uint16_t second = 0; second < 60; second++)
+  {
+    if (second % 2 == 0)
+    {
+      stepperMotor.GoToDeg(second % 4 == 0 ? 60.0f : -60.0f);
+    }
+    SetSpinner(40 + 20 * (second % 5), second % 2 ? -1 : 1);
+    for (uint16_t ms = 0; ms < 1000; ms++)
+    {
+      sink = pendulum.GetCurrentPositionRad() + pendulum.GetCurrentVelocityRad();
+      delay(1);
+    }
+  }
+  SetSpinner(0, 0);
+  (void)sink;
+
+  double wallMs = (double)(HostWallClockNanos() - wallStart) / 1.0e6;
+  double virtualMs = (double)(simulator.GetTime() - start) / Sim_Ticks_Per_Ms;
+  printf("  %.0f ms virtual in %.1f ms wall (%.0fx real time)\n", virtualMs, wallMs, virtualMs / wallMs);
+  printf("  PCINT1 %lu  TIMER2_COMPA %lu  TIMER1_OVF %lu  events %lu\n",
+         (unsigned long)HostGetInterruptCount(HOST_VECT_PCINT1),
+         (unsigned long)HostGetInterruptCount(HOST_VECT_TIMER2_COMPA),
+         (unsigned long)HostGetInterruptCount(HOST_VECT_TIMER1_OVF),
+         (unsigned long)simulator.GetEventCount());
+}
+
+int main()
+{
+  simulator.Begin();
+  stepperMotor.Begin();
+  pendulum.Begin();
+  encoder = QuadratureEncoder::GetInstancePtr();
+
+  printf("Encoder speed estimate and timeout (TIMER2_COMPA every %.3f ms)\n",
+         (double)simulator.GetTimerPeriod(SIM_TIMER_2_COMPA) / Sim_Ticks_Per_Ms);
+  const uint32_t speeds[] = {5, 20, 60, 125, 135, 400, 2000, 6000};
+  for (uint8_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++)
+  {
+    EncoderScenario(speeds[i]);
+  }
+
+  printf("Encoder speed estimate with Timer 2 timestamps (0.5 us)\n");
+  encoder->Begin(360, DECODE_1X, TIMESTAMP_TIMER2);
+  for (uint8_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++)
+  {
+    EncoderScenario(speeds[i]);
+  }
+
+  /* Sample rates of a control loop, where pulse timing runs up to a few counts per window */
+  encoder->Begin<500>(360);
+  printf("Encoder speed estimate with 500 Hz samples (pulse counting above %u pps)\n", encoder->GetFastCalcThreshold());
+  for (uint8_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++)
+  {
+    EncoderScenario(speeds[i]);
+  }
+  encoder->Begin<1000>(360);
+  printf("Encoder speed estimate with 1 kHz samples (pulse counting above %u pps)\n", encoder->GetFastCalcThreshold());
+  for (uint8_t i = 0; i < sizeof(speeds) / sizeof(speeds[0]); i++)
+  {
+    EncoderScenario(speeds[i]);
+  }
+  encoder->Begin(360);
+
+  printf("Step clock\n");
+  StepperScenario(90.0f);
+  StepperScenario(-360.0f);
+  StepperScenario(3600.0f);
+
+  printf("One minute of operation\n");
+  MinuteScenario();
+
+  simulator.End();
+  return 0;
+}
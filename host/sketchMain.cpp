@@ -0,0 +1,34 @@
+/******************************************************//**
+ * @file    sketchMain.cpp
+ * @version V1.0
+ * @date    October 16, 2026
+ * @brief   Runs firmware.ino on the host against the wall clock
+ * @author  Matthew R. Miller
+ *
+ * This file is free software; you can redistribute it and/or modify
+ * it under the terms of either the GNU General Public License version 2
+ * or the GNU Lesser General Public License version 2.1, both as
+ * published by the Free Software Foundation.
+ **********************************************************/
+
+#include "../firmware/firmware.ino"
+#include <stdio.h>
+
+/******************************************************//**
+ * @brief  Calls setup() once and loop() the requested number
+ * of times, as the Arduino core main() would.
+ * @param  argv[1] Number of loop() iterations (default 100)
+ * @retval 0
+ **********************************************************/
+int main(int argc, char **argv)
+{
+  unsigned long iterations = argc > 1 ? strtoul(argv[1], NULL, 10) : 100;
+
+  setup();
+  for (unsigned long i = 0; i < iterations; i++)
+  {
+    loop();
+  }
+  Serial.end();
+  return 0;
+}